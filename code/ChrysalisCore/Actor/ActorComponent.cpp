@@ -89,6 +89,9 @@ void CActorComponent::Initialize()
 	// the player target.
 	m_pAwareness = m_pEntity->GetOrCreateComponent<CEntityAwarenessComponent>();
 
+	// Other actors need to be aware of us too.
+	CAwarenessSpatialIndex::Get().Add(GetEntityId());
+
 	// Manage our snaplocks.
 	m_pSnaplockComponent = m_pEntity->GetOrCreateComponent<CSnaplockComponent>();
 
@@ -608,7 +611,7 @@ void CActorComponent::OnActionItemDrop()
 
 		if (auto pInteractor = pTargetEntity->GetComponent<CEntityInteractionComponent>())
 		{
-			if (auto pInteraction = pInteractor->GetInteraction("interaction_drop").lock())
+			if (auto pInteraction = pInteractor->GetInteraction(CEntityInteractionComponent::GetVerbId("interaction_drop")).lock())
 			{
 				pInteraction->OnInteractionStart(*this);
 			}
@@ -629,7 +632,7 @@ void CActorComponent::OnActionItemToss()
 
 		if (auto pInteractor = pTargetEntity->GetComponent<CEntityInteractionComponent>())
 		{
-			if (auto pInteraction = pInteractor->GetInteraction("interaction_toss").lock())
+			if (auto pInteraction = pInteractor->GetInteraction(CEntityInteractionComponent::GetVerbId("interaction_toss")).lock())
 			{
 				pInteraction->OnInteractionStart(*this);
 			}
@@ -671,26 +674,6 @@ void CActorComponent::OnActionItemToss()
 //}
 
 
-/** Super dirty and slow way to locate a spell from the registry. */
-entt::entity GetSpellByName(entt::registry* registry, const char* spellName)
-{
-	auto view = registry->view<ECS::Name>();
-
-	for (auto entity : view)
-	{
-		auto& name = view.get<ECS::Name>(entity);
-
-		if (strcmp(name.name, spellName) == 0)
-		{
-			return entity;
-		}
-	}
-
-	// Failed to find it.
-	return entt::null;
-}
-
-
 /** Takes a reference to a spell and applies the needed fixups. */
 void RewireSpell(entt::registry& registry, entt::entity spellEntity, entt::entity sourceEntity, entt::entity targetEntity)
 {
@@ -712,18 +695,16 @@ void RewireSpell(entt::registry& registry, entt::entity spellEntity, entt::entit
 void CastSpellByName(const char* spellName, entt::entity sourceEntity, entt::entity targetEntity)
 {
 	auto actorRegistry = ECS::ecsSimulation.GetActorRegistry();
-	auto spellRegistry = ECS::ecsSimulation.GetSpellRegistry();
 
-	auto spellEntity = GetSpellByName(spellRegistry, spellName);
+	auto spellEntity = ECS::ecsSimulation.GetSpellByName(entt::hashed_string {spellName});
 	if (spellEntity != entt::null)
 	{
-		// Make use of the create feature to copy the spell prototype into the actor registry.
-		auto newEntity = actorRegistry->create<ECS::Name, ECS::Health, ECS::Damage, ECS::DamageOverTime, ECS::Heal, ECS::HealOverTime,
-			ECS::Qi, ECS::UtiliseQi, ECS::UtiliseQiOverTime, ECS::ReplenishQi, ECS::ReplenishQiOverTime,
-			ECS::Spell>(spellEntity, *spellRegistry);
+		// Create an instance of the spell prototype in the actor registry, copying only the components it owns.
+		auto newEntity = ECS::ecsSimulation.InstantiateSpell(spellEntity);
 
 		// Do fixups.
-		RewireSpell(*actorRegistry, newEntity, sourceEntity, targetEntity);
+		if (newEntity != entt::null)
+			RewireSpell(*actorRegistry, newEntity, sourceEntity, targetEntity);
 	}
 }
 
@@ -808,7 +789,7 @@ void CActorComponent::OnActionInspect()
 			m_interactionEntityId = results[0];
 			auto pInteractionEntity = gEnv->pEntitySystem->GetEntity(m_interactionEntityId);
 
-			if (auto pInteractor = pInteractionEntity->GetComponent<CEntityInteractionComponent>())
+			if (auto pInteractor = pInteractionEntity ? pInteractionEntity->GetComponent<CEntityInteractionComponent>() : nullptr)
 			{
 				// There's an interactor component, so this is an interactive entity.
 				auto verbs = pInteractor->GetVerbs();
@@ -854,7 +835,7 @@ void CActorComponent::OnActionInteractionStart()
 			//auto emoteAction = new CActorAnimationActionEmote(g_emoteMannequinParams.tagIDs.Awe);
 			//QueueAction(*emoteAction);
 
-			if (auto pInteractor = pInteractionEntity->GetComponent<CEntityInteractionComponent>())
+			if (auto pInteractor = pInteractionEntity ? pInteractionEntity->GetComponent<CEntityInteractionComponent>() : nullptr)
 			{
 				// There's an interactor component, so this is an interactive entity.
 				// #TODO: We should really only process an 'interact' verb - not simply the first entry.
@@ -1,6 +1,7 @@
 #include <StdAfx.h>
 
 #include "ActorControllerComponent.h"
+#include "ActorControllerManager.h"
 #include <CryCore/StaticInstanceList.h>
 #include "CrySchematyc/Env/Elements/EnvComponent.h"
 #include "CrySchematyc/Env/IEnvRegistrar.h"
@@ -58,6 +59,17 @@ void CActorControllerComponent::Initialize()
 
 	// Get it into a known state.
 	OnResetState();
+
+	// The controller manager updates us each frame.
+	CActorControllerManager::Get().Add(this);
+}
+
+
+CActorControllerComponent::~CActorControllerComponent()
+{
+	CActorControllerManager::Get().Remove(this);
+
+	MovementHSMRelease();
 }
 
 
@@ -75,13 +87,6 @@ void CActorControllerComponent::ProcessEvent(const SEntityEvent& event)
 			OnResetState();
 			break;
 
-		case EEntityEvent::Update:
-		{
-			SEntityUpdateContext* pCtx = (SEntityUpdateContext*)event.nParam[0];
-			Update(pCtx);
-		}
-		break;
-
 		case EEntityEvent::PrePhysicsUpdate:
 			PrePhysicsUpdate();
 			break;
@@ -89,19 +94,6 @@ void CActorControllerComponent::ProcessEvent(const SEntityEvent& event)
 }
 
 
-void CActorControllerComponent::Update(SEntityUpdateContext* pCtx)
-{
-	const float frameTime = pCtx->fFrameTime;
-
-	UpdateMovementRequest(frameTime);
-	UpdateLookDirectionRequest(frameTime);
-	UpdateAnimation(frameTime);
-
-	// Update the movement state machine.
-	MovementHSMUpdate(*pCtx);
-}
-
-
 void CActorControllerComponent::PrePhysicsUpdate()
 {
 	// TODO: HACK: BROKEN: This stuff was commented out in the character pre-physics. Some of it might belong here now.
@@ -198,7 +190,7 @@ void CActorControllerComponent::MovementHSMSerialize(TSerialize ser)
 }
 
 
-void CActorControllerComponent::MovementHSMUpdate(SEntityUpdateContext& ctx)
+void CActorControllerComponent::MovementHSMUpdate(float frameTime)
 {
 	//#ifdef STATE_DEBUG
 	//	const bool shouldDebug = (s_StateMachineDebugEntityID == GetEntityId ());
@@ -208,10 +200,10 @@ void CActorControllerComponent::MovementHSMUpdate(SEntityUpdateContext& ctx)
 	const bool shouldDebug = false;
 	//const bool shouldDebug = true;
 
-	StateMachineUpdateMovement(ctx.fFrameTime, shouldDebug);
+	StateMachineUpdateMovement(frameTime, shouldDebug);
 
 	// Pass the update into the movement state machine.
-	StateMachineHandleEventMovement(SStateEventUpdate(ctx.fFrameTime));
+	StateMachineHandleEventMovement(SStateEventUpdate(frameTime));
 }
 
 
@@ -293,45 +285,38 @@ const float CActorControllerComponent::GetLowerBodyRotation(TInputFlags movement
 }
 
 
-void CActorControllerComponent::UpdateMovementRequest(float frameTime)
+void CActorControllerComponent::GatherMovementInput(SActorMovementInput& input) const
 {
-	// Default is for them to not request movement.
-	m_movementRequest = ZERO;
-
-	// Don't handle input if we are in air.
-	if (!m_pCharacterControllerComponent->IsOnGround())
-	{
-		m_movingDuration = 0.0f;
-		return;
-	}
+	input.lookOrientation = m_lookOrientation;
+	input.yawAngularVelocity = m_yawAngularVelocity;
+	input.movingDuration = m_movingDuration;
+	input.isOnGround = m_pCharacterControllerComponent->IsOnGround();
+	input.hasPlayer = false;
+	input.isMovementRequested = false;
 
 	// If there's a player controlling us, we can query them for inputs and camera and apply that to our movement.
 	if (auto* pPlayer = m_pActorComponent->GetPlayer())
 	{
+		auto* pPlayerInput = pPlayer->GetPlayerInput();
+
+		input.hasPlayer = true;
+		input.isViewFirstPerson = pPlayer->IsViewFirstPerson();
+		input.mouseYawDelta = pPlayerInput->GetMouseYawDelta();
+		input.moveSpeed = GetMovementBaseSpeed(pPlayerInput->GetMovementDirectionFlags());
+		input.isMovementRequested = pPlayerInput->IsMovementRequested();
+
 		/**
 		The request needs to take into account both the direction of the camera and the direction of
 		the movement i.e. left is alway left relative to the camera. TODO: What will it take to make this
 		use AddVelocity instead? The values don't seem to match with what I'd expect to input to it.
 		**/
-		auto* pPlayerInput = pPlayer->GetPlayerInput();
-		float moveSpeed = GetMovementBaseSpeed(pPlayerInput->GetMovementDirectionFlags());
-		if ((moveSpeed > FLT_EPSILON) && (pPlayerInput->IsMovementRequested()))
-		{
-			m_movingDuration += frameTime;
-			m_movementRequest = pPlayerInput->GetMovement(pPlayer->GetCamera()->GetRotation()) * moveSpeed;
-			SetVelocity(m_movementRequest);
-		}
-		else
-		{
-			// I'm forcing the velocity to zero if we're not actively controlling the character. This naive
-			// approach is probably wrong, but it works for now. 
-			SetVelocity(ZERO);
-		}
+		if (input.isOnGround && (input.moveSpeed > FLT_EPSILON) && input.isMovementRequested)
+			input.movement = pPlayerInput->GetMovement(pPlayer->GetCamera()->GetRotation());
 	}
 }
 
 
-void CActorControllerComponent::UpdateLookDirectionRequest(float frameTime)
+void CActorControllerComponent::StepMovement(const SActorMovementInput& input, SActorMovementOutput& output, float frameTime)
 {
 	// The angular velocity maximum (Full rotations / second).
 	const float angularVelocityMax = g_PI2 * 1.5f;
@@ -339,55 +324,89 @@ void CActorControllerComponent::UpdateLookDirectionRequest(float frameTime)
 	// The catchup speed (Full rotations / second).
 	const float catchupSpeed = g_PI2 * 1.2f;
 
-	// If there's a player controlling us, we can query them for inputs and camera and apply that to our rotation.
-	if (auto* pPlayer = m_pActorComponent->GetPlayer())
+	// Default is for them to not request movement.
+	output.movementRequest = ZERO;
+	output.movingDuration = input.movingDuration;
+	output.lookOrientation = input.lookOrientation;
+	output.yawAngularVelocity = input.yawAngularVelocity;
+	output.shouldSetVelocity = false;
+
+	// Don't handle input if we are in air.
+	if (!input.isOnGround)
 	{
-		auto* pPlayerInput = pPlayer->GetPlayerInput();
+		output.movingDuration = 0.0f;
+	}
+	else if (input.hasPlayer)
+	{
+		if ((input.moveSpeed > FLT_EPSILON) && (input.isMovementRequested))
+		{
+			output.movingDuration += frameTime;
+			output.movementRequest = input.movement * input.moveSpeed;
+		}
+
+		// I'm forcing the velocity to zero if we're not actively controlling the character. This naive
+		// approach is probably wrong, but it works for now. 
+		output.shouldSetVelocity = true;
+	}
+
+	if (!input.hasPlayer)
+		return;
+
+	// Only allow the character to rotate in first person, and third person if they are moving.
+	if ((input.isViewFirstPerson) || (!input.isViewFirstPerson && output.movementRequest.len() > FLT_EPSILON))
+	{
+		Ang3 facingDir;
+		if (input.isViewFirstPerson)
+			facingDir = CCamera::CreateAnglesYPR(Matrix33(input.lookOrientation));
+		else
+			facingDir = CCamera::CreateAnglesYPR(output.movementRequest.GetNormalizedFast());
+
+		// Use their last orientation as their present direction.
+		// NOTE: I tried it with GetEntity()->GetWorldTM() but that caused crazy jitter issues.
+		Ang3 ypr = CCamera::CreateAnglesYPR(Matrix33(input.lookOrientation));
+
+		// We add in some extra rotation to 'catch up' to the direction they are being moved. This will perform a gradual
+		// turn on the actor over several frames.
+		float rotationDelta {0.0f};
+		if (std::abs(facingDir.x - ypr.x) > g_PI)
+			rotationDelta = ypr.x - facingDir.x;
+		else
+			rotationDelta = facingDir.x - ypr.x;
 
-		// Only allow the character to rotate in first person, and third person if they are moving.
-		if ((pPlayer->IsViewFirstPerson()) || (!pPlayer->IsViewFirstPerson() && m_movementRequest.len() > FLT_EPSILON))
+		// Catchup allows us to step towards the goal direction in even steps using a set angular velocity.
+		float catchUp {0.0f};
+		if (std::abs(rotationDelta) > FLT_EPSILON)
 		{
-			Ang3 facingDir;
-			if (pPlayer->IsViewFirstPerson())
-				facingDir = CCamera::CreateAnglesYPR(Matrix33(m_lookOrientation));
+			if (rotationDelta > 0.0f)
+				catchUp = std::min(rotationDelta, catchupSpeed * frameTime);
 			else
-				facingDir = CCamera::CreateAnglesYPR(m_movementRequest.GetNormalizedFast());
+				catchUp = std::max(rotationDelta, -catchupSpeed * frameTime);
+		}
 
-			// Use their last orientation as their present direction.
-			// NOTE: I tried it with GetEntity()->GetWorldTM() but that caused crazy jitter issues.
-			Ang3 ypr = CCamera::CreateAnglesYPR(Matrix33(m_lookOrientation));
+		// Update angular velocity metrics.
+		output.yawAngularVelocity = CLAMP(input.mouseYawDelta + catchUp, -angularVelocityMax * frameTime, angularVelocityMax * frameTime);
 
-			// We add in some extra rotation to 'catch up' to the direction they are being moved. This will perform a gradual
-			// turn on the actor over several frames.
-			float rotationDelta {0.0f};
-			if (std::abs(facingDir.x - ypr.x) > g_PI)
-				rotationDelta = ypr.x - facingDir.x;
-			else
-				rotationDelta = facingDir.x - ypr.x;
+		// Yaw.
+		ypr.x += output.yawAngularVelocity;
 
-			// Catchup allows us to step towards the goal direction in even steps using a set angular velocity.
-			float catchUp {0.0f};
-			if (std::abs(rotationDelta) > FLT_EPSILON)
-			{
-				if (rotationDelta > 0.0f)
-					catchUp = std::min(rotationDelta, catchupSpeed * frameTime);
-				else
-					catchUp = std::max(rotationDelta, -catchupSpeed * frameTime);
-			}
+		// Roll (zero it).
+		ypr.z = 0;
 
-			// Update angular velocity metrics.
-			m_yawAngularVelocity = CLAMP(pPlayerInput->GetMouseYawDelta() + catchUp, -angularVelocityMax * frameTime, angularVelocityMax * frameTime);
+		// Update the preferred direction we face.
+		output.lookOrientation = Quat(CCamera::CreateOrientationYPR(ypr));
+	}
+}
 
-			// Yaw.
-			ypr.x += m_yawAngularVelocity;
 
-			// Roll (zero it).
-			ypr.z = 0;
+void CActorControllerComponent::ApplyMovementOutput(const SActorMovementOutput& output)
+{
+	m_movementRequest = output.movementRequest;
+	m_movingDuration = output.movingDuration;
+	m_lookOrientation = output.lookOrientation;
+	m_yawAngularVelocity = output.yawAngularVelocity;
 
-			// Update the preferred direction we face.
-			m_lookOrientation = Quat(CCamera::CreateOrientationYPR(ypr));
-		}
-	}
+	if (output.shouldSetVelocity)
+		SetVelocity(m_movementRequest);
 }
 
 
@@ -61,6 +61,63 @@ struct SActorPhysics
 };
 
 
+/** Everything needed to step an actor's movement and look direction for a frame, gathered before stepping. */
+
+struct SActorMovementInput
+{
+	/** The direction the actor should be facing (pelvis) at the start of the frame. */
+	Quat lookOrientation {IDENTITY};
+
+	/** The requested movement, relative to the camera. Only valid if movement was requested. */
+	Vec3 movement {ZERO};
+
+	/** The base speed for the requested movement direction. */
+	float moveSpeed {0.0f};
+
+	/** The mouse yaw since the last frame. */
+	float mouseYawDelta {0.0f};
+
+	/**	The yaw angular velocity at the start of the frame. **/
+	float yawAngularVelocity {0.0f};
+
+	/** The continuous amount of time the actor has been receiving movement requests (seconds). */
+	float movingDuration {0.0f};
+
+	/** true if a player is controlling this actor. */
+	bool hasPlayer {false};
+
+	/** true if the actor is on the ground. */
+	bool isOnGround {false};
+
+	/** true if the player is requesting movement. */
+	bool isMovementRequested {false};
+
+	/** true if the player is viewing in first person. */
+	bool isViewFirstPerson {false};
+};
+
+
+/** The results of stepping an actor's movement and look direction for a frame, ready to write back. */
+
+struct SActorMovementOutput
+{
+	/** The direction the actor should be facing (pelvis). */
+	Quat lookOrientation {IDENTITY};
+
+	/** The direction and distance the player has requested this actor to move. */
+	Vec3 movementRequest {ZERO};
+
+	/**	The yaw angular velocity. **/
+	float yawAngularVelocity {0.0f};
+
+	/** The continuous amount of time the actor has been receiving movement requests (seconds). */
+	float movingDuration {0.0f};
+
+	/** true if the movement request should be set as the velocity. */
+	bool shouldSetVelocity {false};
+};
+
+
 /** Keeps track of the stance the actor is in. */
 
 struct CActorStance
@@ -84,6 +141,8 @@ private:
 class CActorControllerComponent
 	: public IEntityComponent
 {
+	friend class CActorControllerManager;
+
 protected:
 	// Declaration of the state machine that controls actor movement.
 	DECLARE_STATE_MACHINE(CActorControllerComponent, Movement);
@@ -91,11 +150,9 @@ protected:
 	// IEntityComponent
 	void Initialize() override;
 	void ProcessEvent(const SEntityEvent& event) override;
-	Cry::Entity::EventFlags GetEventMask() const override { return EEntityEvent::Update | EEntityEvent::PrePhysicsUpdate; }
+	Cry::Entity::EventFlags GetEventMask() const override { return EEntityEvent::PrePhysicsUpdate; }
 	// ~IEntityComponent
 
-	virtual void Update(SEntityUpdateContext* pCtx);
-
 	/** Pre physics update. */
 	virtual void PrePhysicsUpdate();
 
@@ -110,7 +167,7 @@ protected:
 	virtual void SelectMovementHierarchy();
 
 	/** Update the HSM. */
-	virtual void MovementHSMUpdate(SEntityUpdateContext& ctx);
+	virtual void MovementHSMUpdate(float frameTime);
 
 	/** Serialize the HSM. */
 	virtual void MovementHSMSerialize(TSerialize ser);
@@ -121,13 +178,38 @@ protected:
 	/** Release the HSM. */
 	virtual void MovementHSMRelease();
 
-	virtual void UpdateMovementRequest(float frameTime);
-	virtual void UpdateLookDirectionRequest(float frameTime);
+	/**
+	Gathers the inputs needed to step this actor's movement and look direction. The controller manager does this for
+	every actor before stepping any of them.
+
+	\param [out]	input The gathered inputs.
+	**/
+	void GatherMovementInput(SActorMovementInput& input) const;
+
+
+	/**
+	Steps an actor's movement request and look direction for a frame. This only works on the input and output, so it is
+	safe to step different actors at the same time.
+
+	\param 		input	  The gathered inputs.
+	\param [out]	output	  The results.
+	\param 		frameTime The frame time.
+	**/
+	static void StepMovement(const SActorMovementInput& input, SActorMovementOutput& output, float frameTime);
+
+
+	/**
+	Writes the results of stepping back to this actor.
+
+	\param	output The results.
+	**/
+	void ApplyMovementOutput(const SActorMovementOutput& output);
+
 	virtual void UpdateAnimation(float frameTime);
 
 public:
 	CActorControllerComponent() {}
-	virtual ~CActorControllerComponent() { MovementHSMRelease(); }
+	virtual ~CActorControllerComponent();
 
 	static void ReflectType(Schematyc::CTypeDesc<CActorControllerComponent>& desc);
 
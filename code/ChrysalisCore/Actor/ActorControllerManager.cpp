@@ -0,0 +1,104 @@
+#include <StdAfx.h>
+
+#include "ActorControllerManager.h"
+#include "Console/CVars.h"
+
+
+namespace Chrysalis
+{
+CActorControllerManager& CActorControllerManager::Get()
+{
+	static CActorControllerManager manager;
+
+	return manager;
+}
+
+
+void CActorControllerManager::Add(CActorControllerComponent* pController)
+{
+	stl::push_back_unique(m_controllers, pController);
+}
+
+
+void CActorControllerManager::Remove(CActorControllerComponent* pController)
+{
+	stl::find_and_erase(m_controllers, pController);
+
+	// It might be removed while the controllers are being updated.
+	for (auto& pUpdating : m_updating)
+	{
+		if (pUpdating == pController)
+			pUpdating = nullptr;
+	}
+}
+
+
+void CActorControllerManager::StepMovement(size_t first, size_t count, float frameTime)
+{
+	for (size_t i = first; i < first + count; ++i)
+		CActorControllerComponent::StepMovement(m_inputs[i], m_outputs[i], frameTime);
+}
+
+
+void CActorControllerManager::Update(float frameTime)
+{
+	// Hidden entities don't receive update events, so we leave them out too.
+	m_updating.clear();
+	for (auto pController : m_controllers)
+	{
+		if (!pController->GetEntity()->IsHidden())
+			m_updating.push_back(pController);
+	}
+
+	const size_t count = m_updating.size();
+	m_inputs.resize(count);
+	m_outputs.resize(count);
+
+	// Gather. The player input and physics are only safe to query from this thread.
+	for (size_t i = 0; i < count; ++i)
+		m_updating[i]->GatherMovementInput(m_inputs[i]);
+
+	// Step. Each actor only reads it's own input and writes it's own output, so runs of actors are independent.
+	const size_t jobCount = count / minActorsPerJob;
+	if (g_cvars.m_actorControllerParallel && gEnv->pJobManager && (jobCount > 1))
+	{
+		while (m_jobStates.size() + 1 < jobCount)
+			m_jobStates.emplace_back(std::make_unique<JobManager::SJobState>());
+
+		// Hand off all but the last run to the job manager and step the last one on this thread while we wait.
+		const size_t actorsPerJob = count / jobCount;
+		for (size_t job = 0; job + 1 < jobCount; ++job)
+		{
+			gEnv->pJobManager->AddLambdaJob("CActorControllerManager::StepMovement", [this, job, actorsPerJob, frameTime]()
+			{
+				StepMovement(job * actorsPerJob, actorsPerJob, frameTime);
+			}, JobManager::eRegularPriority, m_jobStates[job].get());
+		}
+
+		// The last run also picks up the remainder.
+		const size_t lastFirst = (jobCount - 1) * actorsPerJob;
+		StepMovement(lastFirst, count - lastFirst, frameTime);
+
+		for (size_t job = 0; job + 1 < jobCount; ++job)
+			gEnv->pJobManager->WaitForJob(*m_jobStates[job]);
+	}
+	else
+	{
+		StepMovement(0, count, frameTime);
+	}
+
+	// Write back, then update the state machines.
+	m_lastFrameUpdates = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		// It could have been removed during an earlier actor's update.
+		if (auto pController = m_updating[i])
+		{
+			pController->ApplyMovementOutput(m_outputs[i]);
+			pController->UpdateAnimation(frameTime);
+			pController->MovementHSMUpdate(frameTime);
+			++m_lastFrameUpdates;
+		}
+	}
+}
+}
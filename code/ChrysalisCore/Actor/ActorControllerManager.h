@@ -0,0 +1,85 @@
+#pragma once
+
+#include <CryThreading/IJobManager.h>
+#include "Actor/ActorControllerComponent.h"
+
+
+namespace Chrysalis
+{
+/**
+Updates every actor controller once per frame, in place of each of them handling their own entity update event.
+
+The update is done in three passes. First the inputs for every actor are gathered into one array. Then the movement
+and look direction for each actor are stepped, working only on the arrays, which lets us split the actors into runs
+and step them in parallel on the job manager. Lastly the results are written back to each actor, and their animation
+and movement state machines are updated. The state machines drive physics and Mannequin, which are not safe to call
+from more than one thread, so they are stepped in a tight loop on this thread.
+**/
+
+class CActorControllerManager
+{
+public:
+	static CActorControllerManager& Get();
+
+	CActorControllerManager() = default;
+	~CActorControllerManager() = default;
+
+	CActorControllerManager(const CActorControllerManager&) = delete;
+	CActorControllerManager& operator=(const CActorControllerManager&) = delete;
+
+
+	/**
+	Adds a controller to the manager. It will update during the next frame. Adding a controller more than once is
+	harmless.
+
+	\param	pController The controller.
+	**/
+	void Add(CActorControllerComponent* pController);
+
+
+	/**
+	Removes a controller from the manager. Controllers must call this before they are destroyed.
+
+	\param	pController The controller.
+	**/
+	void Remove(CActorControllerComponent* pController);
+
+
+	/**
+	Updates every controller. This should be called once per frame, after the entities update, and only on frames
+	where the entity system updates entities i.e. not while editing or paused.
+
+	\param	frameTime The frame time.
+	**/
+	void Update(float frameTime);
+
+
+	/** Number of controllers updated during the last frame. */
+	uint32 GetLastFrameUpdates() const { return m_lastFrameUpdates; }
+
+private:
+	/** The fewest actors worth handing to the job manager as one run. */
+	static const size_t minActorsPerJob {64};
+
+	/** Steps the movement for a run of actors. */
+	void StepMovement(size_t first, size_t count, float frameTime);
+
+	/** The controllers we update. */
+	std::vector<CActorControllerComponent*> m_controllers;
+
+	/** The controllers being updated right now. Removed controllers are set to null. */
+	std::vector<CActorControllerComponent*> m_updating;
+
+	/** Gathered inputs, one for each controller being updated. */
+	std::vector<SActorMovementInput> m_inputs;
+
+	/** Stepped results, one for each controller being updated. */
+	std::vector<SActorMovementOutput> m_outputs;
+
+	/** Job states can't be copied or moved, so we keep one for each run handed to the job manager. */
+	std::vector<std::unique_ptr<JobManager::SJobState>> m_jobStates;
+
+	/** Number of controllers updated during the last frame. */
+	uint32 m_lastFrameUpdates {0};
+};
+}
@@ -5,6 +5,7 @@
 #include "CrySchematyc/Env/Elements/EnvComponent.h"
 #include "CrySchematyc/Env/IEnvRegistrar.h"
 #include <Cry3DEngine/IRenderNode.h>
+#include "Game/Cache/GameCache.h"
 
 
 // HACK: Am I seriously copying this code segment from CryDefaultEntities in order to get rid of the YASLI
@@ -75,6 +76,7 @@ static void RegisterActorAnimationComponent(Schematyc::IEnvRegistrar& registrar)
 CActorAnimationComponent::~CActorAnimationComponent()
 {
 	SAFE_RELEASE(m_pActionController);
+	ReleaseCachedResources();
 }
 
 
@@ -211,6 +213,88 @@ void CActorAnimationComponent::Update(SEntityUpdateContext* pCtx)
 }
 
 
+void CActorAnimationComponent::LoadFromDisk()
+{
+	// The files may have changed, so we let go of anything we loaded before.
+	ReleaseCachedResources();
+	CGameCache* pGameCache = CChrysalisCorePlugin::Get()->GetGameCache();
+
+	if (m_characterFile.value.size() > 0)
+	{
+		m_pCachedCharacter = pGameCache->AcquireCharacter(m_characterFile.value);
+		if (m_pCachedCharacter == nullptr)
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load character %s!", m_characterFile.value.c_str());
+			return;
+		}
+
+		m_characterFileHash = CryStringUtils::HashString(m_characterFile.value);
+
+		if (m_bGroundAlignment && m_pCachedCharacter != nullptr)
+		{
+			if (m_pPoseAligner == nullptr)
+			{
+				CryCreateClassInstance(CPoseAlignerC3::GetCID(), m_pPoseAligner);
+			}
+
+			m_pPoseAligner->Clear();
+		}
+		else
+		{
+			m_pPoseAligner.reset();
+		}
+	}
+	else
+	{
+		m_pCachedCharacter = nullptr;
+	}
+
+	if (m_defaultScopeSettings.m_controllerDefinitionPath.size() > 0 && m_databasePath.value.size() > 0)
+	{
+		// Load the Mannequin controller definition. This is owned by the animation database manager.
+		m_pControllerDefinition = pGameCache->AcquireControllerDefinition(m_defaultScopeSettings.m_controllerDefinitionPath);
+		if (m_pControllerDefinition == nullptr)
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load controller definition %s!", m_defaultScopeSettings.m_controllerDefinitionPath.c_str());
+			return;
+		}
+
+		m_controllerDefinitionFileHash = CryStringUtils::HashString(m_defaultScopeSettings.m_controllerDefinitionPath);
+
+		// Load the animation database.
+		m_pDatabase = pGameCache->AcquireAnimationDatabase(m_databasePath.value);
+		if (m_pDatabase == nullptr)
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load animation database %s!", m_databasePath.value.c_str());
+			return;
+		}
+
+		m_databaseFileHash = CryStringUtils::HashString(m_databasePath.value);
+	}
+}
+
+
+void CActorAnimationComponent::ReleaseCachedResources()
+{
+	// The cache is gone if we outlive the plugin during shutdown, and so is anything we would hand back to it.
+	if (CGameCache* pGameCache = CChrysalisCorePlugin::GetLiveGameCache())
+	{
+		if (m_characterFileHash)
+			pGameCache->ReleaseCharacter(m_characterFileHash);
+
+		if (m_databaseFileHash)
+			pGameCache->ReleaseAnimationDatabase(m_databaseFileHash);
+
+		if (m_controllerDefinitionFileHash)
+			pGameCache->ReleaseControllerDefinition(m_controllerDefinitionFileHash);
+	}
+
+	m_characterFileHash = 0;
+	m_databaseFileHash = 0;
+	m_controllerDefinitionFileHash = 0;
+}
+
+
 void CActorAnimationComponent::SetCharacterFile(const char* szPath, bool applyImmediately)
 {
 	m_characterFile = szPath;
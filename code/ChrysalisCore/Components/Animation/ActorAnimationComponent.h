@@ -9,6 +9,7 @@
 #include <CryGame/IGameFramework.h>
 #include <Animation/PoseAligner/PoseAligner.h>
 #include <Actor/Animation/ActorAnimation.h>
+#include <Utility/CryHash.h>
 
 
 namespace Chrysalis
@@ -249,60 +250,9 @@ public:
 	ICharacterInstance* GetCharacter() const { return m_pCachedCharacter; }
 
 
-	// Loads character and mannequin data from disk.
-	virtual void LoadFromDisk()
-	{
-		if (m_characterFile.value.size() > 0)
-		{
-			m_pCachedCharacter = gEnv->pCharacterManager->CreateInstance(m_characterFile.value);
-			if (m_pCachedCharacter == nullptr)
-			{
-				CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load character %s!", m_characterFile.value.c_str());
-				return;
-			}
-
-			if (m_bGroundAlignment && m_pCachedCharacter != nullptr)
-			{
-				if (m_pPoseAligner == nullptr)
-				{
-					CryCreateClassInstance(CPoseAlignerC3::GetCID(), m_pPoseAligner);
-				}
-
-				m_pPoseAligner->Clear();
-			}
-			else
-			{
-				m_pPoseAligner.reset();
-			}
-		}
-		else
-		{
-			m_pCachedCharacter = nullptr;
-		}
-
-		if (m_defaultScopeSettings.m_controllerDefinitionPath.size() > 0 && m_databasePath.value.size() > 0)
-		{
-			// Now start loading the Mannequin data.
-			IMannequin& mannequinInterface = gEnv->pGameFramework->GetMannequinInterface();
-			IAnimationDatabaseManager& animationDatabaseManager = mannequinInterface.GetAnimationDatabaseManager();
-
-			// Load the Mannequin controller definition. This is owned by the animation database manager.
-			m_pControllerDefinition = animationDatabaseManager.LoadControllerDef(m_defaultScopeSettings.m_controllerDefinitionPath);
-			if (m_pControllerDefinition == nullptr)
-			{
-				CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load controller definition %s!", m_defaultScopeSettings.m_controllerDefinitionPath.c_str());
-				return;
-			}
-
-			// Load the animation database.
-			m_pDatabase = animationDatabaseManager.Load(m_databasePath.value);
-			if (m_pDatabase == nullptr)
-			{
-				CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_ERROR, "Failed to load animation database %s!", m_databasePath.value.c_str());
-				return;
-			}
-		}
-	}
+	// Loads character and mannequin data from disk. These come from the game cache, so actors sharing a rig share the
+	// loaded data.
+	virtual void LoadFromDisk();
 
 
 	// Resets the actor and Mannequin.
@@ -399,6 +349,9 @@ public:
 protected:
 	virtual void Update(SEntityUpdateContext* pCtx);
 
+	/** Releases the character and Mannequin data we acquired from the game cache. */
+	void ReleaseCachedResources();
+
 	bool m_bAnimationDrivenMotion = true;
 
 	Schematyc::CharacterFileName m_characterFile;
@@ -418,6 +371,11 @@ protected:
 	const SControllerDef* m_pControllerDefinition {nullptr};
 	_smart_ptr<ICharacterInstance> m_pCachedCharacter {nullptr};
 
+	/** Hashes of the files we acquired from the game cache, so they can be released. Zero if nothing was acquired. */
+	CryHash m_characterFileHash {0};
+	CryHash m_databaseFileHash {0};
+	CryHash m_controllerDefinitionFileHash {0};
+
 	IAnimationPoseAlignerPtr m_pPoseAligner;
 	Vec3 m_prevForwardDir {ZERO};
 	float m_turnAngle {0.f};
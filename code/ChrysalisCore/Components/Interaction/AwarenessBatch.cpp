@@ -0,0 +1,366 @@
+#include <StdAfx.h>
+
+#include "AwarenessBatch.h"
+
+#if CRY_PLATFORM_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace Chrysalis
+{
+#if CRY_PLATFORM_SSE2
+static ILINE __m128 AbsLanes(__m128 value)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+
+/** Takes each lane from a where the mask is set, and from b where it isn't. */
+static ILINE __m128 SelectLanes(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+
+/** Adds the candidates for each lane set in the mask to the results. */
+static ILINE void AppendLanes(int mask, size_t first, AwarenessBuffer<uint32>& results)
+{
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		if (mask & (1 << lane))
+			results.push_back(static_cast<uint32>(first + lane));
+	}
+}
+#endif
+
+
+void CAwarenessBatch::Clear()
+{
+	m_count = 0;
+}
+
+
+void CAwarenessBatch::Add(const SAwarenessEntry& entry)
+{
+	// Grow a whole group at a time, so the tests never need to deal with a partial group at the end.
+	if (m_count == m_streams[0].size())
+	{
+		for (auto& stream : m_streams)
+			stream.resize(m_count + laneCount, 0.0f);
+	}
+
+	const Vec3 center = entry.worldBounds.GetCenter();
+	const Matrix33 rotation(entry.worldTM);
+	const Vec3 box = entry.worldTM.GetTranslation() + rotation * entry.localBounds.GetCenter();
+	const Vec3 extent = entry.localBounds.GetSize() * 0.5f;
+
+	const float values[eS_Count] =
+	{
+		center.x, center.y, center.z,
+		box.x, box.y, box.z,
+		extent.x, extent.y, extent.z,
+		rotation.m00, rotation.m10, rotation.m20,
+		rotation.m01, rotation.m11, rotation.m21,
+		rotation.m02, rotation.m12, rotation.m22,
+	};
+
+	for (int stream = 0; stream < eS_Count; ++stream)
+		m_streams[stream][m_count] = values[stream];
+
+	++m_count;
+}
+
+
+int CAwarenessBatch::FilterCone(const Vec3& origin, const Vec3& direction, float minDot, float maxDot, AwarenessBuffer<uint32>& results) const
+{
+	results.clear();
+
+	// The best candidate each lane has seen.
+	float bestScores[laneCount];
+	float bestIndices[laneCount];
+
+#if CRY_PLATFORM_SSE2
+	const __m128 originX = _mm_set1_ps(origin.x);
+	const __m128 originY = _mm_set1_ps(origin.y);
+	const __m128 originZ = _mm_set1_ps(origin.z);
+	const __m128 directionX = _mm_set1_ps(direction.x);
+	const __m128 directionY = _mm_set1_ps(direction.y);
+	const __m128 directionZ = _mm_set1_ps(direction.z);
+	const __m128 minDots = _mm_set1_ps(minDot);
+	const __m128 maxDots = _mm_set1_ps(maxDot);
+	const __m128 ones = _mm_set1_ps(1.0f);
+	const __m128 count = _mm_set1_ps(static_cast<float>(m_count));
+	const __m128 step = _mm_set1_ps(static_cast<float>(laneCount));
+
+	__m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128 bestScore = _mm_set1_ps(FLT_MAX);
+	__m128 bestIndex = _mm_set1_ps(-1.0f);
+
+	for (size_t i = 0; i < m_count; i += laneCount)
+	{
+		const __m128 toX = _mm_sub_ps(_mm_loadu_ps(&m_streams[eS_CenterX][i]), originX);
+		const __m128 toY = _mm_sub_ps(_mm_loadu_ps(&m_streams[eS_CenterY][i]), originY);
+		const __m128 toZ = _mm_sub_ps(_mm_loadu_ps(&m_streams[eS_CenterZ][i]), originZ);
+
+		const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(toZ, toZ)));
+		const __m128 dot = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, directionX), _mm_mul_ps(toY, directionY)),
+			_mm_mul_ps(toZ, directionZ)), distance);
+
+		// Padding lanes past the end never pass.
+		const __m128 pass = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(dot, minDots), _mm_cmple_ps(dot, maxDots)), _mm_cmplt_ps(lanes, count));
+
+		// Keep the best score in each lane without branching.
+		const __m128 score = _mm_mul_ps(_mm_sub_ps(ones, dot), distance);
+		const __m128 isBetter = _mm_and_ps(pass, _mm_cmplt_ps(score, bestScore));
+		bestScore = SelectLanes(isBetter, score, bestScore);
+		bestIndex = SelectLanes(isBetter, lanes, bestIndex);
+
+		AppendLanes(_mm_movemask_ps(pass), i, results);
+		lanes = _mm_add_ps(lanes, step);
+	}
+
+	_mm_storeu_ps(bestScores, bestScore);
+	_mm_storeu_ps(bestIndices, bestIndex);
+#else
+	for (size_t lane = 0; lane < laneCount; ++lane)
+	{
+		bestScores[lane] = FLT_MAX;
+		bestIndices[lane] = -1.0f;
+	}
+
+	for (size_t i = 0; i < m_count; ++i)
+	{
+		const Vec3 to = Vec3(m_streams[eS_CenterX][i], m_streams[eS_CenterY][i], m_streams[eS_CenterZ][i]) - origin;
+		const float distance = to.GetLength();
+		const float dot = to.dot(direction) / distance;
+
+		if ((dot >= minDot) && (dot <= maxDot))
+		{
+			const float score = (1.0f - dot) * distance;
+			const size_t lane = i % laneCount;
+			if (score < bestScores[lane])
+			{
+				bestScores[lane] = score;
+				bestIndices[lane] = static_cast<float>(i);
+			}
+
+			results.push_back(static_cast<uint32>(i));
+		}
+	}
+#endif
+
+	// Pick the best of the lanes. Ties go to the earliest candidate, just as they would testing one at a time.
+	int best = -1;
+	float bestOfLanes = FLT_MAX;
+	for (size_t lane = 0; lane < laneCount; ++lane)
+	{
+		const int index = static_cast<int>(bestIndices[lane]);
+		if ((index >= 0) && ((best < 0) || (bestScores[lane] < bestOfLanes) || ((bestScores[lane] == bestOfLanes) && (index < best))))
+		{
+			best = index;
+			bestOfLanes = bestScores[lane];
+		}
+	}
+
+	if (best < 0)
+		return -1;
+
+	// The results are in candidate order.
+	return static_cast<int>(std::lower_bound(results.begin(), results.end(), static_cast<uint32>(best)) - results.begin());
+}
+
+
+void CAwarenessBatch::FilterLineseg(const Lineseg& lineseg, AwarenessBuffer<uint32>& results) const
+{
+	results.clear();
+
+	// This is a separating axis test between each box and the line segment, just like Overlap::Lineseg_OBB. The segment
+	// is moved into the space of each box, using it's midpoint and half it's length.
+	const Vec3 mid = (lineseg.start + lineseg.end) * 0.5f;
+	const Vec3 half = (lineseg.end - lineseg.start) * 0.5f;
+
+#if CRY_PLATFORM_SSE2
+	const __m128 midX = _mm_set1_ps(mid.x);
+	const __m128 midY = _mm_set1_ps(mid.y);
+	const __m128 midZ = _mm_set1_ps(mid.z);
+	const __m128 halfX = _mm_set1_ps(half.x);
+	const __m128 halfY = _mm_set1_ps(half.y);
+	const __m128 halfZ = _mm_set1_ps(half.z);
+	const __m128 count = _mm_set1_ps(static_cast<float>(m_count));
+	const __m128 step = _mm_set1_ps(static_cast<float>(laneCount));
+
+	__m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	for (size_t i = 0; i < m_count; i += laneCount)
+	{
+		auto load = [this, i](EStream stream) { return _mm_loadu_ps(&m_streams[stream][i]); };
+		auto dot = [](__m128 x0, __m128 y0, __m128 z0, __m128 x1, __m128 y1, __m128 z1)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)), _mm_mul_ps(z0, z1));
+		};
+
+		const __m128 toX = _mm_sub_ps(midX, load(eS_BoxX));
+		const __m128 toY = _mm_sub_ps(midY, load(eS_BoxY));
+		const __m128 toZ = _mm_sub_ps(midZ, load(eS_BoxZ));
+
+		const __m128 axis0X = load(eS_Axis0X), axis0Y = load(eS_Axis0Y), axis0Z = load(eS_Axis0Z);
+		const __m128 axis1X = load(eS_Axis1X), axis1Y = load(eS_Axis1Y), axis1Z = load(eS_Axis1Z);
+		const __m128 axis2X = load(eS_Axis2X), axis2Y = load(eS_Axis2Y), axis2Z = load(eS_Axis2Z);
+
+		// The segment's midpoint and half length in box space.
+		const __m128 cX = dot(toX, toY, toZ, axis0X, axis0Y, axis0Z);
+		const __m128 cY = dot(toX, toY, toZ, axis1X, axis1Y, axis1Z);
+		const __m128 cZ = dot(toX, toY, toZ, axis2X, axis2Y, axis2Z);
+		const __m128 dX = dot(halfX, halfY, halfZ, axis0X, axis0Y, axis0Z);
+		const __m128 dY = dot(halfX, halfY, halfZ, axis1X, axis1Y, axis1Z);
+		const __m128 dZ = dot(halfX, halfY, halfZ, axis2X, axis2Y, axis2Z);
+
+		const __m128 eX = AbsLanes(dX);
+		const __m128 eY = AbsLanes(dY);
+		const __m128 eZ = AbsLanes(dZ);
+		const __m128 hX = load(eS_ExtentX);
+		const __m128 hY = load(eS_ExtentY);
+		const __m128 hZ = load(eS_ExtentZ);
+
+		// The box axes.
+		__m128 separated = _mm_cmpgt_ps(AbsLanes(cX), _mm_add_ps(hX, eX));
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(AbsLanes(cY), _mm_add_ps(hY, eY)));
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(AbsLanes(cZ), _mm_add_ps(hZ, eZ)));
+
+		// The segment crossed with each box axis.
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(AbsLanes(_mm_sub_ps(_mm_mul_ps(cY, dZ), _mm_mul_ps(cZ, dY))),
+			_mm_add_ps(_mm_mul_ps(hY, eZ), _mm_mul_ps(hZ, eY))));
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(AbsLanes(_mm_sub_ps(_mm_mul_ps(cZ, dX), _mm_mul_ps(cX, dZ))),
+			_mm_add_ps(_mm_mul_ps(hX, eZ), _mm_mul_ps(hZ, eX))));
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(AbsLanes(_mm_sub_ps(_mm_mul_ps(cX, dY), _mm_mul_ps(cY, dX))),
+			_mm_add_ps(_mm_mul_ps(hX, eY), _mm_mul_ps(hY, eX))));
+
+		// Padding lanes past the end never pass.
+		const __m128 pass = _mm_andnot_ps(separated, _mm_cmplt_ps(lanes, count));
+
+		AppendLanes(_mm_movemask_ps(pass), i, results);
+		lanes = _mm_add_ps(lanes, step);
+	}
+#else
+	for (size_t i = 0; i < m_count; ++i)
+	{
+		const Vec3 axis0(m_streams[eS_Axis0X][i], m_streams[eS_Axis0Y][i], m_streams[eS_Axis0Z][i]);
+		const Vec3 axis1(m_streams[eS_Axis1X][i], m_streams[eS_Axis1Y][i], m_streams[eS_Axis1Z][i]);
+		const Vec3 axis2(m_streams[eS_Axis2X][i], m_streams[eS_Axis2Y][i], m_streams[eS_Axis2Z][i]);
+		const Vec3 h(m_streams[eS_ExtentX][i], m_streams[eS_ExtentY][i], m_streams[eS_ExtentZ][i]);
+		const Vec3 to = mid - Vec3(m_streams[eS_BoxX][i], m_streams[eS_BoxY][i], m_streams[eS_BoxZ][i]);
+
+		const Vec3 c(to.dot(axis0), to.dot(axis1), to.dot(axis2));
+		const Vec3 d(half.dot(axis0), half.dot(axis1), half.dot(axis2));
+		const Vec3 e(fabs_tpl(d.x), fabs_tpl(d.y), fabs_tpl(d.z));
+
+		const bool isSeparated = (fabs_tpl(c.x) > h.x + e.x) || (fabs_tpl(c.y) > h.y + e.y) || (fabs_tpl(c.z) > h.z + e.z)
+			|| (fabs_tpl(c.y * d.z - c.z * d.y) > h.y * e.z + h.z * e.y)
+			|| (fabs_tpl(c.z * d.x - c.x * d.z) > h.x * e.z + h.z * e.x)
+			|| (fabs_tpl(c.x * d.y - c.y * d.x) > h.x * e.y + h.y * e.x);
+
+		if (!isSeparated)
+			results.push_back(static_cast<uint32>(i));
+	}
+#endif
+}
+
+
+void CAwarenessBatch::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	for (auto& stream : m_streams)
+		pSizer->AddContainer(stream);
+}
+
+
+void CAwarenessBatch::LogBenchmark()
+{
+	static const size_t candidateCounts[] = {10, 100, 1000};
+	static const int queryCount = 1000;
+
+	// An actor's eye, looking along the Y axis, and a crowd of actor sized boxes in a 12m square around them.
+	const Vec3 origin(0.0f, 0.0f, 1.7f);
+	const Vec3 direction(0.0f, 1.0f, 0.0f);
+	const Lineseg lineseg(origin, origin + direction * 6.0f);
+
+	std::vector<SAwarenessEntry> entries;
+	CAwarenessBatch batch;
+	AwarenessBuffer<uint32> results;
+
+	for (auto candidateCount : candidateCounts)
+	{
+		entries.resize(candidateCount);
+		for (auto& entry : entries)
+		{
+			entry.worldTM = Matrix34::CreateRotationZ(cry_random(0.0f, gf_PI2), Vec3(cry_random(-6.0f, 6.0f), cry_random(-6.0f, 6.0f), 0.0f));
+			entry.localBounds = AABB(Vec3(-0.4f, -0.4f, 0.0f), Vec3(0.4f, 0.4f, 1.8f));
+			entry.worldBounds = AABB::CreateTransformedAABB(entry.worldTM, entry.localBounds);
+		}
+
+		// One entry at a time, as the awareness component used to.
+		uint32 scalarConeHits = 0;
+		CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+		for (int query = 0; query < queryCount; ++query)
+		{
+			float bestScore = FLT_MAX;
+			for (auto& entry : entries)
+			{
+				const Vec3 itemPos = entry.worldBounds.GetCenter();
+				const float dotToItem = (itemPos - origin).normalized().dot(direction);
+				if ((dotToItem >= 0.9f) && (dotToItem <= 1.0f))
+				{
+					bestScore = std::min(bestScore, (1.0f - dotToItem) * (itemPos - origin).len());
+					++scalarConeHits;
+				}
+			}
+		}
+		const float scalarConeTime = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		uint32 scalarLinesegHits = 0;
+		startTime = gEnv->pTimer->GetAsyncTime();
+		for (int query = 0; query < queryCount; ++query)
+		{
+			for (auto& entry : entries)
+			{
+				OBB obb(OBB::CreateOBBfromAABB(Matrix33(entry.worldTM), entry.localBounds));
+				if (Overlap::Lineseg_OBB(lineseg, entry.worldTM.GetTranslation(), obb))
+					++scalarLinesegHits;
+			}
+		}
+		const float scalarLinesegTime = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		// Batched, including packing the batch for each query.
+		uint32 batchConeHits = 0;
+		startTime = gEnv->pTimer->GetAsyncTime();
+		for (int query = 0; query < queryCount; ++query)
+		{
+			batch.Clear();
+			for (auto& entry : entries)
+				batch.Add(entry);
+
+			batch.FilterCone(origin, direction, 0.9f, 1.0f, results);
+			batchConeHits += static_cast<uint32>(results.size());
+		}
+		const float batchConeTime = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		uint32 batchLinesegHits = 0;
+		startTime = gEnv->pTimer->GetAsyncTime();
+		for (int query = 0; query < queryCount; ++query)
+		{
+			batch.Clear();
+			for (auto& entry : entries)
+				batch.Add(entry);
+
+			batch.FilterLineseg(lineseg, results);
+			batchLinesegHits += static_cast<uint32>(results.size());
+		}
+		const float batchLinesegTime = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		CryLogAlways("Awareness filters, %u candidates, %d queries: cone %.3fms scalar, %.3fms batched (%u / %u hits), line segment %.3fms scalar, %.3fms batched (%u / %u hits)",
+			static_cast<uint32>(candidateCount), queryCount,
+			scalarConeTime, batchConeTime, scalarConeHits, batchConeHits,
+			scalarLinesegTime, batchLinesegTime, scalarLinesegHits, batchLinesegHits);
+	}
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "AwarenessSpatialIndex.h"
+
+
+namespace Chrysalis
+{
+/**
+The spatial details of the candidates for an awareness query, packed as a structure of arrays so the cone and line
+segment tests can run on four candidates at a time. A query builds one from the entries it's interested in, then runs
+a test over it. Candidates are referred to by the order in which they were added.
+**/
+
+class CAwarenessBatch
+{
+public:
+	/** Removes every candidate. The storage is kept for the next query. */
+	void Clear();
+
+
+	/**
+	Adds a candidate. The cone test uses the centre of it's world bounds, and the line segment test uses it's local bounds
+	oriented by it's world transform.
+
+	\param	entry The entry for the candidate.
+	**/
+	void Add(const SAwarenessEntry& entry);
+
+
+	/** Number of candidates in the batch. */
+	size_t size() const { return m_count; }
+
+
+	/**
+	Finds the candidates whose centre lies within a cone, given as a range of dot products against the direction. The
+	best match is the one with the lowest (1 - dot) * distance, favouring things straight ahead and close by.
+
+	\param	origin		  The apex of the cone.
+	\param	direction	  The direction of the cone. This must be normalised.
+	\param	minDot		  The minimum dot product.
+	\param	maxDot		  The maximum dot product.
+	\param [out]	results Indices of the candidates which passed, in the order they were added. This is cleared first.
+
+	\return Where the best match is in the results, or -1 if nothing passed.
+	**/
+	int FilterCone(const Vec3& origin, const Vec3& direction, float minDot, float maxDot, AwarenessBuffer<uint32>& results) const;
+
+
+	/**
+	Finds the candidates whose oriented bounds are crossed by a line segment.
+
+	\param	lineseg		  The line segment.
+	\param [out]	results Indices of the candidates which passed, in the order they were added. This is cleared first.
+	**/
+	void FilterLineseg(const Lineseg& lineseg, AwarenessBuffer<uint32>& results) const;
+
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+
+	/**
+	Times the batched tests against testing the entries one at a time, for 10, 100 and 1000 candidates, and writes the
+	results to the log.
+	**/
+	static void LogBenchmark();
+
+private:
+	/** The packed values for each candidate. The axes are the columns of the rotation from their world transform. */
+	enum EStream
+	{
+		eS_CenterX,
+		eS_CenterY,
+		eS_CenterZ,
+		eS_BoxX,
+		eS_BoxY,
+		eS_BoxZ,
+		eS_ExtentX,
+		eS_ExtentY,
+		eS_ExtentZ,
+		eS_Axis0X,
+		eS_Axis0Y,
+		eS_Axis0Z,
+		eS_Axis1X,
+		eS_Axis1Y,
+		eS_Axis1Z,
+		eS_Axis2X,
+		eS_Axis2Y,
+		eS_Axis2Z,
+		eS_Count
+	};
+
+	/** Number of candidates tested together. The streams are always padded out to a multiple of this. */
+	static const size_t laneCount {4};
+
+	/** Number of candidates in the batch. */
+	size_t m_count {0};
+
+	/** One array of values for each stream. */
+	std::vector<float> m_streams[eS_Count];
+};
+}
@@ -0,0 +1,140 @@
+#include <StdAfx.h>
+
+#include "AwarenessScheduler.h"
+#include "EntityAwarenessComponent.h"
+#include <Components/Player/PlayerComponent.h>
+#include <Actor/ActorComponent.h>
+#include "Console/CVars.h"
+#include "Utility/CryWatch.h"
+
+
+namespace Chrysalis
+{
+/** Components this close to the camera update every frame. Each band after this doubles the interval. */
+static const float scheduleNearDistance = 10.0f;
+
+/** How long a component keeps updating every frame after someone asked for it's results, in seconds. */
+static const float scheduleRelevanceTime = 2.0f;
+
+
+CAwarenessScheduler& CAwarenessScheduler::Get()
+{
+	static CAwarenessScheduler scheduler;
+
+	return scheduler;
+}
+
+
+void CAwarenessScheduler::Add(CEntityAwarenessComponent* pComponent)
+{
+	for (auto& bucket : m_buckets)
+	{
+		if (std::find(bucket.begin(), bucket.end(), pComponent) != bucket.end())
+			return;
+	}
+
+	if (std::find(m_updating.begin(), m_updating.end(), pComponent) != m_updating.end())
+		return;
+
+	Schedule(pComponent, 1);
+}
+
+
+void CAwarenessScheduler::Remove(CEntityAwarenessComponent* pComponent)
+{
+	for (auto& bucket : m_buckets)
+		stl::find_and_erase(bucket, pComponent);
+
+	// It might be removed while the bucket it was in is being updated.
+	for (auto& pUpdating : m_updating)
+	{
+		if (pUpdating == pComponent)
+			pUpdating = nullptr;
+	}
+}
+
+
+uint32 CAwarenessScheduler::GetInterval(const CEntityAwarenessComponent& component, const Vec3& cameraPosition, float time) const
+{
+	if (!g_cvars.m_componentAwarenessLod)
+		return 1;
+
+	// The local player is always up to date.
+	if (auto pLocalActor = CPlayerComponent::GetLocalActor())
+	{
+		if (pLocalActor->GetEntityId() == component.GetEntityId())
+			return 1;
+	}
+
+	// So is anyone whose results are being used.
+	if (time - component.GetTimeLastRelevant() < scheduleRelevanceTime)
+		return 1;
+
+	// The interval doubles each time the distance does.
+	const float distanceSqr = component.GetPos().GetSquaredDistance(cameraPosition);
+	uint32 interval = 1;
+	float bandDistance = scheduleNearDistance;
+	while ((interval < maxInterval) && (distanceSqr > bandDistance * bandDistance))
+	{
+		interval *= 2;
+		bandDistance *= 2.0f;
+	}
+
+	return interval;
+}
+
+
+void CAwarenessScheduler::Schedule(CEntityAwarenessComponent* pComponent, uint32 interval)
+{
+	// Anywhere from half the interval up to the full interval will do.
+	uint32 bestBucket = (m_frame + interval) % maxInterval;
+	for (uint32 delay = (interval + 1) / 2; delay < interval; ++delay)
+	{
+		const uint32 bucket = (m_frame + delay) % maxInterval;
+		if (m_buckets[bucket].size() < m_buckets[bestBucket].size())
+			bestBucket = bucket;
+	}
+
+	m_buckets[bestBucket].push_back(pComponent);
+}
+
+
+void CAwarenessScheduler::Update()
+{
+	++m_frame;
+
+	// Take the whole bucket, anything rescheduled for a full interval from now lands back in it.
+	m_updating.clear();
+	m_updating.swap(m_buckets[m_frame % maxInterval]);
+
+	const Vec3 cameraPosition = gEnv->pSystem->GetViewCamera().GetPosition();
+	const float time = gEnv->pTimer->GetCurrTime();
+	m_lastFrameUpdates = 0;
+
+	for (size_t i = 0; i < m_updating.size(); ++i)
+	{
+		auto pComponent = m_updating[i];
+		if (!pComponent)
+			continue;
+
+		const uint32 interval = GetInterval(*pComponent, cameraPosition, time);
+		pComponent->Update(interval);
+		++m_lastFrameUpdates;
+
+		// It could have been removed during it's update.
+		if (m_updating[i])
+			Schedule(pComponent, interval);
+	}
+
+#if CRY_WATCH_ENABLED
+	if (g_cvars.m_componentAwarenessDebug & CEntityAwarenessComponent::eDB_Schedule)
+	{
+		size_t scheduled = 0;
+		for (auto& bucket : m_buckets)
+			scheduled += bucket.size();
+
+		CryWatch("Awareness: %u of %u components updated", m_lastFrameUpdates, static_cast<uint32>(scheduled));
+	}
+#endif
+}
+}
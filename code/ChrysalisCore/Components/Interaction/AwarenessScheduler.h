@@ -0,0 +1,84 @@
+#pragma once
+
+
+namespace Chrysalis
+{
+class CEntityAwarenessComponent;
+
+
+/**
+Decides when each awareness component updates. The local player's component updates every frame. Everyone else updates
+less often the further they are from the camera, unless someone has asked for their results recently.
+
+Components wait in a ring of buckets, one per frame, and each frame only the components in the current bucket are
+updated. When a component is rescheduled it goes into the least busy bucket it can use without updating later than it
+should, so the work is spread evenly across frames and the per-frame cost stays flat as the number of actors grows.
+**/
+
+class CAwarenessScheduler
+{
+public:
+	static CAwarenessScheduler& Get();
+
+	CAwarenessScheduler() = default;
+	~CAwarenessScheduler() = default;
+
+	CAwarenessScheduler(const CAwarenessScheduler&) = delete;
+	CAwarenessScheduler& operator=(const CAwarenessScheduler&) = delete;
+
+
+	/**
+	Adds a component to the schedule. It will update during the next frame. Adding a component more than once is
+	harmless.
+
+	\param	pComponent The component.
+	**/
+	void Add(CEntityAwarenessComponent* pComponent);
+
+
+	/**
+	Removes a component from the schedule. Components must call this before they are destroyed.
+
+	\param	pComponent The component.
+	**/
+	void Remove(CEntityAwarenessComponent* pComponent);
+
+
+	/** Updates the components which are due this frame. This should be called once per frame, after the entities update. */
+	void Update();
+
+
+	/** Number of components updated during the last frame. */
+	uint32 GetLastFrameUpdates() const { return m_lastFrameUpdates; }
+
+private:
+	/** Most frames a component can go between updates. This is also the number of buckets. */
+	static const uint32 maxInterval {8};
+
+	/**
+	Works out how many frames should pass before a component next updates.
+
+	\param	component	   The component.
+	\param	cameraPosition Position of the camera.
+	\param	time		   The current time.
+
+	\return The number of frames, from 1 to maxInterval.
+	**/
+	uint32 GetInterval(const CEntityAwarenessComponent& component, const Vec3& cameraPosition, float time) const;
+
+	/** Places a component in the least busy bucket which will update it within the interval. */
+	void Schedule(CEntityAwarenessComponent* pComponent, uint32 interval);
+
+	/** Components waiting in each bucket. The bucket for a frame is it's frame number modulo maxInterval. */
+	std::vector<CEntityAwarenessComponent*> m_buckets[maxInterval];
+
+	/** The components being updated right now. Removed components are set to null. */
+	std::vector<CEntityAwarenessComponent*> m_updating;
+
+	/** Counts the frames we've been updated. */
+	uint32 m_frame {0};
+
+	/** Number of components updated during the last frame. */
+	uint32 m_lastFrameUpdates {0};
+};
+}
@@ -0,0 +1,381 @@
+#include <StdAfx.h>
+
+#include "AwarenessSpatialIndex.h"
+#include "EntityAwarenessComponent.h"
+#include "Console/CVars.h"
+#include "Utility/CryWatch.h"
+
+
+namespace Chrysalis
+{
+/** Number of queries handed to each job during a batch. */
+static const size_t queriesPerJob = 16;
+
+
+/** Most ray-casts the awareness components can have submitted to physics each frame. Any more wait for the next. */
+static const uint32 rayCastQuota = 128;
+
+
+/** Heap allocations made by awareness result buffers. The batched queries fill their buffers from jobs. */
+static std::atomic<uint32> awarenessHeapAllocations {0};
+
+
+void SAwarenessAllocationCounter::OnHeapAllocation()
+{
+	++awarenessHeapAllocations;
+}
+
+
+uint32 SAwarenessAllocationCounter::Collect()
+{
+	return awarenessHeapAllocations.exchange(0);
+}
+
+
+/** The index, for as long as the plugin which owns it is alive. */
+static CAwarenessSpatialIndex* pLiveSpatialIndex {nullptr};
+
+
+CAwarenessSpatialIndex& CAwarenessSpatialIndex::Get()
+{
+	CRY_ASSERT_MESSAGE(pLiveSpatialIndex, "The awareness spatial index is only available while the Chrysalis Core plugin is alive.");
+
+	return *pLiveSpatialIndex;
+}
+
+
+CAwarenessSpatialIndex* CAwarenessSpatialIndex::GetLive()
+{
+	return pLiveSpatialIndex;
+}
+
+
+CAwarenessSpatialIndex::CAwarenessSpatialIndex()
+{
+	CRY_ASSERT_MESSAGE(!pLiveSpatialIndex, "There should only be one awareness spatial index.");
+
+	m_rayCaster.SetQuota(rayCastQuota);
+	pLiveSpatialIndex = this;
+}
+
+
+CAwarenessSpatialIndex::~CAwarenessSpatialIndex()
+{
+	Clear();
+	pLiveSpatialIndex = nullptr;
+}
+
+
+void CAwarenessSpatialIndex::OnEntityEvent(IEntity* pEntity, const SEntityEvent& event)
+{
+	if (!pEntity)
+		return;
+
+	switch (event.event)
+	{
+		case ENTITY_EVENT_XFORM:
+		{
+			// Just note that it moved, the bounds are fetched once during the next refresh no matter how often it moves.
+			auto it = m_entryIndices.find(pEntity->GetId());
+			if (it != m_entryIndices.end())
+			{
+				auto& indexed = m_entries[it->second];
+				if (!indexed.isDirty)
+				{
+					indexed.isDirty = true;
+					m_dirty.push_back(pEntity->GetId());
+				}
+			}
+		}
+		break;
+
+		case ENTITY_EVENT_DONE:
+			Remove(pEntity->GetId());
+			break;
+	}
+}
+
+
+void CAwarenessSpatialIndex::Add(EntityId entityId)
+{
+	if ((entityId == INVALID_ENTITYID) || (m_entryIndices.find(entityId) != m_entryIndices.end()))
+		return;
+
+	const uint32 index = static_cast<uint32>(m_entries.size());
+	m_entries.emplace_back();
+	m_entries[index].entry.entityId = entityId;
+	m_entryIndices[entityId] = index;
+
+	// The entity might not be fully set up yet, so we fetch it's bounds during the next refresh.
+	m_entries[index].isDirty = true;
+	m_dirty.push_back(entityId);
+	Insert(index);
+
+	gEnv->pEntitySystem->AddEntityEventListener(entityId, ENTITY_EVENT_XFORM, this);
+	gEnv->pEntitySystem->AddEntityEventListener(entityId, ENTITY_EVENT_DONE, this);
+}
+
+
+void CAwarenessSpatialIndex::Remove(EntityId entityId)
+{
+	auto it = m_entryIndices.find(entityId);
+	if (it == m_entryIndices.end())
+		return;
+
+	gEnv->pEntitySystem->RemoveEntityEventListener(entityId, ENTITY_EVENT_XFORM, this);
+	gEnv->pEntitySystem->RemoveEntityEventListener(entityId, ENTITY_EVENT_DONE, this);
+
+	const uint32 index = it->second;
+	const uint32 lastIndex = static_cast<uint32>(m_entries.size() - 1);
+	Extract(index);
+	m_entryIndices.erase(it);
+
+	// Swap and pop, which means fixing up the index for the entry we moved.
+	if (index != lastIndex)
+	{
+		Extract(lastIndex);
+		m_entries[index] = m_entries[lastIndex];
+		m_entryIndices[m_entries[index].entry.entityId] = index;
+		Insert(index);
+	}
+
+	m_entries.pop_back();
+	++m_removalCount;
+}
+
+
+void CAwarenessSpatialIndex::Clear()
+{
+	if (gEnv && gEnv->pEntitySystem)
+	{
+		for (auto& indexed : m_entries)
+		{
+			gEnv->pEntitySystem->RemoveEntityEventListener(indexed.entry.entityId, ENTITY_EVENT_XFORM, this);
+			gEnv->pEntitySystem->RemoveEntityEventListener(indexed.entry.entityId, ENTITY_EVENT_DONE, this);
+		}
+	}
+
+	m_entries.clear();
+	m_entryIndices.clear();
+	m_cells.clear();
+	m_oversized.clear();
+	m_dirty.clear();
+	m_queryCount = 0;
+	++m_removalCount;
+}
+
+
+void CAwarenessSpatialIndex::SubmitQuery(CEntityAwarenessComponent* pComponent, const AABB& box, EntityId excludeId)
+{
+	// Replace any query the component already has waiting.
+	auto first = m_queries.begin();
+	auto last = m_queries.begin() + m_queryCount;
+	auto it = std::find_if(first, last, [pComponent](const SQuery& query) { return query.pComponent == pComponent; });
+	if (it == last)
+	{
+		if (m_queryCount == m_queries.size())
+			m_queries.emplace_back();
+
+		it = m_queries.begin() + m_queryCount++;
+	}
+
+	it->pComponent = pComponent;
+	it->box = box;
+	it->excludeId = excludeId;
+}
+
+
+void CAwarenessSpatialIndex::CancelQuery(CEntityAwarenessComponent* pComponent)
+{
+	for (size_t i = 0; i < m_queryCount; ++i)
+	{
+		if (m_queries[i].pComponent == pComponent)
+		{
+			// Keep the storage of the removed query around for reuse.
+			std::swap(m_queries[i], m_queries[m_queryCount - 1]);
+			m_queries[--m_queryCount].pComponent = nullptr;
+			return;
+		}
+	}
+}
+
+
+uint64 CAwarenessSpatialIndex::GetCellKey(float x, float y) const
+{
+	const int32 cellX = static_cast<int32>(floor_tpl(x / m_cellSize));
+	const int32 cellY = static_cast<int32>(floor_tpl(y / m_cellSize));
+
+	return (static_cast<uint64>(static_cast<uint32>(cellX)) << 32) | static_cast<uint32>(cellY);
+}
+
+
+void CAwarenessSpatialIndex::Refresh(uint32 index)
+{
+	auto& indexed = m_entries[index];
+	indexed.isDirty = false;
+
+	if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(indexed.entry.entityId))
+	{
+		pEntity->GetWorldBounds(indexed.entry.worldBounds);
+		pEntity->GetLocalBounds(indexed.entry.localBounds);
+		indexed.entry.worldTM = pEntity->GetWorldTM();
+	}
+
+	// Only move it if it changed cells.
+	const Vec3 center = indexed.entry.worldBounds.GetCenter();
+	const Vec3 size = indexed.entry.worldBounds.GetSize();
+	const bool isOversized = (size.x > m_cellSize) || (size.y > m_cellSize);
+	const uint64 cellKey = GetCellKey(center.x, center.y);
+	if ((isOversized != indexed.isOversized) || (!isOversized && (cellKey != indexed.cellKey)))
+	{
+		Extract(index);
+		Insert(index);
+	}
+}
+
+
+void CAwarenessSpatialIndex::Insert(uint32 index)
+{
+	auto& indexed = m_entries[index];
+	const Vec3 center = indexed.entry.worldBounds.IsReset() ? Vec3(ZERO) : indexed.entry.worldBounds.GetCenter();
+	const Vec3 size = indexed.entry.worldBounds.IsReset() ? Vec3(ZERO) : indexed.entry.worldBounds.GetSize();
+
+	indexed.isOversized = (size.x > m_cellSize) || (size.y > m_cellSize);
+	if (indexed.isOversized)
+	{
+		m_oversized.push_back(index);
+	}
+	else
+	{
+		indexed.cellKey = GetCellKey(center.x, center.y);
+		m_cells[indexed.cellKey].push_back(index);
+	}
+}
+
+
+void CAwarenessSpatialIndex::Extract(uint32 index)
+{
+	auto& indexed = m_entries[index];
+	if (indexed.isOversized)
+	{
+		stl::find_and_erase(m_oversized, index);
+	}
+	else
+	{
+		auto it = m_cells.find(indexed.cellKey);
+		if (it != m_cells.end())
+		{
+			stl::find_and_erase(it->second, index);
+			if (it->second.empty())
+				m_cells.erase(it);
+		}
+	}
+}
+
+
+void CAwarenessSpatialIndex::Query(const AABB& box, EntityId excludeId, AwarenessBuffer<uint32>& results) const
+{
+	results.clear();
+
+	auto test = [this, &box, excludeId, &results](uint32 index)
+	{
+		const auto& entry = m_entries[index].entry;
+		if ((entry.entityId != excludeId) && !entry.worldBounds.IsReset() && entry.worldBounds.IsIntersectBox(box))
+			results.push_back(index);
+	};
+
+	// Entries can hang over the edge of their cell by up to a cell, so we check one extra cell each way.
+	const int32 minX = static_cast<int32>(floor_tpl(box.min.x / m_cellSize)) - 1;
+	const int32 minY = static_cast<int32>(floor_tpl(box.min.y / m_cellSize)) - 1;
+	const int32 maxX = static_cast<int32>(floor_tpl(box.max.x / m_cellSize)) + 1;
+	const int32 maxY = static_cast<int32>(floor_tpl(box.max.y / m_cellSize)) + 1;
+
+	for (int32 cellX = minX; cellX <= maxX; ++cellX)
+	{
+		for (int32 cellY = minY; cellY <= maxY; ++cellY)
+		{
+			const uint64 cellKey = (static_cast<uint64>(static_cast<uint32>(cellX)) << 32) | static_cast<uint32>(cellY);
+			auto it = m_cells.find(cellKey);
+			if (it != m_cells.end())
+			{
+				for (auto index : it->second)
+					test(index);
+			}
+		}
+	}
+
+	for (auto index : m_oversized)
+		test(index);
+}
+
+
+void CAwarenessSpatialIndex::RunQueries(size_t first, size_t last)
+{
+	for (size_t i = first; i < last; ++i)
+	{
+		auto& query = m_queries[i];
+		Query(query.box, query.excludeId, query.results);
+	}
+}
+
+
+void CAwarenessSpatialIndex::Update(float frameTime)
+{
+	// Catch up with anything that moved. Entries which were removed since they were marked are skipped.
+	for (auto entityId : m_dirty)
+	{
+		auto it = m_entryIndices.find(entityId);
+		if (it != m_entryIndices.end())
+			Refresh(it->second);
+	}
+	m_dirty.clear();
+
+	if (m_queryCount > 0)
+		RunBatch();
+
+	// Every ray queued during the entity updates goes to physics together. Completed rays call back from in here too.
+	m_rayCaster.Update(frameTime);
+
+	// Everything the awareness components did this frame has happened by now.
+	m_lastFrameHeapAllocations = SAwarenessAllocationCounter::Collect();
+
+#if CRY_WATCH_ENABLED
+	if (g_cvars.m_componentAwarenessDebug & CEntityAwarenessComponent::eDB_Allocations)
+		CryWatch("Awareness: %u entities, %u heap allocations", static_cast<uint32>(m_entries.size()), m_lastFrameHeapAllocations);
+#endif
+}
+
+
+void CAwarenessSpatialIndex::RunBatch()
+{
+	// The grid is read only from here on, so the queries can safely run alongside each other. The last range is run on
+	// this thread while the jobs work on the others.
+	const size_t jobCount = (m_queryCount + queriesPerJob - 1) / queriesPerJob;
+	while (m_jobStates.size() + 1 < jobCount)
+		m_jobStates.emplace_back(std::make_unique<JobManager::SJobState>());
+
+	for (size_t job = 0; job + 1 < jobCount; ++job)
+	{
+		const size_t first = job * queriesPerJob;
+		gEnv->pJobManager->AddLambdaJob("CAwarenessSpatialIndex::RunQueries", [this, first]()
+		{
+			RunQueries(first, first + queriesPerJob);
+		}, JobManager::eRegularPriority, m_jobStates[job].get());
+	}
+
+	RunQueries((jobCount - 1) * queriesPerJob, m_queryCount);
+
+	for (size_t job = 0; job + 1 < jobCount; ++job)
+		gEnv->pJobManager->WaitForJob(*m_jobStates[job]);
+
+	// Hand the results back on the main thread.
+	for (size_t i = 0; i < m_queryCount; ++i)
+	{
+		auto& query = m_queries[i];
+		if (query.pComponent)
+			query.pComponent->OnProximityQueryResult(*this, query.results);
+	}
+
+	m_queryCount = 0;
+}
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <CryEntitySystem/IEntitySystem.h>
+#include <CryThreading/IJobManager.h>
+#include <CryPhysics/RayCastQueue.h>
+#include "Utility/SmallVector.h"
+#include "Utility/Span.h"
+
+
+namespace Chrysalis
+{
+class CEntityAwarenessComponent;
+
+
+/** Counts the heap allocations made by the awareness result buffers, so we can check the steady state doesn't allocate. */
+struct SAwarenessAllocationCounter
+{
+	static void OnHeapAllocation();
+
+	/** Returns the number of allocations since the last call, and starts counting again. */
+	static uint32 Collect();
+};
+
+
+/** A buffer for awareness results. Nearly every query fits inline. */
+template<typename Type>
+using AwarenessBuffer = TSmallVector<Type, 16, SAwarenessAllocationCounter>;
+
+
+/** The ray-cast queue used by awareness components. The template argument only identifies the queue. */
+typedef RayCastQueue<47> AwarenessRayCaster;
+
+
+/** The cached spatial details for an entity in the awareness index. */
+struct SAwarenessEntry
+{
+	EntityId entityId {INVALID_ENTITYID};
+	AABB worldBounds {AABB::RESET};
+	AABB localBounds {AABB::RESET};
+	Matrix34 worldTM {IDENTITY};
+};
+
+
+/**
+A game-side spatial index of the entities that awareness components are interested in i.e. actors and anything with an
+entity interaction component. It replaces a proximity query through the entity system for every actor, every frame.
+
+The index is a loose grid in the XY plane. Entities are placed in the cell holding the centre of their bounds, and
+queries are expanded by a cell in each direction to catch entities which hang over the edge of their cell. Anything
+larger than a cell is kept in a separate list and checked for every query.
+
+Bounds and transforms are cached when an entity is added and refreshed only when the entity moves. Awareness components
+submit their queries during their update, and the whole batch is answered in a single pass after the entities have
+updated, spread across the job system.
+
+It also owns the queue for the deferred ray-casts made by awareness components. Rays queued during the entity updates
+are handed to physics together when the index updates, and the results come back on the main thread during a later
+frame.
+
+The plugin owns the index. It's cleared when a level unloads, and destroyed along with the plugin so the ray-cast queue
+goes before physics does.
+**/
+
+class CAwarenessSpatialIndex : public IEntityEventListener
+{
+public:
+	/** The index owned by the plugin. Only call this while the plugin is alive. */
+	static CAwarenessSpatialIndex& Get();
+
+
+	/**
+	Gets the index without assuming the plugin still has one. Anything which can be destroyed during shutdown, such as
+	components, should use this to take back what it handed to the index.
+
+	\return The index, or null if the plugin hasn't created it yet or has already destroyed it.
+	**/
+	static CAwarenessSpatialIndex* GetLive();
+
+	CAwarenessSpatialIndex();
+	virtual ~CAwarenessSpatialIndex();
+
+	CAwarenessSpatialIndex(const CAwarenessSpatialIndex&) = delete;
+	CAwarenessSpatialIndex& operator=(const CAwarenessSpatialIndex&) = delete;
+
+	// IEntityEventListener
+	void OnEntityEvent(IEntity* pEntity, const SEntityEvent& event) override;
+	// ~IEntityEventListener
+
+
+	/**
+	Adds an entity to the index. It will stay in the index until the entity is removed. Adding an entity more than once is
+	harmless.
+
+	\param	entityId Identifier for the entity.
+	**/
+	void Add(EntityId entityId);
+
+
+	/**
+	Removes an entity from the index.
+
+	\param	entityId Identifier for the entity.
+	**/
+	void Remove(EntityId entityId);
+
+
+	/** Removes every entity from the index, and drops any queries that were waiting to run. */
+	void Clear();
+
+
+	/**
+	Queues a proximity query to be answered during the next batch. The component is handed the results through
+	CEntityAwarenessComponent::OnProximityQueryResult. Submitting again before the batch runs replaces the earlier query.
+	Queries must not be submitted from inside OnProximityQueryResult.
+
+	\param	pComponent The component which will receive the results.
+	\param	box		   The box to search.
+	\param	excludeId  An entity to leave out of the results, typically the one making the query.
+	**/
+	void SubmitQuery(CEntityAwarenessComponent* pComponent, const AABB& box, EntityId excludeId);
+
+
+	/**
+	Drops any query the component has waiting. Components must call this before they are destroyed.
+
+	\param	pComponent The component.
+	**/
+	void CancelQuery(CEntityAwarenessComponent* pComponent);
+
+
+	/**
+	Immediately finds the entries whose bounds overlap the box. This is for on-demand queries, anything which can wait
+	should use SubmitQuery instead.
+
+	\param	box		   The box to search.
+	\param	excludeId  An entity to leave out of the results.
+	\param [out]	results Indices of the matching entries. This is cleared first.
+	**/
+	void Query(const AABB& box, EntityId excludeId, AwarenessBuffer<uint32>& results) const;
+
+
+	/**
+	Refreshes the bounds of anything that moved, then answers every query submitted since the last update. Any ray-casts
+	which were queued since the last update are submitted to physics.
+
+	\param	frameTime The frame time.
+	**/
+	void Update(float frameTime);
+
+
+	/** The queue for deferred awareness ray-casts. Anything queued is submitted during the next update. */
+	AwarenessRayCaster& GetRayCaster() { return m_rayCaster; }
+
+
+	/**
+	Gets an entry by it's index, as returned by a query. Indices are only valid until the index is next changed.
+
+	\param	index The entry index.
+
+	\return The entry.
+	**/
+	const SAwarenessEntry& GetEntry(uint32 index) const { return m_entries[index].entry; }
+
+	/** Number of entities in the index. */
+	size_t GetEntryCount() const { return m_entries.size(); }
+
+	/** Counts the entities which have left the index. Results taken before this changed may hold entities which are gone. */
+	uint32 GetRemovalCount() const { return m_removalCount; }
+
+	/** Number of heap allocations made by awareness result buffers during the last frame. Zero in the steady state. */
+	uint32 GetLastFrameHeapAllocations() const { return m_lastFrameHeapAllocations; }
+
+private:
+	struct SIndexedEntry
+	{
+		SAwarenessEntry entry;
+
+		/** The grid cell holding this entry. Not used for oversized entries. */
+		uint64 cellKey {0};
+
+		/** Too large for a single cell, so it's in m_oversized instead of the grid. */
+		bool isOversized {false};
+
+		/** Has moved since the last refresh. */
+		bool isDirty {false};
+	};
+
+	struct SQuery
+	{
+		CEntityAwarenessComponent* pComponent {nullptr};
+		AABB box;
+		EntityId excludeId {INVALID_ENTITYID};
+		AwarenessBuffer<uint32> results;
+	};
+
+	/** Grid key for the cell containing a point. */
+	uint64 GetCellKey(float x, float y) const;
+
+	/** Pulls the bounds and transform for an entry from it's entity, and moves it to the right cell. */
+	void Refresh(uint32 index);
+
+	/** Places an entry in the grid, or the oversized list. */
+	void Insert(uint32 index);
+
+	/** Takes an entry out of the grid, or the oversized list. */
+	void Extract(uint32 index);
+
+	/** Answers every submitted query and hands the results back to the components. */
+	void RunBatch();
+
+	/** Runs a range of the submitted queries. Safe to call from a job. */
+	void RunQueries(size_t first, size_t last);
+
+	/** Side length of a grid cell, in metres. */
+	float m_cellSize {4.0f};
+
+	/** The entries, packed together. */
+	std::vector<SIndexedEntry> m_entries;
+
+	/** Entity to entry index. */
+	std::unordered_map<EntityId, uint32> m_entryIndices;
+
+	/** Entry indices in each cell of the grid. */
+	std::unordered_map<uint64, std::vector<uint32>> m_cells;
+
+	/** Entry indices for anything too large for a cell. */
+	std::vector<uint32> m_oversized;
+
+	/** Entities which have moved since the last refresh. */
+	std::vector<EntityId> m_dirty;
+
+	/** Number of entities which have left the index. */
+	uint32 m_removalCount {0};
+
+	/** Queries waiting for the next batch. Only the first m_queryCount are in use, the rest are kept for their storage. */
+	std::vector<SQuery> m_queries;
+	size_t m_queryCount {0};
+
+	/** Heap allocations counted during the last frame. */
+	uint32 m_lastFrameHeapAllocations {0};
+
+	/** Deferred ray-casts for the awareness components. */
+	AwarenessRayCaster m_rayCaster;
+
+	/** Job states for the batched queries. */
+	std::vector<std::unique_ptr<JobManager::SJobState>> m_jobStates;
+};
+}
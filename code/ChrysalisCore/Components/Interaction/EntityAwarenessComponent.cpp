@@ -14,6 +14,7 @@
 #include <Components/Player/Camera/ICameraComponent.h>
 #include <Components/Player/PlayerComponent.h>
 #include <Components/Interaction/EntityInteractionComponent.h>
+#include <Components/Interaction/AwarenessScheduler.h>
 #include <Console/CVars.h>
 
 
@@ -63,22 +64,34 @@ void CEntityAwarenessComponent::Initialize()
 {
 	m_pActor = GetEntity()->GetComponent<CActorComponent>();
 	CRY_ASSERT_MESSAGE(m_pActor, "EntityAwareness component requires an actor component.");
+
+	// The scheduler decides how often we update, rather than doing it every frame.
+	CAwarenessScheduler::Get().Add(this);
 }
 
 
-void CEntityAwarenessComponent::ProcessEvent(const SEntityEvent& event)
+void CEntityAwarenessComponent::Update(uint32 validFrames)
 {
-	switch (event.event)
-	{
-		case EEntityEvent::Update:
-			Update();
-			break;
-	}
+	if (!m_pActor)
+		return;
+
+	UpdateEye();
+
+	// Our proximity query is answered along with everyone else's, and the results will do until our next update.
+	const int frameId = gEnv->pRenderer->GetFrameID();
+	m_scheduledValidUntil = frameId + static_cast<int>(validFrames);
+	CAwarenessSpatialIndex::Get().SubmitQuery(this, GetProximityBox(), m_pActor->GetEntityId());
+
+	// The ray-cast result is only reused for as long as maxRaycastStaleness allows, so it's only good for this frame.
+	UpdateRaycastQuery();
+	MarkQueryValid(eWQ_Raycast, frameId);
 }
 
 
-void CEntityAwarenessComponent::Update()
+void CEntityAwarenessComponent::UpdateEye()
 {
+	m_eyeFrameId = gEnv->pRenderer->GetFrameID();
+
 	if (!m_pActor)
 		return;
 
@@ -111,19 +124,28 @@ void CEntityAwarenessComponent::Update()
 			}
 		}
 	}
-
-	// #HACK: For now, I am just going to force these queries to run each update tick. We can finesse it later by allowing
-	// selection of which ones run.
-	GetNearDotFiltered();
-	RaycastQuery();
 }
 
 
 void CEntityAwarenessComponent::GetMemoryUsage(ICrySizer *pSizer) const
 {
 	pSizer->AddObject(this, sizeof(*this));
-	pSizer->AddObject(m_entitiesInProximity);
-	pSizer->AddObject(m_entitiesInFrontOf);
+
+	// Only buffers which outgrew their inline storage have anything on the heap.
+	auto addBuffer = [pSizer](const auto& buffer)
+	{
+		if (!buffer.IsInline())
+			pSizer->AddObject(buffer.data(), buffer.capacity() * sizeof(*buffer.data()));
+	};
+
+	addBuffer(m_entitiesInProximity);
+	addBuffer(m_proximityEntries);
+	addBuffer(m_entitiesNear);
+	addBuffer(m_entitiesNearDotFiltered);
+	addBuffer(m_entitiesInFrontOf);
+	addBuffer(m_filterIndices);
+	addBuffer(m_filterResults);
+	m_filterBatch.GetMemoryUsage(pSizer);
 }
 
 
@@ -149,6 +171,10 @@ CEntityAwarenessComponent::CEntityAwarenessComponent()
 
 CEntityAwarenessComponent::~CEntityAwarenessComponent()
 {
+	CAwarenessScheduler::Get().Remove(this);
+	if (auto pSpatialIndex = CAwarenessSpatialIndex::GetLive())
+		pSpatialIndex->CancelQuery(this);
+
 	for (int i = 0; i < maxQueuedRays; ++i)
 	{
 		m_queuedRays[i].Reset();
@@ -158,8 +184,14 @@ CEntityAwarenessComponent::~CEntityAwarenessComponent()
 
 void CEntityAwarenessComponent::UpdateRaycastQuery()
 {
-	m_isRayHit = false;
-	m_rayHitPosition = Vec3(ZERO);
+	const bool isAsync = g_cvars.m_componentAwarenessAsyncRaycasts != 0;
+
+	// Deferred results turn up during a later frame, so they are kept until they go stale.
+	if (!isAsync)
+	{
+		m_isRayHit = false;
+		m_rayHitPosition = Vec3(ZERO);
+	}
 
 	if (!m_pActor || m_pActor->GetEntity()->IsHidden())
 		return;
@@ -171,36 +203,43 @@ void CEntityAwarenessComponent::UpdateRaycastQuery()
 		IPhysicalEntity *skipEntities[1];
 		skipEntities[0] = pPhysEnt;
 
-		int raySlot = RequestRaySlotId();
-		CRY_ASSERT(raySlot != -1);
-
-		ray_hit rayHit;
-
-		// Use a synchronous ray-cast.
-		auto hits = gEnv->pPhysicalWorld->RayWorldIntersection(
-			m_eyePosition, m_eyeDirection * FORWARD_DIRECTION * forwardCastDistance,
-			ent_all, rwi_pierceability(PIERCE_GLASS) | rwi_colltype_any,
-			&rayHit, 1,
-			skipEntities, pPhysEnt ? 1 : 0);
-		if (hits > 0)
+		if (isAsync)
 		{
-			OnRayCast(rayHit);
+			int raySlot = RequestRaySlotId();
+			CRY_ASSERT(raySlot != -1);
+
+			// Use an asynchronous ray-cast. It's sent to physics along with everyone else's once the entities have updated.
+			m_queuedRays[raySlot].rayId = CAwarenessSpatialIndex::Get().GetRayCaster().Queue(
+				RayCastRequest::HighPriority,
+				RayCastRequest(m_eyePosition, m_eyeDirection * FORWARD_DIRECTION * forwardCastDistance,
+					ent_all,
+					rwi_pierceability(PIERCE_GLASS) | rwi_colltype_any,
+					skipEntities,
+					pPhysEnt ? 1 : 0,
+					2),
+				functor(*this, &CEntityAwarenessComponent::OnRayCastDataReceived));
+
+			m_queuedRays[raySlot].counter = ++m_requestCounter;
 		}
+		else
+		{
+			ray_hit rayHit;
+
+			// Use a synchronous ray-cast.
+			auto hits = gEnv->pPhysicalWorld->RayWorldIntersection(
+				m_eyePosition, m_eyeDirection * FORWARD_DIRECTION * forwardCastDistance,
+				ent_all, rwi_pierceability(PIERCE_GLASS) | rwi_colltype_any,
+				&rayHit, 1,
+				skipEntities, pPhysEnt ? 1 : 0);
+
+			m_rayHitPierceable.dist = -1.0f;
+			if (hits > 0)
+				OnRayCast(rayHit);
+			else
+				m_lookAtEntityId = INVALID_ENTITYID;
 
-		// HACK: Removed asynchronous raycasts because they were using CryAction and that had link problems with 5.3 and
-		// will be removed when 5.4 releases. 
-		// Use an asynchronous ray-cast.
-//		m_queuedRays [raySlot].rayId = static_cast<CCryAction*>(gEnv->pGameFramework)->GetPhysicQueues().GetRayCaster().Queue(
-//			RayCastRequest::HighPriority,
-//			RayCastRequest(m_eyePosition, m_eyeDirection * FORWARD_DIRECTION * forwardCastDistance,
-//				ent_all,
-//				rwi_pierceability(PIERCE_GLASS) | rwi_colltype_any,
-//				skipEntities,
-//				pPhysEnt ? 1 : 0,
-//				2),
-//			functor(*this, &CEntityAwarenessComponent::OnRayCastDataReceived));
-//
-//		m_queuedRays [raySlot].counter = ++m_requestCounter;
+			m_rayHitAny = hits > 0;
+		}
 
 #if defined(_DEBUG)
 		if (g_cvars.m_componentAwarenessDebug & eDB_RayCast)
@@ -218,6 +257,7 @@ void CEntityAwarenessComponent::UpdateRaycastQuery()
 	if (staleness > maxRaycastStaleness)
 	{
 		m_rayHitAny = false;
+		m_isRayHit = false;
 		m_lookAtEntityId = INVALID_ENTITYID;
 	}
 }
@@ -228,9 +268,9 @@ void CEntityAwarenessComponent::OnRayCastDataReceived(const QueuedRayID& rayID,
 	int raySlot = QueryRaySlotId(rayID);
 	CRY_ASSERT(raySlot != -1);
 
-	// Clear out the raycast slot if we used one.
+	// Clear out the raycast slot if we used one. The ray is done, so there's nothing to cancel.
 	if (raySlot != -1)
-		m_queuedRays[raySlot].Reset();
+		m_queuedRays[raySlot] = SRayInfo();
 
 	// Force the distance to a negative value to invalidate the last result.
 	m_rayHitPierceable.dist = -1.0f;
@@ -261,6 +301,13 @@ void CEntityAwarenessComponent::OnRayCastDataReceived(const QueuedRayID& rayID,
 #endif
 		}
 	}
+	else
+	{
+		// A miss is a fresh result too, it just means there's nothing to look at.
+		m_isRayHit = false;
+		m_timeLastDeferredResult = gEnv->pTimer->GetCurrTime();
+		m_lookAtEntityId = INVALID_ENTITYID;
+	}
 
 	// Book-keeping.
 	m_rayHitAny = rayHitSucceed;
@@ -366,65 +413,94 @@ int CEntityAwarenessComponent::QueryRaySlotId(const QueuedRayID& rayId) const
 }
 
 
-void CEntityAwarenessComponent::UpdateProximityQuery()
+AABB CEntityAwarenessComponent::GetProximityBox() const
 {
 	// The bounding box is created by offseting m_proximityRadius in each direction.
 	const Vec3 positionOffset(m_proximityRadius, m_proximityRadius, m_proximityRadius);
 
-	// Retrieve the actor EntityId so we can exclude ourselves from the results.
-	EntityId ownerActorId = m_pActor ? m_pActor->GetEntityId() : INVALID_ENTITYID;
+	return AABB(m_eyePosition - positionOffset, m_eyePosition + positionOffset);
+}
+
+
+void CEntityAwarenessComponent::OnProximityQueryResult(const CAwarenessSpatialIndex& spatialIndex, TSpan<const uint32> results)
+{
+	SetProximityResults(spatialIndex, results);
+	MarkQueryValid(eWQ_Proximity, m_scheduledValidUntil);
+
+	// The near and dot filtered queries are only run when someone asks for them, except when we want to see them. Looking
+	// at them shouldn't count as using them though.
+	if (g_cvars.m_componentAwarenessDebug & (eDB_NearEntities | eDB_DotFiltered))
+	{
+		const float timeLastRelevant = m_timeLastRelevant;
+		GetNearDotFiltered();
+		m_timeLastRelevant = timeLastRelevant;
+	}
+}
+
 
+void CEntityAwarenessComponent::MarkQueryValid(EWorldQuery query, int validUntil)
+{
+	m_validQueries |= 1u << query;
+	m_queryValidUntil[query] = validUntil;
+
+	// Anything built from the proximity results needs to be run again.
+	if (query == eWQ_Proximity)
+		m_validQueries &= ~((1u << eWQ_CloseBy) | (1u << eWQ_InFrontOf));
+}
+
+
+void CEntityAwarenessComponent::SetProximityResults(const CAwarenessSpatialIndex& spatialIndex, TSpan<const uint32> results)
+{
 	// Clear previous results. We could resize(0) at this point, but rather than thrash memory, I'll see how well
 	// it works just growing when needing and remaining at that size.
 	m_entitiesInProximity.clear();
-
-	// Set up the bounding box query.
-	SEntityProximityQuery qry;
-	qry.box.min = m_eyePosition - positionOffset;
-	qry.box.max = m_eyePosition + positionOffset;
+	m_proximityEntries.clear();
+	m_entitiesInProximity.reserve(results.size());
+	m_proximityEntries.reserve(results.size());
+	m_proximityRemovalCount = spatialIndex.GetRemovalCount();
 
 #if defined(_DEBUG)
 	if (g_cvars.m_componentAwarenessDebug & eDB_ProximalEntities)
 	{
 		// DEBUG: Render the grid for debug purposes.
-		gEnv->pRenderer->GetIRenderAuxGeom()->DrawAABB(qry.box, false, ColorB(255, 0, 0), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
+		gEnv->pRenderer->GetIRenderAuxGeom()->DrawAABB(GetProximityBox(), false, ColorB(255, 0, 0), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
 	}
 #endif
 
-	// Run the query and prepare to populate a list of the results, if they pass muster.
-	gEnv->pEntitySystem->QueryProximity(qry);
-	m_entitiesInProximity.reserve(qry.nCount);
-
-	// Check each result.
-	for (int i = 0; i < qry.nCount; ++i)
+	// The index has already left out our own entity.
+	for (auto index : results)
 	{
-		IEntity* pEntity = qry.pEntities[i];
-		EntityId entityId = pEntity ? pEntity->GetId() : INVALID_ENTITYID;
-
-		// Skip this entity.
-		if ((entityId == INVALID_ENTITYID) || (entityId == ownerActorId))
-			continue;
+		const auto& entry = spatialIndex.GetEntry(index);
 
 #if defined(_DEBUG)
 		if (g_cvars.m_componentAwarenessDebug & eDB_ProximalEntities)
 		{
-			//if (strcmp(pEntity->GetName(), "TestMe") == 0)
-			//	int a = 1;
-
 			// DEBUG: Highlight each entity within the range.
-			AABB bbox;
-			pEntity->GetWorldBounds(bbox);
+			AABB bbox = entry.worldBounds;
 			bbox.Expand(Vec3(0.01f, 0.01f, 0.01f));
 			gEnv->pRenderer->GetIRenderAuxGeom()->DrawAABB(bbox, true, ColorB(0, 64, 0), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
 		}
 #endif
 
 		// Add to the collection.
-		m_entitiesInProximity.push_back(entityId);
+		m_entitiesInProximity.push_back(entry.entityId);
+		m_proximityEntries.push_back(entry);
 	}
 }
 
 
+void CEntityAwarenessComponent::UpdateProximityQuery()
+{
+	// Retrieve the actor EntityId so we can exclude ourselves from the results.
+	EntityId ownerActorId = m_pActor ? m_pActor->GetEntityId() : INVALID_ENTITYID;
+
+	// Someone needs the results right now, so we can't wait for the batch.
+	auto& spatialIndex = CAwarenessSpatialIndex::Get();
+	spatialIndex.Query(GetProximityBox(), ownerActorId, m_proximityIndices);
+	SetProximityResults(spatialIndex, m_proximityIndices);
+}
+
+
 void CEntityAwarenessComponent::UpdateNearQuery()
 {
 	// We extend the grid out based on a scaling factor to give it extra reach.
@@ -444,24 +520,19 @@ void CEntityAwarenessComponent::UpdateNearQuery()
 	// Clear previous results.
 	m_entitiesNear.reserve(m_entitiesInProximity.size());
 	m_entitiesNear.clear();
+	m_nearIndices.reserve(m_entitiesInProximity.size());
+	m_nearIndices.clear();
 
-	// Retrieve the actor EntityId so we can exclude ourselves from the results.
-	EntityId ownerActorId = m_pActor ? m_pActor->GetEntityId() : INVALID_ENTITYID;
-
-	// We parse the results of the latest proximity query, just selecting the ones that match our strict criteria.
-	for (auto& entityId : m_entitiesInProximity)
+	// We parse the results of the latest proximity query, just selecting the ones that match our strict criteria. The
+	// spatial index has already excluded our own entity, and cached the bounds for us.
+	for (uint32 i = 0; i < m_proximityEntries.size(); ++i)
 	{
-		// Skip this entity.
-		if ((entityId == INVALID_ENTITYID) || (entityId == ownerActorId))
-			continue;
-
-		IEntity* pEntity = gEnv->pEntitySystem->GetEntity(entityId);
+		const auto& entry = m_proximityEntries[i];
 
 		// #TODO: The near query should really be based off distance from the actor, eye position is currently the camera in TP modes.
 
 		// Seems to discard anything too far based on radius, turning the cube into a flat circle.
-		AABB aabb;
-		pEntity->GetWorldBounds(aabb);
+		AABB aabb = entry.worldBounds;
 		aabb.min.z = aabb.max.z = m_eyePosition.z;
 		if (aabb.GetDistanceSqr(m_eyePosition) > flatDistanceSqr)
 			continue;
@@ -470,15 +541,15 @@ void CEntityAwarenessComponent::UpdateNearQuery()
 		if (g_cvars.m_componentAwarenessDebug & eDB_NearEntities)
 		{
 			// DEBUG: Highlight the entity.
-			AABB bbox;
-			pEntity->GetWorldBounds(bbox);
+			AABB bbox = entry.worldBounds;
 			bbox.Expand(Vec3(0.02f, 0.02f, 0.02f));
 			gEnv->pRenderer->GetIRenderAuxGeom()->DrawAABB(bbox, true, ColorB(0, 196, 0), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
 		}
 #endif
 
 		// Acceptable result, add to the collection.
-		m_entitiesNear.push_back(entityId);
+		m_entitiesNear.push_back(entry.entityId);
+		m_nearIndices.push_back(i);
 	}
 }
 
@@ -502,106 +573,76 @@ void CEntityAwarenessComponent::UpdateInFrontOfQuery()
 	}
 #endif
 
-	// Retrieve the actor EntityId so we can exclude ourselves from the results.
-	EntityId ownerActorId = m_pActor ? m_pActor->GetEntityId() : INVALID_ENTITYID;
-
-	// We parse the results of the latest proximity query, just selecting the ones that match our strict criteria.
-	for (auto& entityId : m_entitiesInProximity)
+	// We parse the results of the latest proximity query, just selecting the ones that match our strict criteria. The
+	// spatial index has already excluded our own entity, and cached the bounds and transform for us. Anything without
+	// bounds can't be hit, the rest are packed together and tested in one go.
+	m_filterBatch.Clear();
+	m_filterIndices.clear();
+	for (uint32 i = 0; i < m_proximityEntries.size(); ++i)
 	{
-		// Skip this entity.
-		if ((entityId == INVALID_ENTITYID) || (entityId == ownerActorId))
-			continue;
+		const AABB& bbox = m_proximityEntries[i].localBounds;
+		if (!bbox.IsReset() && !bbox.IsEmpty())
+		{
+			m_filterBatch.Add(m_proximityEntries[i]);
+			m_filterIndices.push_back(i);
+		}
+	}
 
-		IEntity* pEntity = gEnv->pEntitySystem->GetEntity(entityId);
+	m_filterBatch.FilterLineseg(lineseg, m_filterResults);
 
-		AABB bbox;
-		pEntity->GetLocalBounds(bbox);
-		if (!bbox.IsEmpty())
-		{
-			OBB obb(OBB::CreateOBBfromAABB(Matrix33(pEntity->GetWorldTM()), bbox));
+	for (auto result : m_filterResults)
+	{
+		const auto& entry = m_proximityEntries[m_filterIndices[result]];
 
-			if (Overlap::Lineseg_OBB(lineseg, pEntity->GetWorldPos(), obb))
-			{
 #if defined(_DEBUG)
-				if (g_cvars.m_componentAwarenessDebug & eDB_InFront)
-				{
-					// DEBUG: let's see those boxes.
-					gEnv->pRenderer->GetIRenderAuxGeom()->DrawOBB(obb, pEntity->GetWorldTM(), true, ColorB(0, 0, 196), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
-				}
+		if (g_cvars.m_componentAwarenessDebug & eDB_InFront)
+		{
+			// DEBUG: let's see those boxes.
+			OBB obb(OBB::CreateOBBfromAABB(Matrix33(entry.worldTM), entry.localBounds));
+			gEnv->pRenderer->GetIRenderAuxGeom()->DrawOBB(obb, entry.worldTM, true, ColorB(0, 0, 196), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
+		}
 #endif
 
-				// #HACK: TEST: wrong place for this test - move it to somewhere i can see it try all the entities near us.
-				auto pInteractor = pEntity->GetComponent<CEntityInteractionComponent>();
-				if (pInteractor)
-				{
-					// There's an interactor component, so this is an interactive entity.
-					// 
-					auto verbs = pInteractor->GetVerbs();
-				}
-
-				m_entitiesInFrontOf.push_back(pEntity->GetId());
-			}
-		}
+		m_entitiesInFrontOf.push_back(entry.entityId);
 	}
 }
 
 
-const Entities& CEntityAwarenessComponent::GetNearDotFiltered(float minDot, float maxDot)
+EntitySpan CEntityAwarenessComponent::GetNearDotFiltered(float minDot, float maxDot)
 {
-	int resultIndex = 0;
-	int bestResultIndex = 0;
-	float bestScore = 10000.0f;
-
 	// Clear previous results.
 	m_entitiesNearDotFiltered.reserve(m_entitiesInProximity.size());
 	m_entitiesNearDotFiltered.clear();
 
 	// Refresh the list of near entities.
-	auto entities = NearQuery();
-
-	// Check each entity to see which is the best fit.
-	for (auto& entityId : entities)
-	{
-		IEntity *pEntity = gEnv->pEntitySystem->GetEntity(entityId);
-		if (!pEntity)
-			continue;
+	const EntitySpan entities = NearQuery();
 
-		AABB bbox;
-		pEntity->GetWorldBounds(bbox);
+	// Pack the near entities together so they can be tested in one go.
+	m_filterBatch.Clear();
+	for (auto index : m_nearIndices)
+		m_filterBatch.Add(m_proximityEntries[index]);
 
-		Vec3 itemPos = bbox.GetCenter();
-		Vec3 dirToItem = (itemPos - m_eyePosition).normalized();
-		Vec3 dirLooking = (m_eyeDirection * FORWARD_DIRECTION).normalized();
-		float dotToItem = dirToItem.dot(dirLooking);
+	const Vec3 dirLooking = (m_eyeDirection * FORWARD_DIRECTION).normalized();
+	const int bestResultIndex = m_filterBatch.FilterCone(m_eyePosition, dirLooking, minDot, maxDot, m_filterResults);
 
-		if ((dotToItem >= minDot) && (dotToItem <= maxDot))
-		{
+	for (auto result : m_filterResults)
+	{
 #if defined(_DEBUG)
-			if (g_cvars.m_componentAwarenessDebug & eDB_DotFiltered)
-			{
-				// DEBUG: Highlight the entity.
-				bbox.Expand(Vec3(0.03f, 0.03f, 0.03f));
-				gEnv->pRenderer->GetIRenderAuxGeom()->DrawAABB(bbox, true, ColorB(0, 0, 64), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
-			}
+		if (g_cvars.m_componentAwarenessDebug & eDB_DotFiltered)
+		{
+			// DEBUG: Highlight the entity.
+			AABB bbox = m_proximityEntries[m_nearIndices[result]].worldBounds;
+			bbox.Expand(Vec3(0.03f, 0.03f, 0.03f));
+			gEnv->pRenderer->GetIRenderAuxGeom()->DrawAABB(bbox, true, ColorB(0, 0, 64), EBoundingBoxDrawStyle::eBBD_Extremes_Color_Encoded);
+		}
 #endif
 
-			// Provide a score for this result to qualify how good a match it is.
-			float distance = (itemPos - m_eyePosition).len();
-			float score = (1.0f - dotToItem) * distance;
-			if (score < bestScore)
-			{
-				bestResultIndex = resultIndex;
-				bestScore = score;
-			}
-
-			// Acceptable result, add to the collection.
-			m_entitiesNearDotFiltered.push_back(entityId);
-			resultIndex++;
-		}
+		// Acceptable result, add to the collection.
+		m_entitiesNearDotFiltered.push_back(entities[result]);
 	}
 
 	// Before returning the result we should swap the best result into the first element.
-	if ((m_entitiesNearDotFiltered.size() > 1) && (bestResultIndex != 0))
+	if (bestResultIndex > 0)
 		std::swap(m_entitiesNearDotFiltered[0], m_entitiesNearDotFiltered[bestResultIndex]);
 
 #if defined(_DEBUG)
@@ -10,7 +10,8 @@ with which the actor might wish to or need to interact.
 
 #include <CryPhysics/RayCastQueue.h>
 #include <CryAction.h>
-#include <CryActionPhysicQueues.h>
+#include "AwarenessSpatialIndex.h"
+#include "AwarenessBatch.h"
 
 struct ray_hit;
 
@@ -19,7 +20,11 @@ namespace Chrysalis
 {
 struct CActorComponent;
 
-typedef std::vector<EntityId> Entities;
+/** Storage for a list of entities. */
+typedef AwarenessBuffer<EntityId> Entities;
+
+/** A view over a list of entities, valid until the awareness component next updates. */
+typedef TSpan<const EntityId> EntitySpan;
 
 class CEntityAwarenessComponent
 	: public IEntityComponent
@@ -27,8 +32,6 @@ class CEntityAwarenessComponent
 protected:
 	// IEntityComponent
 	void Initialize() override;
-	void ProcessEvent(const SEntityEvent& event) override;
-	Cry::Entity::EventFlags GetEventMask() const override { return EEntityEvent::Update; }
 	virtual void GetMemoryUsage(ICrySizer* pSizer) const;
 	// ~IEntityComponent
 
@@ -56,11 +59,25 @@ public:
 		eDB_RayCast = BIT(3),
 		eDB_InFront = BIT(4),
 		eDB_DotFiltered = BIT(5),
+		eDB_Allocations = BIT(6),
+		eDB_Schedule = BIT(7),
 	};
 
 
-	/** Updates this instance. */
-	void Update();
+	/**
+	Updates this instance. This is called by the awareness scheduler, which decides how often we update.
+
+	\param	validFrames Number of frames until our next update. Results from this update are reused until then.
+	**/
+	void Update(uint32 validFrames);
+
+
+	/**
+	Gets the time someone last asked for our results. The scheduler keeps us updating often while we're relevant.
+
+	\return The time, as per the game timer.
+	**/
+	float GetTimeLastRelevant() const { return m_timeLastRelevant; }
 
 
 	/**
@@ -72,6 +89,16 @@ public:
 	void OnRayCastDataReceived(const QueuedRayID& rayID, const RayCastResult& result);
 
 
+	/**
+	Receives the results of the proximity query submitted during our update, once the spatial index has answered the
+	whole batch.
+
+	\param	spatialIndex The spatial index which ran the query.
+	\param	results		 Indices of the entries which were found.
+	**/
+	void OnProximityQueryResult(const CAwarenessSpatialIndex& spatialIndex, TSpan<const uint32> results);
+
+
 	/**
 	Gets the position of the actor's eyes.
 
@@ -96,11 +123,11 @@ public:
 	ILINE void SetProximityRadius(float proximityRadius)
 	{
 		m_proximityRadius = proximityRadius;
-		m_validQueries &= ~(eWQ_Proximity | eWQ_InFrontOf);
+		m_validQueries &= ~((1u << eWQ_Proximity) | (1u << eWQ_CloseBy) | (1u << eWQ_InFrontOf));
 	}
 
 
-	ILINE Entities& ProximityQuery()
+	ILINE EntitySpan ProximityQuery()
 	{
 		RefreshQueryCache(eWQ_Proximity);
 
@@ -108,7 +135,7 @@ public:
 	}
 
 
-	ILINE Entities& NearQuery()
+	ILINE EntitySpan NearQuery()
 	{
 		RefreshQueryCache(eWQ_Proximity);
 		RefreshQueryCache(eWQ_CloseBy);
@@ -138,7 +165,7 @@ public:
 
 	\return The entities in front of the actor.
 	**/
-	ILINE const Entities& GetEntitiesInFrontOf()
+	ILINE EntitySpan GetEntitiesInFrontOf()
 	{
 		return InFrontOfQuery();
 	}
@@ -152,7 +179,7 @@ public:
 	**/
 	ILINE IEntity* GetEntityInFrontOf()
 	{
-		auto entities = InFrontOfQuery();
+		const EntitySpan entities = InFrontOfQuery();
 
 		// #TODO: This should probably be more precise about what it returns, rather than just the first element of the vector.
 		return entities.empty() ? nullptr : gEnv->pEntitySystem->GetEntity(entities[0]);
@@ -170,7 +197,7 @@ public:
 
 	\return The near dot filtered.
 	**/
-	const Entities& GetNearDotFiltered(float minDot = 0.9f, float maxDot = 1.0f);
+	EntitySpan GetNearDotFiltered(float minDot = 0.9f, float maxDot = 1.0f);
 
 
 	/**
@@ -233,6 +260,7 @@ private:
 		eWQ_Proximity,
 		eWQ_CloseBy,
 		eWQ_InFrontOf,
+		eWQ_Count
 	};
 
 
@@ -240,11 +268,11 @@ private:
 	{
 		void Reset()
 		{
+			// The ray might still be waiting on physics, and the result would be of no use to anyone.
 			if (rayId != 0)
 			{
-				// #HACK: Massive issue, removed due to problems linking to CryAction in 5.3. It's hard to tell why this is even
-				// here now. Reseting the whole queue seems like a terrible idea in a function like this.
-				// static_cast<CCryAction*>(gEnv->pGameFramework)->GetPhysicQueues().GetRayCaster().Reset(); 
+				if (auto pSpatialIndex = CAwarenessSpatialIndex::GetLive())
+					pSpatialIndex->GetRayCaster().Cancel(rayId);
 			}
 
 			rayId = 0;
@@ -256,10 +284,21 @@ private:
 	};
 
 
+	/**
+	Marks a query as holding a valid result up to and including a given FrameId. Anything built from the proximity
+	query is marked as needing to run again when it changes.
+
+	\param	query	   The query.
+	\param	validUntil The last FrameId for which the result can be used.
+	**/
+	void MarkQueryValid(EWorldQuery query, int validUntil);
+
+
 	/**
 	Checks to see if we have a query result that is still valid for this FrameId. If no fresh query result is found
 	it will run a query update and mark the new result as being useable within this FrameId. This works like a simple
-	cache that presents multiple calls from needing to run the queries again.
+	cache that presents multiple calls from needing to run the queries again. Results from our scheduled updates are
+	kept until the next scheduled update.
 
 	Results are returned as side-effects of this function.
 
@@ -267,28 +306,33 @@ private:
 	**/
 	ILINE void RefreshQueryCache(EWorldQuery query)
 	{
-		uint32 queryMask = 1u << query;
+		const int frameId = gEnv->pRenderer->GetFrameID();
 
-		int frameid = gEnv->pRenderer->GetFrameID();
-		if (m_renderFrameId != frameid)
-		{
-			// We've changed frames, clear all queries from the valid indicator.
-			m_renderFrameId = frameid;
-			m_validQueries = 0;
-		}
-		else
-		{
-			// If there's a valid result, we can early out, and let the caller use that.
-			if (m_validQueries & queryMask)
-				return;
-		}
+		// Someone is using our results, so the scheduler should keep them fresh.
+		m_timeLastRelevant = gEnv->pTimer->GetCurrTime();
+
+		// Entities which left the spatial index since we took our proximity results might not exist any more.
+		if (m_proximityRemovalCount != CAwarenessSpatialIndex::Get().GetRemovalCount())
+			m_validQueries &= ~((1u << eWQ_Proximity) | (1u << eWQ_CloseBy) | (1u << eWQ_InFrontOf));
+
+		// If there's a valid result, we can early out, and let the caller use that.
+		if ((m_validQueries & (1u << query)) && (frameId <= m_queryValidUntil[query]))
+			return;
+
+		// We might not have been scheduled this frame, in which case the eyes need catching up first.
+		if (m_eyeFrameId != frameId)
+			UpdateEye();
 
 		// Run the query the caller was interested in.
 		// Results are returned as a side-effect of the function that is run.
 		(this->*(m_updateQueryFunctions[query]))();
 
-		// Mark that query as now being valid for this FrameId.
-		m_validQueries |= queryMask;
+		// Queries built from the proximity results are good for as long as those are.
+		int validUntil = frameId;
+		if ((query == eWQ_CloseBy) || (query == eWQ_InFrontOf))
+			validUntil = std::max(frameId, m_queryValidUntil[eWQ_Proximity]);
+
+		MarkQueryValid(query, validUntil);
 	}
 
 
@@ -302,11 +346,20 @@ private:
 	"in-proximity". It is used to restrict both proximity queries and ray-cast queries. */
 	float m_proximityRadius {6.0f};
 
-	// A mask of queries which are currently valid for this FrameId.
+	// A mask of queries which hold a result.
 	uint32 m_validQueries {0};
 
-	// Track the current render frame so we can drop query results that are too old.
-	int m_renderFrameId {-1};
+	// The last render frame each query's result can be used for.
+	int m_queryValidUntil[eWQ_Count] {};
+
+	// The render frame the eye position and direction were last updated.
+	int m_eyeFrameId {-1};
+
+	// The last frame the results of our scheduled proximity query can be used for.
+	int m_scheduledValidUntil {-1};
+
+	/** The time someone last asked for our results. */
+	float m_timeLastRelevant {0.0f};
 
 	/** The actor associated with this instance. It's critical that this value is non-null or the queries
 	will fail to run correctly. */
@@ -353,23 +406,63 @@ private:
 	// interactive for the player.
 	Entities m_entitiesInProximity;
 
+	// Cached spatial details for each of the entities in proximity, taken from the spatial index.
+	AwarenessBuffer<SAwarenessEntry> m_proximityEntries;
+
+	// The spatial index's removal count when the proximity results were taken.
+	uint32 m_proximityRemovalCount {0};
+
+	// Scratch space for on-demand queries against the spatial index.
+	AwarenessBuffer<uint32> m_proximityIndices;
+
 	// The entities which are close enough to the actor to be interactable or worth highlighting.
 	Entities m_entitiesNear;
 
+	// Where each of the near entities is in m_proximityEntries.
+	AwarenessBuffer<uint32> m_nearIndices;
+
 	// Dot product filtered version of the near entities.
 	Entities m_entitiesNearDotFiltered;
 
 	// The entities which are in front of the actor.
 	Entities m_entitiesInFrontOf;
 
+	// Scratch space for packing the candidates of the near dot filtered and in front of queries.
+	CAwarenessBatch m_filterBatch;
+
+	// Where each of the candidates in the batch came from in m_proximityEntries, when they aren't all used.
+	AwarenessBuffer<uint32> m_filterIndices;
+
+	// The candidates from the batch which passed.
+	AwarenessBuffer<uint32> m_filterResults;
+
 
 	/**
 	Performs a deferred raycast from the actors eye in the direction the actor is facing for forwardCastDistance
-	metres. OnRayCastDataReceived is called asynchronously with the result.
+	metres. OnRayCastDataReceived is called asynchronously with the result. When component_awareness_async_raycasts is
+	off the ray-cast is made immediately instead.
 	**/
 	void UpdateRaycastQuery();
 
 
+	/** Updates the eye position and direction from the actor, or the camera for the local player. */
+	void UpdateEye();
+
+
+	/** The box used for proximity queries. */
+	AABB GetProximityBox() const;
+
+
+	/**
+	Takes the results of a proximity query from the spatial index. These are available in m_entitiesInProximity and
+	m_proximityEntries.
+
+	\param	spatialIndex The spatial index which ran the query.
+	\param	results		 Indices of the entries which were found.
+	**/
+	void SetProximityResults(const CAwarenessSpatialIndex& spatialIndex, TSpan<const uint32> results);
+
+
 	/**
 	Creates an AABB around the actor and performs a query on entities within that box. The size of the box is based
 	on m_proximityRadius. Any entities which are within the box will be made available in the m_entitiesInProximity
@@ -401,9 +494,9 @@ private:
 	A proximity based query that limits the results to only those entities which are considered to be in front of the
 	actor. These are limited based on a line segment from the actor's eyes, forward in the direction they are looking.
 
-	\return A reference to a const Entities.
+	\return A view of the entities.
 	**/
-	ILINE const Entities& InFrontOfQuery()
+	ILINE EntitySpan InFrontOfQuery()
 	{
 		RefreshQueryCache(eWQ_Proximity);
 		RefreshQueryCache(eWQ_InFrontOf);
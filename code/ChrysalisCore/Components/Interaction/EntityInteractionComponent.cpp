@@ -5,6 +5,7 @@
 #include "CrySchematyc/Env/Elements/EnvComponent.h"
 #include "CrySchematyc/Env/IEnvRegistrar.h"
 #include "Components/Player/PlayerComponent.h"
+#include "Components/Interaction/AwarenessSpatialIndex.h"
 
 
 namespace Chrysalis
@@ -40,6 +41,8 @@ void CEntityInteractionComponent::ReflectType(Schematyc::CTypeDesc<CEntityIntera
 
 void CEntityInteractionComponent::Initialize()
 {
+	// Make sure actors can find us with their awareness queries.
+	CAwarenessSpatialIndex::Get().Add(GetEntityId());
 }
 
 
@@ -50,62 +53,110 @@ void CEntityInteractionComponent::Initialize()
 
 void CEntityInteractionComponent::AddInteraction(IInteractionPtr interaction)
 {
-	m_Interactions.push_back(interaction);
+	const string verb = interaction->GetVerb();
+	m_interactions.push_back({interaction, verb, GetVerbId(verb.c_str())});
+	++m_interactionsVersion;
 }
 
 
-void CEntityInteractionComponent::RemoveInteraction(string verb)
+void CEntityInteractionComponent::RemoveInteraction(const string& verb)
 {
-	m_Interactions.erase(std::remove_if(m_Interactions.begin(), m_Interactions.end(),
-		[&](IInteractionPtr i) { return i->GetVerb().compare(verb) == 0; }),
-		m_Interactions.end());
+	const InteractionVerbId verbId = GetVerbId(verb.c_str());
+	m_interactions.erase(std::remove_if(m_interactions.begin(), m_interactions.end(),
+		[&](const SInteraction& i) { return (i.verbId == verbId) && (i.verb.compare(verb) == 0); }),
+		m_interactions.end());
+	++m_interactionsVersion;
 }
 
 
-std::vector<string> CEntityInteractionComponent::GetVerbs(bool includeHidden)
+void CEntityInteractionComponent::RefreshVerbs()
 {
-	std::vector<string> verbs;
+	uint32 stateVersion = 0;
+	for (auto& it : m_interactions)
+		stateVersion += it.interaction->GetStateVersion();
 
-	for (auto& it : m_Interactions)
+	if ((m_builtInteractionsVersion == m_interactionsVersion) && (m_builtStateVersion == stateVersion))
+		return;
+
+	m_builtInteractionsVersion = m_interactionsVersion;
+	m_builtStateVersion = stateVersion;
+	++m_verbsVersion;
+
+	m_verbs.clear();
+	m_verbsIncludingHidden.clear();
+	m_verbIndex.clear();
+
+	for (uint32 i = 0; i < m_interactions.size(); ++i)
 	{
-		if (it->IsEnabled())
+		auto& it = m_interactions[i];
+		if (it.interaction->IsEnabled())
 		{
-			if ((!it->IsHidden()) || ((it->IsHidden()) && includeHidden))
-			{
-				verbs.push_back(it->GetVerb());
-			}
+			if (!it.interaction->IsHidden())
+				m_verbs.push_back(it.verb);
+
+			m_verbsIncludingHidden.push_back(it.verb);
+
+			// Only the first enabled interaction for each verb can be found.
+			m_verbIndex.emplace(it.verbId, i);
 		}
 	}
+}
+
+
+TSpan<const string> CEntityInteractionComponent::GetVerbs(bool includeHidden)
+{
+	RefreshVerbs();
 
-	return verbs;
+	return includeHidden ? m_verbsIncludingHidden : m_verbs;
 }
 
 
-IInteractionWeakPtr CEntityInteractionComponent::GetInteraction(string verb)
+uint32 CEntityInteractionComponent::GetVerbsVersion()
 {
-	for (auto& it : m_Interactions)
-	{
-		if ((it->GetVerb().compare(verb) == 0) && (it->IsEnabled()))
-		{
-			return it;
-		}
-	}
+	RefreshVerbs();
+
+	return m_verbsVersion;
+}
+
 
-	CryLogAlways("There's no interaction verb for %s", verb);
+const CEntityInteractionComponent::SInteraction* CEntityInteractionComponent::FindInteraction(InteractionVerbId verbId)
+{
+	RefreshVerbs();
+
+	auto it = m_verbIndex.find(verbId);
+
+	return it != m_verbIndex.end() ? &m_interactions[it->second] : nullptr;
+}
+
+
+IInteractionWeakPtr CEntityInteractionComponent::GetInteraction(const string& verb)
+{
+	auto pInteraction = FindInteraction(GetVerbId(verb.c_str()));
+	if (pInteraction && (pInteraction->verb.compare(verb) == 0))
+		return pInteraction->interaction;
+
+	CryLogAlways("There's no interaction verb for %s", verb.c_str());
 
 	return std::weak_ptr<IInteraction>();
 }
 
 
-IInteractionWeakPtr CEntityInteractionComponent::SelectInteractionVerb(string verb)
+IInteractionWeakPtr CEntityInteractionComponent::GetInteraction(InteractionVerbId verbId)
 {
-	for (auto& it : m_Interactions)
+	if (auto pInteraction = FindInteraction(verbId))
+		return pInteraction->interaction;
+
+	return std::weak_ptr<IInteraction>();
+}
+
+
+IInteractionWeakPtr CEntityInteractionComponent::SelectInteractionVerb(const string& verb)
+{
+	auto pInteraction = FindInteraction(GetVerbId(verb.c_str()));
+	if (pInteraction && (pInteraction->verb.compare(verb) == 0))
 	{
-		if ((it->GetVerb().compare(verb) == 0) && (it->IsEnabled()))
-		{
-			m_selectedInteraction = it;
-			return it;
-		}
+		m_selectedInteraction = pInteraction->interaction;
+		return pInteraction->interaction;
 	}
 
 	return std::weak_ptr<IInteraction>();
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <Entities/Interaction/IEntityInteraction.h>
+#include <CryCore/CryCrc32.h>
+#include "Utility/Span.h"
 
 
 namespace Chrysalis
 {
+/** Identifies an interaction verb. This is a hash of the verb, see CEntityInteractionComponent::GetVerbId. */
+typedef uint32 InteractionVerbId;
+
+
 /**
 An entity interaction component.
 
@@ -32,12 +38,42 @@ public:
 		return id;
 	}
 
-	std::vector<string> GetVerbs(bool includeHidden = false);
+	/**
+	Turns a verb into the identifier used to look up interactions. Work this out once and keep it, rather than passing
+	the verb around as a string.
+
+	\param	verb The verb.
+
+	\return The verb identifier.
+	**/
+	static InteractionVerbId GetVerbId(const char* verb) { return CCrc32::Compute(verb); }
+
+
+	/**
+	Gets the verbs for the enabled interactions. The list is only rebuilt when an interaction is added, removed,
+	enabled, disabled, hidden or shown, so this is cheap to call every frame.
+
+	\param	includeHidden (Optional) True to include the verbs of hidden interactions.
+
+	\return A view of the verbs, valid until the interactions next change.
+	**/
+	TSpan<const string> GetVerbs(bool includeHidden = false);
+
+
+	/**
+	Gets the version of the verb lists. It changes each time they're rebuilt, so callers can tell if they need to look
+	at them again.
+
+	\return The version.
+	**/
+	uint32 GetVerbsVersion();
+
 
 	void AddInteraction(IInteractionPtr interaction);
-	void RemoveInteraction(string verb);
-	IInteractionWeakPtr GetInteraction(string verb);
-	IInteractionWeakPtr SelectInteractionVerb(string verb);
+	void RemoveInteraction(const string& verb);
+	IInteractionWeakPtr GetInteraction(const string& verb);
+	IInteractionWeakPtr GetInteraction(InteractionVerbId verbId);
+	IInteractionWeakPtr SelectInteractionVerb(const string& verb);
 	void ClearInteractionVerb();
 
 	void OnInteractionStart(IActor& actor);
@@ -45,7 +81,42 @@ public:
 	void OnInteractionComplete(IActor& actor);
 
 private:
-	std::vector<IInteractionPtr> m_Interactions;
+	struct SInteraction
+	{
+		IInteractionPtr interaction;
+
+		/** The verb, fetched once when the interaction is added. */
+		string verb;
+		InteractionVerbId verbId;
+	};
+
+
+	/** Rebuilds the verb lists and the verb index, if any of the interactions have changed since they were last built. */
+	void RefreshVerbs();
+
+
+	/** Finds the first enabled interaction for a verb. */
+	const SInteraction* FindInteraction(InteractionVerbId verbId);
+
+	std::vector<SInteraction> m_interactions;
 	IInteractionPtr m_selectedInteraction {IInteractionPtr()};
+
+	/** Verb to the first enabled interaction for that verb, as an index into m_interactions. */
+	std::unordered_map<InteractionVerbId, uint32> m_verbIndex;
+
+	/** Verbs for the enabled interactions, without and with the hidden ones. */
+	std::vector<string> m_verbs;
+	std::vector<string> m_verbsIncludingHidden;
+
+	/** Goes up each time the verb lists are rebuilt. */
+	uint32 m_verbsVersion {0};
+
+	/** Goes up each time an interaction is added or removed. */
+	uint32 m_interactionsVersion {1};
+
+	/** The interaction version and the total of the interactions' state versions when the verb lists were last built. As
+	state versions only ever go up, the total changes whenever any of them do. */
+	uint32 m_builtInteractionsVersion {0};
+	uint32 m_builtStateVersion {0};
 };
 }
\ No newline at end of file
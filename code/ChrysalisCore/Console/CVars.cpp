@@ -4,11 +4,16 @@
 #include <CrySystem/ISystem.h>
 #include "Components/Player/PlayerComponent.h"
 #include <Actor/ActorComponent.h>
+#include <Actor/ActorControllerComponent.h>
 #include <Actor/Animation/Actions/ActorAnimationActionEmote.h>
 #include <Actor/Character/CharacterComponent.h>
 #include <ObjectID/ObjectId.h>
 #include <ObjectID/ObjectIdMasterFactory.h>
 #include <Plugin/ChrysalisCorePlugin.h>
+#include <Components/Interaction/AwarenessBatch.h>
+#include <Game/Cache/GameCache.h>
+#include <ECS/ECS.h>
+#include <StateMachine/StateMachineBenchmark.h>
 #include <CrySystem/ConsoleRegistration.h>
 
 
@@ -72,8 +77,23 @@ void CCVars::RegisterVariables()
 	REGISTER_CVAR2("component_equipment_debug", &m_componentEquipmentDebug, 0, VF_CHEAT, "Allow debug display.");
 	REGISTER_CVAR2("component_character_attributes_debug", &m_componentCharacterAttributesDebug, 0, VF_CHEAT, "Allow debug display.");
 	REGISTER_CVAR2("component_awareness_debug", &m_componentAwarenessDebug, 0, VF_CHEAT, "Allow debug display.");
+	REGISTER_CVAR2("component_awareness_async_raycasts", &m_componentAwarenessAsyncRaycasts, 1, VF_CHEAT, "Awareness ray-casts are queued and answered during a later frame. 0 - synchronous, 1 - asynchronous");
+	REGISTER_CVAR2("component_awareness_lod", &m_componentAwarenessLod, 1, VF_CHEAT, "Awareness components further from the camera update less often. 0 - every frame, 1 - by distance and relevance");
 	REGISTER_CVAR2("component_inventory_debug", &m_componentInventoryDebug, 0, VF_CHEAT, "Allow debug display.");
 
+	// Actor controllers
+	REGISTER_CVAR2("actor_controller_parallel", &m_actorControllerParallel, 1, VF_CHEAT, "Step the movement of large numbers of actors in parallel on the job manager. 0 - serial, 1 - parallel");
+
+	// ECS
+	REGISTER_CVAR2("ecs_parallel_systems", &m_ecsParallelSystems, 1, VF_CHEAT, "Run ECS systems which don't conflict in parallel on the job manager. 0 - serial, 1 - parallel");
+
+	// Game cache
+	REGISTER_CVAR2("gamecache_budget_geometry", &m_gameCacheBudgetGeometry, 256, VF_NULL, "Megabytes of cached geometry to keep before the least recently used is let go of. 0 - no limit");
+	REGISTER_CVAR2("gamecache_budget_texture", &m_gameCacheBudgetTexture, 512, VF_NULL, "Megabytes of cached textures to keep before the least recently used are let go of. 0 - no limit");
+	REGISTER_CVAR2("gamecache_budget_material", &m_gameCacheBudgetMaterial, 16, VF_NULL, "Megabytes of cached materials to keep before the least recently used are let go of. 0 - no limit");
+	REGISTER_CVAR2("gamecache_budget_particle", &m_gameCacheBudgetParticleEffect, 32, VF_NULL, "Megabytes of cached particle effects to keep before the least recently used are let go of. 0 - no limit");
+	REGISTER_CVAR2("gamecache_budget_character", &m_gameCacheBudgetCharacter, 256, VF_NULL, "Megabytes of cached characters to keep before the least recently used which aren't in use are let go of. 0 - no limit");
+
 	// ***
 	// *** COMMANDS
 	// ***
@@ -84,6 +104,28 @@ void CCVars::RegisterVariables()
 		"Usage: createobjectid [class]");
 	REGISTER_COMMAND("emote", CCVars::OnEmote, VF_NULL, "Makes a request for the character under player command to perform an emote.\n"
 		"Usage: emote [emotion]");
+	REGISTER_COMMAND("awareness_benchmark", CCVars::OnAwarenessBenchmark, VF_CHEAT, "Times the packed awareness cone and line segment filters against testing entities one at a time.\n"
+		"Usage: awareness_benchmark");
+	REGISTER_COMMAND("objectid_benchmark", CCVars::OnObjectIdBenchmark, VF_CHEAT, "Times creating ObjectIds from several threads at once.\n"
+		"Usage: objectid_benchmark [threads] [ids per thread]");
+	REGISTER_COMMAND("gamecache_preload", CCVars::OnGameCachePreload, VF_NULL, "Preloads the assets listed in a manifest into the game cache.\n"
+		"Usage: gamecache_preload <manifest>");
+	REGISTER_COMMAND("gamecache_stats", CCVars::OnGameCacheStats, VF_NULL, "Outputs the size, budget, hits, misses and evictions for each category in the game cache.\n"
+		"Usage: gamecache_stats");
+	REGISTER_COMMAND("ecs_load_snapshot", CCVars::OnEcsLoadSnapshot, VF_CHEAT, "Adds the entities from a binary ECS snapshot to the actor registry.\n"
+		"Usage: ecs_load_snapshot [file]");
+	REGISTER_COMMAND("ecs_apply_delta", CCVars::OnEcsApplyDelta, VF_CHEAT, "Applies a delta of the actor changes to the actor replica. Deltas must be applied in the order they were saved.\n"
+		"Usage: ecs_apply_delta [file]");
+	REGISTER_COMMAND("ecs_batches", CCVars::OnEcsBatches, VF_NULL, "Outputs the batches the ECS systems are run in, which shows the effect of their read / write declarations.\n"
+		"Usage: ecs_batches");
+	REGISTER_COMMAND("hsm_pool_stats", CCVars::OnHsmPoolStats, VF_NULL, "Outputs the heap allocations and pool reuse of the movement state machine hierarchies.\n"
+		"Usage: hsm_pool_stats");
+	REGISTER_COMMAND("hsm_dispatch_benchmark", CCVars::OnHsmDispatchBenchmark, VF_CHEAT, "Times dispatching events through a throwaway state machine, walking parent pointers against the dispatch tables.\n"
+		"Usage: hsm_dispatch_benchmark [iterations]");
+	REGISTER_COMMAND("hsm_trace_dump", CCVars::OnHsmTraceDump, VF_NULL, "Outputs the recent steps taken by the local actor's movement state machine.\n"
+		"Usage: hsm_trace_dump");
+	REGISTER_COMMAND("hsm_trace_export", CCVars::OnHsmTraceExport, VF_NULL, "Writes the recent steps taken by the local actor's movement state machine to a binary file.\n"
+		"Usage: hsm_trace_export <file>");
 }
 
 
@@ -101,6 +143,17 @@ void CCVars::UnregisterVariables()
 	gEnv->pConsole->RemoveCommand("attach");
 	gEnv->pConsole->RemoveCommand("createobjectid");
 	gEnv->pConsole->RemoveCommand("emote");
+	gEnv->pConsole->RemoveCommand("awareness_benchmark");
+	gEnv->pConsole->RemoveCommand("objectid_benchmark");
+	gEnv->pConsole->RemoveCommand("gamecache_preload");
+	gEnv->pConsole->RemoveCommand("gamecache_stats");
+	gEnv->pConsole->RemoveCommand("ecs_load_snapshot");
+	gEnv->pConsole->RemoveCommand("ecs_apply_delta");
+	gEnv->pConsole->RemoveCommand("ecs_batches");
+	gEnv->pConsole->RemoveCommand("hsm_pool_stats");
+	gEnv->pConsole->RemoveCommand("hsm_dispatch_benchmark");
+	gEnv->pConsole->RemoveCommand("hsm_trace_dump");
+	gEnv->pConsole->RemoveCommand("hsm_trace_export");
 }
 
 
@@ -256,4 +309,128 @@ void CCVars::OnEmote(IConsoleCmdArgs* pConsoleCommandArgs)
 		CryLogAlways("Please supply the name of the emote to play.");
 	}
 }
+
+
+void CCVars::OnAwarenessBenchmark(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	CAwarenessBatch::LogBenchmark();
+}
+
+
+void CCVars::OnObjectIdBenchmark(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	uint32 threadCount = 4;
+	uint32 idsPerThread = 100000;
+
+	if (pConsoleCommandArgs->GetArgCount() > 1)
+		threadCount = std::max(1, atoi(pConsoleCommandArgs->GetArg(1)));
+	if (pConsoleCommandArgs->GetArgCount() > 2)
+		idsPerThread = std::max(1, atoi(pConsoleCommandArgs->GetArg(2)));
+
+	CObjectIdFactory::LogBenchmark(threadCount, idsPerThread);
+}
+
+
+void CCVars::OnGameCachePreload(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	if (pConsoleCommandArgs->GetArgCount() == 2)
+	{
+		const uint32 preloadId = CChrysalisCorePlugin::Get()->GetGameCache()->PreloadManifest(pConsoleCommandArgs->GetArg(1));
+		CryLogAlways("Game cache preload %u started from %s.", preloadId, pConsoleCommandArgs->GetArg(1));
+	}
+	else
+	{
+		CryLogAlways("Usage: gamecache_preload <manifest>");
+	}
+}
+
+
+void CCVars::OnGameCacheStats(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	CChrysalisCorePlugin::Get()->GetGameCache()->LogStatistics();
+}
+
+
+void CCVars::OnEcsLoadSnapshot(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	// Defaults to the snapshot written out by the simulation's save.
+	const char* fileName = (pConsoleCommandArgs->GetArgCount() == 2) ? pConsoleCommandArgs->GetArg(1) : "chrysalis/parameters/items/test-out-snapshot.ecs";
+
+	if (ECS::ecsSimulation.LoadActorSnapshot(fileName))
+		CryLogAlways("Loaded ECS snapshot %s.", fileName);
+	else
+		CryLogAlways("Unable to load ECS snapshot %s.", fileName);
+}
+
+
+void CCVars::OnEcsApplyDelta(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	// Defaults to the delta written out by the simulation's save.
+	const char* fileName = (pConsoleCommandArgs->GetArgCount() == 2) ? pConsoleCommandArgs->GetArg(1) : "chrysalis/parameters/items/test-out-delta.ecsd";
+
+	if (ECS::ecsSimulation.ApplyActorDelta(fileName))
+		CryLogAlways("Applied ECS delta %s, the actor replica has %zu entities.", fileName, ECS::ecsSimulation.GetActorReplica()->alive());
+	else
+		CryLogAlways("Unable to apply ECS delta %s.", fileName);
+}
+
+
+void CCVars::OnEcsBatches(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	ECS::ecsSimulation.LogSystemBatches();
+}
+
+
+void CCVars::OnHsmPoolStats(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	if (CActorControllerComponent::s_pStateMachineRegistrationMovement)
+		CActorControllerComponent::s_pStateMachineRegistrationMovement->LogPoolStatistics("Movement");
+	else
+		CryLogAlways("The movement state machine has not been registered.");
+}
+
+
+void CCVars::OnHsmDispatchBenchmark(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	uint32 iterations = 10000;
+
+	if (pConsoleCommandArgs->GetArgCount() > 1)
+		iterations = std::max(1, atoi(pConsoleCommandArgs->GetArg(1)));
+
+	// The handlers of a real actor would run over and over, so the benchmark has a state machine of it's own.
+	CStateMachineBenchmark benchmark;
+	benchmark.Run(iterations);
+}
+
+
+void CCVars::OnHsmTraceDump(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	auto pActorComponent = CPlayerComponent::GetLocalActor();
+	if (pActorComponent && pActorComponent->GetControllerComponent())
+		pActorComponent->GetControllerComponent()->StateMachineLogTraceMovement();
+	else
+		CryLogAlways("There is no local actor to trace.");
+}
+
+
+void CCVars::OnHsmTraceExport(IConsoleCmdArgs* pConsoleCommandArgs)
+{
+	if (pConsoleCommandArgs->GetArgCount() == 2)
+	{
+		auto pActorComponent = CPlayerComponent::GetLocalActor();
+		if (pActorComponent && pActorComponent->GetControllerComponent())
+		{
+			if (pActorComponent->GetControllerComponent()->StateMachineExportTraceMovement(pConsoleCommandArgs->GetArg(1)))
+				CryLogAlways("Movement state machine trace written to %s.", pConsoleCommandArgs->GetArg(1));
+		}
+		else
+		{
+			CryLogAlways("There is no local actor to trace.");
+		}
+	}
+	else
+	{
+		CryLogAlways("Usage: hsm_trace_export <file>");
+	}
+}
 }
\ No newline at end of file
@@ -61,8 +61,23 @@ public:
 	int m_componentEquipmentDebug { 0 };
 	int m_componentCharacterAttributesDebug { 0 };
 	int m_componentAwarenessDebug { 0 };
+	int m_componentAwarenessAsyncRaycasts { 1 };
+	int m_componentAwarenessLod { 1 };
 	int m_componentInventoryDebug { 0 };
 
+	// Actor controllers
+	int m_actorControllerParallel { 1 };
+
+	// ECS
+	int m_ecsParallelSystems { 1 };
+
+	// Game cache
+	int m_gameCacheBudgetGeometry { 256 };
+	int m_gameCacheBudgetTexture { 512 };
+	int m_gameCacheBudgetMaterial { 16 };
+	int m_gameCacheBudgetParticleEffect { 32 };
+	int m_gameCacheBudgetCharacter { 256 };
+
 
 	/**
 	Attaches the currently player to an entity.
@@ -86,6 +101,97 @@ public:
 	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
 	**/
 	static void OnEmote(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Times the packed awareness filters against testing entities one at a time, and outputs the results to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnAwarenessBenchmark(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Times creating ObjectIds from several threads at once, and outputs the results to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnObjectIdBenchmark(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Starts preloading the assets listed in a manifest into the game cache. Completion is written to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnGameCachePreload(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Outputs the size, budget, hits, misses and evictions for each category in the game cache to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnGameCacheStats(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Adds the entities from a binary ECS snapshot to the actor registry. Defaults to the snapshot written by the last save.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnEcsLoadSnapshot(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Applies a delta of the actor changes to the actor replica. Defaults to the delta written by the last save.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnEcsApplyDelta(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Outputs the batches the ECS systems are run in to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnEcsBatches(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Outputs how many state hierarchies the movement state machine has taken from the heap and how many it has reused from
+	it's pools to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnHsmPoolStats(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Times dispatching events through a throwaway state machine, walking the parent pointers against the dispatch tables,
+	and outputs the results to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnHsmDispatchBenchmark(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Decodes the recent steps taken by the local actor's movement state machine and outputs them to the log.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnHsmTraceDump(IConsoleCmdArgs* pConsoleCommandArgs);
+
+
+	/**
+	Writes the recent steps taken by the local actor's movement state machine to a binary file, for replaying movement
+	bugs offline.
+
+	\param [in,out]	pConsoleCommandArgs If non-null, the console command arguments.
+	**/
+	static void OnHsmTraceExport(IConsoleCmdArgs* pConsoleCommandArgs);
 };
 
 extern CCVars g_cvars;
@@ -0,0 +1,42 @@
+#include "StdAfx.h"
+
+#include "ConditionActorNamed.h"
+#include <CrySerialization/IArchive.h>
+#include "ECS/ECS.h"
+
+
+namespace Chrysalis
+{
+CConditionActorNamed::CConditionActorNamed()
+{
+}
+
+
+CConditionActorNamed::CConditionActorNamed(const string& actorName)
+	: m_actorName(actorName)
+{
+}
+
+
+CConditionActorNamed::~CConditionActorNamed()
+{
+}
+
+
+bool CConditionActorNamed::IsMet(DRS::IResponseInstance* pResponseInstance)
+{
+	return !m_actorName.empty() && (ECS::ecsSimulation.GetActorByName(entt::hashed_string {m_actorName.c_str()}) != entt::null);
+}
+
+
+void CConditionActorNamed::Serialize(Serialization::IArchive& ar)
+{
+	ar(m_actorName, "ActorName", "^ActorName");
+}
+
+
+string CConditionActorNamed::GetVerboseInfo() const
+{
+	return "ECS actor '" + m_actorName + "' exists";
+}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <CryDynamicResponseSystem/IDynamicResponseCondition.h>
+#include <CryDynamicResponseSystem/IDynamicResponseSystem.h>
+
+namespace Chrysalis
+{
+struct DRS::IResponseActor;
+struct DRS::IVariableCollection;
+
+
+/** Met when there is an actor in the ECS simulation with the given name. The lookup goes through the simulation's name
+index, so it's cheap enough to check often. */
+
+class CConditionActorNamed final : public DRS::IResponseCondition
+{
+public:
+	CConditionActorNamed();
+	CConditionActorNamed(const string& actorName);
+	virtual ~CConditionActorNamed();
+
+	// IResponseCondition
+	virtual bool IsMet(DRS::IResponseInstance* pResponseInstance) override;
+	virtual void Serialize(Serialization::IArchive& ar) override;
+	virtual string GetVerboseInfo() const override;
+	virtual const char* GetType() const override { return "ActorNamed"; }
+	// ~IResponseCondition
+
+private:
+	string m_actorName;
+};
+}
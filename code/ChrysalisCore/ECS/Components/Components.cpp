@@ -133,6 +133,11 @@ void RegisterComponentsWithMeta()
 		.type(ECS::Spell().GetHashedName())
 		.ctor<&assign<ECS::Spell>, entt::as_alias_t>();
 
+	entt::meta<ECS::SpellPrototype>()
+		.base<ECS::IComponent>()
+		.type(ECS::SpellPrototype().GetHashedName())
+		.ctor<&assign<ECS::SpellPrototype>, entt::as_alias_t>();
+
 	// Items.
 	entt::meta<ECS::ItemClass>()
 		.base<ECS::IComponent>()
@@ -119,6 +119,10 @@ struct IComponent
 	// This should be pure virtual but the ECS needs to be able to instantiate the struct, so...here's nothing.
 	virtual bool Serialize(Serialization::IArchive& archive) { return true; };
 
+	// Entities are only meaningful within the registry they belong to. Components which refer to other entities rewrite
+	// those references through remap when they are written to, or read from, a binary snapshot.
+	virtual void RemapEntities(const std::function<entt::entity(entt::entity)>& remap) {};
+
 	virtual const CryGUID& GetGuid() const
 	{
 		static CryGUID guid = "{DEADDEAD-DEAD-DEAD-DEAD-DEADDEADDEAD}"_cry_guid;
@@ -275,14 +279,36 @@ struct SourceAndTarget : public IComponent
 
 	bool Serialize(Serialization::IArchive& archive) override final
 	{
+		// Only the binary snapshots remap entities, so the references are left out of the XML files.
+		if (archive.caps(Serialization::IArchive::BINARY))
+		{
+			uint32 source = static_cast<uint32>(sourceEntity);
+			uint32 target = static_cast<uint32>(targetEntity);
+			archive(source, "sourceEntity", "sourceEntity");
+			archive(target, "targetEntity", "targetEntity");
+
+			if (archive.isInput())
+			{
+				sourceEntity = static_cast<entt::entity>(source);
+				targetEntity = static_cast<entt::entity>(target);
+			}
+		}
+
 		return true;
 	}
 
+
+	void RemapEntities(const std::function<entt::entity(entt::entity)>& remap) override final
+	{
+		sourceEntity = remap(sourceEntity);
+		targetEntity = remap(targetEntity);
+	}
+
 	/** The source of the heal. */
-	entt::entity sourceEntity;
+	entt::entity sourceEntity {entt::null};
 
 	/** The target that will receive the heal - require a Health component. */
-	entt::entity targetEntity;
+	entt::entity targetEntity {entt::null};
 };
 
 
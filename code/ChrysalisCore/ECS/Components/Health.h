@@ -45,6 +45,7 @@ struct Health : public IComponent
 	bool Serialize(Serialization::IArchive& archive) override final
 	{
 		archive(health, "health", "health");
+		archive(isDead, "isDead", "isDead");
 
 		return true;
 	}
@@ -156,6 +157,8 @@ struct DamageOverTime : public IComponent
 		archive(damageType, "damageType", "Damage Type");
 		archive(duration, "duration", "duration");
 		archive(interval, "interval", "interval");
+		archive(nextTickTime, "nextTickTime", "nextTickTime");
+		archive(ticksRemaining, "ticksRemaining", "ticksRemaining");
 
 		return true;
 	}
@@ -172,8 +175,8 @@ struct DamageOverTime : public IComponent
 	/** The ticks need to occur at this interval. */
 	float interval {1.0f};
 
-	/** Gametime passed since the last tick. */
-	float deltaSinceTick {0.0f};
+	/** Simulation time at which the next tick is due. Managed by the timer wheel for this component type. */
+	double nextTickTime {0.0};
 
 	/** Ticks remaining. */
 	float ticksRemaining {duration / interval};
@@ -272,6 +275,8 @@ struct HealOverTime : public IComponent
 		archive(quantity, "quantity", "quantity");
 		archive(duration, "duration", "duration");
 		archive(interval, "interval", "interval");
+		archive(nextTickTime, "nextTickTime", "nextTickTime");
+		archive(ticksRemaining, "ticksRemaining", "ticksRemaining");
 
 		return true;
 	}
@@ -285,8 +290,8 @@ struct HealOverTime : public IComponent
 	/** The ticks need to occur at this interval. */
 	float interval {1.0f};
 
-	/** Gametime passed since the last tick. */
-	float deltaSinceTick {0.0f};
+	/** Simulation time at which the next tick is due. Managed by the timer wheel for this component type. */
+	double nextTickTime {0.0};
 
 	/** Ticks remaining. */
 	float ticksRemaining {duration / interval};
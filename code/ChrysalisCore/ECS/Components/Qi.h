@@ -147,6 +147,8 @@ struct UtiliseQiOverTime : public IComponent
 		archive(quantity, "quantity", "quantity");
 		archive(duration, "duration", "duration");
 		archive(interval, "interval", "interval");
+		archive(nextTickTime, "nextTickTime", "nextTickTime");
+		archive(ticksRemaining, "ticksRemaining", "ticksRemaining");
 
 		return true;
 	}
@@ -160,8 +162,8 @@ struct UtiliseQiOverTime : public IComponent
 	/** The damage ticks need to occur at this interval. */
 	float interval {1.0f};
 
-	/** Gametime passed since the last tick. */
-	float deltaSinceTick {0.0f};
+	/** Simulation time at which the next tick is due. Managed by the timer wheel for this component type. */
+	double nextTickTime {0.0};
 
 	/** Ticks remaining. */
 	float ticksRemaining {duration / interval};
@@ -260,6 +262,8 @@ struct ReplenishQiOverTime : public IComponent
 		archive(quantity, "quantity", "quantity");
 		archive(duration, "duration", "duration");
 		archive(interval, "interval", "interval");
+		archive(nextTickTime, "nextTickTime", "nextTickTime");
+		archive(ticksRemaining, "ticksRemaining", "ticksRemaining");
 
 		return true;
 	}
@@ -273,8 +277,8 @@ struct ReplenishQiOverTime : public IComponent
 	/** The ticks need to occur at this interval. */
 	float interval {1.0f};
 
-	/** Gametime passed since the last tick. */
-	float deltaSinceTick {0.0f};
+	/** Simulation time at which the next tick is due. Managed by the timer wheel for this component type. */
+	double nextTickTime {0.0};
 
 	/** Ticks remaining. */
 	float ticksRemaining {duration / interval};
@@ -77,4 +77,54 @@ struct Spell : public IComponent
 	/** Maximum range at which this can be cast. */
 	float range;
 };
+
+
+/** Spell instances keep a reference back to the prototype they were cast from. Immutable spell data such as the name and
+	spell component are shared through this reference rather than being copied onto each instance. */
+struct SpellPrototype : public IComponent
+{
+	SpellPrototype() = default;
+	virtual ~SpellPrototype() = default;
+
+	SpellPrototype(entt::entity prototypeEntity) :
+		prototypeEntity(prototypeEntity)
+	{
+	}
+
+	inline bool operator==(const SpellPrototype& rhs) const { return 0 == memcmp(this, &rhs, sizeof(rhs)); }
+
+
+	const CryGUID& GetGuid() const override final
+	{
+		static CryGUID guid = "{6C1D5D0E-3B5F-4F31-9E0A-2C7B8A4E91D3}"_cry_guid;
+
+		return guid;
+	}
+
+
+	virtual const entt::hashed_string& GetHashedName() const
+	{
+		static constexpr entt::hashed_string nameHS {"spell-prototype"_hs};
+
+		return nameHS;
+	}
+
+
+	static void ReflectType(Schematyc::CTypeDesc<SpellPrototype>& desc)
+	{
+		desc.SetGUID(SpellPrototype().GetGuid());
+		desc.SetLabel("SpellPrototype");
+		desc.SetDescription("SpellPrototype");
+	}
+
+
+	bool Serialize(Serialization::IArchive& archive) override final
+	{
+		// The prototype entity belongs to the spell registry, so there's nothing meaningful to serialise.
+		return true;
+	}
+
+	/** The prototype entity in the spell registry. */
+	entt::entity prototypeEntity {entt::null};
+};
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <StdAfx.h>
+
+#include "AttributeDeltas.h"
+
+
+namespace Chrysalis::ECS
+{
+void CAttributeAggregator::Reduce(const SAttributeDeltas& decreases, const SAttributeDeltas& increases)
+{
+	m_deltas.clear();
+	m_deltas.reserve(decreases.Size() + increases.Size());
+
+	// Decreases go first so that the summation order matches the order they would have been applied in.
+	for (size_t i = 0; i < decreases.Size(); ++i)
+		m_deltas.push_back({decreases.targets[i], -decreases.amounts[i], 0.0f});
+
+	for (size_t i = 0; i < increases.Size(); ++i)
+		m_deltas.push_back({increases.targets[i], increases.amounts[i], 1.0f});
+
+	// A stable sort keeps the summation order fixed for each target, so the results are deterministic.
+	std::stable_sort(m_deltas.begin(), m_deltas.end(), [](const SDelta& lhs, const SDelta& rhs)
+	{
+		return lhs.target < rhs.target;
+	});
+
+	m_targets.clear();
+	m_totals.clear();
+	m_clampMasks.clear();
+	for (auto& delta : m_deltas)
+	{
+		if (m_targets.empty() || (m_targets.back() != delta.target))
+		{
+			m_targets.push_back(delta.target);
+			m_totals.push_back(0.0f);
+			m_clampMasks.push_back(0.0f);
+		}
+
+		m_totals.back() += delta.amount;
+		m_clampMasks.back() = std::max(m_clampMasks.back(), delta.clampMask);
+	}
+}
+
+
+void CAttributeAggregator::ApplyTotals()
+{
+	const size_t count = m_modifiers.size();
+	float* __restrict modifiers = m_modifiers.data();
+	const float* __restrict totals = m_totals.data();
+	const float* __restrict clampMasks = m_clampMasks.data();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		// Clamping removes anything above zero, but only when the mask is set.
+		const float modifier = modifiers[i] + totals[i];
+		modifiers[i] = modifier - clampMasks[i] * std::max(modifier, 0.0f);
+	}
+}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include "ECS/Components/Components.h"
+
+
+namespace Chrysalis::ECS
+{
+/** A flat list of pending changes to an attribute's modifiers, kept as parallel arrays. Systems gather their changes here
+	instead of reaching into the target's components, and the whole lot is applied in one pass later in the phase. */
+
+struct SAttributeDeltas
+{
+	void Add(entt::entity target, float amount)
+	{
+		targets.push_back(target);
+		amounts.push_back(amount);
+	}
+
+
+	void Clear()
+	{
+		targets.clear();
+		amounts.clear();
+	}
+
+
+	size_t Size() const { return targets.size(); }
+
+	/** The entity whose attribute is changing. */
+	std::vector<entt::entity> targets;
+
+	/** The size of the change. Always positive, the direction is given by the list it is in. */
+	std::vector<float> amounts;
+};
+
+
+/** Applies gathered attribute deltas. All the decreases and increases for a target are reduced into a single total, and
+	then applied to the target's modifiers in a tight loop over contiguous arrays.
+
+	Decreases are applied before increases, and if there were any increases the result is clamped so the modifier never
+	goes above zero. This gives the same result as applying each of the deltas one at a time in that order. */
+
+class CAttributeAggregator
+{
+public:
+	/** Applies the deltas to an attribute on the Component held by each target, then clears them ready for the next
+	phase. getAttribute is given the component and must return a reference to the AttributeType<float> to modify. */
+	template<typename Component, typename GetAttribute>
+	void Apply(entt::registry& registry, SAttributeDeltas& decreases, SAttributeDeltas& increases, GetAttribute&& getAttribute)
+	{
+		if ((decreases.Size() == 0) && (increases.Size() == 0))
+		{
+			m_targets.clear();
+			return;
+		}
+
+		Reduce(decreases, increases);
+
+		// Gather the current modifiers. Each target is only looked up once, no matter how many deltas it received.
+		m_modifiers.resize(m_targets.size());
+		m_modifierAddresses.resize(m_targets.size());
+		for (size_t i = 0; i < m_targets.size(); ++i)
+		{
+			auto& attribute = getAttribute(registry.get<Component>(m_targets[i]));
+			m_modifierAddresses[i] = &attribute.modifiers;
+			m_modifiers[i] = attribute.modifiers;
+		}
+
+		ApplyTotals();
+
+		// Scatter them back.
+		for (size_t i = 0; i < m_modifiers.size(); ++i)
+			*m_modifierAddresses[i] = m_modifiers[i];
+
+		decreases.Clear();
+		increases.Clear();
+	}
+
+	/** The targets which were changed by the last call to Apply. */
+	const std::vector<entt::entity>& GetTargets() const { return m_targets; }
+
+private:
+	/** Sorts the deltas by target and sums them, filling m_targets, m_totals and m_clampMasks. */
+	void Reduce(const SAttributeDeltas& decreases, const SAttributeDeltas& increases);
+
+	/** Adds the totals to the modifiers and applies the clamping. This is branch free so it vectorises well. */
+	void ApplyTotals();
+
+	struct SDelta
+	{
+		entt::entity target;
+		float amount;
+		float clampMask;
+	};
+
+	/** Every delta, ready for sorting. Kept as members to avoid allocating each frame. */
+	std::vector<SDelta> m_deltas;
+
+	/** One entry for each unique target. */
+	std::vector<entt::entity> m_targets;
+	std::vector<float> m_totals;
+	std::vector<float> m_clampMasks;
+	std::vector<float> m_modifiers;
+	std::vector<float*> m_modifierAddresses;
+};
+}
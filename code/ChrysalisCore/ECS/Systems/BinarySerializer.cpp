@@ -0,0 +1,177 @@
+#include <StdAfx.h>
+
+#include "BinarySerializer.h"
+#include "ECS/Components/Components.h"
+#include <CrySystem/File/ICryPak.h>
+
+
+namespace Chrysalis::ECS
+{
+void SerialiseECSBinary::AddRecord(uint32 typeId, uint32 entityIndex, const IComponent& component)
+{
+	auto block = std::find_if(m_blocks.begin(), m_blocks.end(), [typeId](const SBlock& block) { return block.typeId == typeId; });
+	if (block == m_blocks.end())
+	{
+		m_blocks.push_back({typeId});
+		block = m_blocks.end() - 1;
+	}
+
+	m_recordBuffer.clear();
+	Serialization::SaveBinaryBuffer(m_recordBuffer, Serialization::SStruct(component));
+
+	block->entityIndices.push_back(entityIndex);
+	block->recordSizes.push_back(static_cast<uint32>(m_recordBuffer.size()));
+	block->data.insert(block->data.end(), m_recordBuffer.begin(), m_recordBuffer.end());
+}
+
+
+bool SerialiseECSBinary::SaveToFile(string fileName)
+{
+	FILE* pFile = gEnv->pCryPak->FOpen(fileName, "wb");
+	if (!pFile)
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Unable to open ECS snapshot for writing: %s", fileName.c_str());
+		return false;
+	}
+
+	BinarySnapshot::SHeader header {BinarySnapshot::magic, BinarySnapshot::version, m_entityCount,
+		static_cast<uint32>(m_blocks.size())};
+	gEnv->pCryPak->FWrite(&header, sizeof(header), 1, pFile);
+
+	for (auto& block : m_blocks)
+	{
+		BinarySnapshot::SBlockHeader blockHeader {block.typeId, static_cast<uint32>(block.entityIndices.size()),
+			static_cast<uint32>(block.data.size())};
+		gEnv->pCryPak->FWrite(&blockHeader, sizeof(blockHeader), 1, pFile);
+		gEnv->pCryPak->FWrite(block.entityIndices.data(), sizeof(uint32), block.entityIndices.size(), pFile);
+		gEnv->pCryPak->FWrite(block.recordSizes.data(), sizeof(uint32), block.recordSizes.size(), pFile);
+		gEnv->pCryPak->FWrite(block.data.data(), 1, block.data.size(), pFile);
+	}
+
+	gEnv->pCryPak->FClose(pFile);
+
+	return true;
+}
+
+
+bool LoadECSFromBinary(string fileName, entt::registry& registry)
+{
+	// Read the whole file in a single request, then work directly from the buffer.
+	FILE* pFile = gEnv->pCryPak->FOpen(fileName, "rb");
+	if (!pFile)
+		return false;
+
+	std::vector<char> buffer(gEnv->pCryPak->FGetSize(pFile));
+	const size_t bytesRead = gEnv->pCryPak->FReadRaw(buffer.data(), 1, buffer.size(), pFile);
+	gEnv->pCryPak->FClose(pFile);
+
+	const char* pCursor = buffer.data();
+	const char* pEnd = buffer.data() + bytesRead;
+
+	// Reads a value or array from the buffer, failing if there isn't enough data left.
+	auto read = [&pCursor, pEnd](void* pDestination, size_t size)
+	{
+		if (static_cast<size_t>(pEnd - pCursor) < size)
+			return false;
+
+		memcpy(pDestination, pCursor, size);
+		pCursor += size;
+
+		return true;
+	};
+
+	BinarySnapshot::SHeader header;
+	if (!read(&header, sizeof(header)) || (header.magic != BinarySnapshot::magic))
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Not an ECS snapshot: %s", fileName.c_str());
+		return false;
+	}
+
+	if (header.version != BinarySnapshot::version)
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS snapshot %s is version %u, expected version %u.",
+			fileName.c_str(), header.version, BinarySnapshot::version);
+		return false;
+	}
+
+	// The count comes straight from the file, so make sure it's believable before creating anything. Every entity needs
+	// at least a byte of the rest of the snapshot to describe it.
+	if (header.entityCount > static_cast<size_t>(pEnd - pCursor))
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS snapshot %s is truncated or corrupt.", fileName.c_str());
+		return false;
+	}
+
+	// Create all the entities in one go.
+	std::vector<entt::entity> entities(header.entityCount);
+	registry.create(entities.begin(), entities.end());
+
+	// A snapshot which is cut short leaves nothing behind, rather than a partial set of entities.
+	auto fail = [&registry, &entities, &fileName]()
+	{
+		registry.destroy(entities.begin(), entities.end());
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS snapshot %s is truncated or corrupt.", fileName.c_str());
+
+		return false;
+	};
+
+	// References to other entities were written as their index.
+	auto remap = [&entities](entt::entity referenced)
+	{
+		const uint32 index = static_cast<uint32>(referenced);
+		return (index < entities.size()) ? entities[index] : static_cast<entt::entity>(entt::null);
+	};
+
+	std::vector<uint32> entityIndices;
+	std::vector<uint32> recordSizes;
+	for (uint32 blockIndex = 0; blockIndex < header.blockCount; ++blockIndex)
+	{
+		BinarySnapshot::SBlockHeader blockHeader;
+		if (!read(&blockHeader, sizeof(blockHeader)))
+			return fail();
+
+		// Check there's room for the entity indices and record sizes before making room for them.
+		if (static_cast<uint64>(blockHeader.recordCount) * 2 * sizeof(uint32) > static_cast<uint64>(pEnd - pCursor))
+			return fail();
+
+		entityIndices.resize(blockHeader.recordCount);
+		recordSizes.resize(blockHeader.recordCount);
+		if (!read(entityIndices.data(), sizeof(uint32) * entityIndices.size())
+			|| !read(recordSizes.data(), sizeof(uint32) * recordSizes.size())
+			|| (static_cast<size_t>(pEnd - pCursor) < blockHeader.dataSize))
+			return fail();
+
+		const char* pRecord = pCursor;
+		pCursor += blockHeader.dataSize;
+
+		// Resolve the type once for the whole block, rather than once for each component.
+		auto component = entt::resolve(blockHeader.typeId);
+		if (!component)
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS snapshot %s has an unknown component type %u.",
+				fileName.c_str(), blockHeader.typeId);
+			continue;
+		}
+
+		for (uint32 i = 0; i < blockHeader.recordCount; ++i)
+		{
+			// Records must stay inside the block.
+			if (recordSizes[i] > static_cast<size_t>(pCursor - pRecord))
+				return fail();
+
+			if (entityIndices[i] < entities.size())
+			{
+				// Uses the registry to construct a component, assign it to the entity, and then return a reference for us to use.
+				auto any = component.construct(entities[entityIndices[i]], &registry);
+				auto& iComponent = any.cast<ECS::IComponent>();
+				Serialization::LoadBinaryBuffer(Serialization::SStruct(iComponent), pRecord, recordSizes[i]);
+				iComponent.RemapEntities(remap);
+			}
+
+			pRecord += recordSizes[i];
+		}
+	}
+
+	return true;
+}
+}
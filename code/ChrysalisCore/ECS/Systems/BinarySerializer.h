@@ -0,0 +1,145 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <CrySerialization/IArchiveHost.h>
+
+
+namespace Chrysalis::ECS
+{
+struct IComponent;
+
+/** The binary snapshot is a compact, versioned alternative to the XML format. XML remains the authoring format, the
+	binary one is meant for save games and handing state between servers.
+
+	The layout is columnar, with one block for each component type:
+
+		header		magic, version, entity count, block count
+		block		component hashed name, record count, data size
+					entity index for each record
+					byte size of each record
+					record data
+
+	Components are identified by the same hashed names used as tags in the XML files, so anything which can be loaded
+	from XML can be loaded from a snapshot. Entity indices refer to the order entities were written in, and fresh
+	entities are created on loading. References from one component to another entity are written as that entity's
+	index too. */
+
+namespace BinarySnapshot
+{
+static constexpr uint32 magic {0x53434543};	// 'CECS'
+static constexpr uint32 version {1};
+
+struct SHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 entityCount;
+	uint32 blockCount;
+};
+
+struct SBlockHeader
+{
+	uint32 typeId;
+	uint32 recordCount;
+	uint32 dataSize;
+};
+
+
+/** Delta snapshots share the record format, but hold only the components which changed between two versions:
+
+		header		magic, version, baseline version, current version, block count
+		block		component hashed name, record count, data size
+					source entity for each record
+					byte size of each record, or removedRecord if the component was removed
+					record data
+
+	Entities are identified by their identifier in the source registry, since a delta refers to entities which were
+	written out by earlier snapshots. */
+
+static constexpr uint32 deltaMagic {0x44434543};	// 'CECD'
+static constexpr uint32 removedRecord {0xFFFFFFFF};
+
+struct SDeltaHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint64 baseline;
+	uint64 current;
+	uint32 blockCount;
+};
+}
+
+
+// Loads the entities and components from a binary snapshot file. If the file is truncated or corrupt, any entities it
+// created are destroyed again and false is returned.
+bool LoadECSFromBinary(string fileName, entt::registry& registry);
+
+
+// Used by ECS snapshot code to write a registry out in the binary snapshot format.
+
+struct SerialiseECSBinary
+{
+	// Input.
+	template<typename Type>
+	void operator()(entt::entity& entity, Type& component)
+	{
+	}
+
+
+	// Output.
+	void operator()(unsigned int count)
+	{
+		// Called with the number of entities or components which are about to follow. We don't need it.
+	}
+
+
+	void operator()(entt::entity entity)
+	{
+		m_entityIndices[entity] = m_entityCount++;
+	}
+
+
+	template<typename Type>
+	void operator()(entt::entity entity, const Type& component)
+	{
+		auto it = m_entityIndices.find(entity);
+		if (it == m_entityIndices.end())
+			return;
+
+		// References to other entities are written as their index, which is how the loader knows them.
+		Type copy = component;
+		copy.RemapEntities([this](entt::entity referenced)
+		{
+			auto found = m_entityIndices.find(referenced);
+			return (found != m_entityIndices.end()) ? static_cast<entt::entity>(found->second) : static_cast<entt::entity>(entt::null);
+		});
+
+		AddRecord(component.GetHashedName().value(), it->second, copy);
+	}
+
+
+	bool SaveToFile(string fileName);
+
+private:
+	struct SBlock
+	{
+		uint32 typeId;
+		std::vector<uint32> entityIndices;
+		std::vector<uint32> recordSizes;
+		DynArray<char> data;
+	};
+
+	/** Serialise the component into the block for it's type. */
+	void AddRecord(uint32 typeId, uint32 entityIndex, const IComponent& component);
+
+	/** Blocks are kept in the order their component types were first seen. */
+	std::vector<SBlock> m_blocks;
+
+	/** Index for each entity, in the order they were written. */
+	std::unordered_map<entt::entity, uint32> m_entityIndices;
+	uint32 m_entityCount {0};
+
+	/** Scratch buffer for serialising a single record. */
+	DynArray<char> m_recordBuffer;
+};
+}
@@ -0,0 +1,41 @@
+#include <StdAfx.h>
+
+#include "CommandBuffer.h"
+
+
+namespace Chrysalis::ECS
+{
+void CCommandBuffer::Playback(entt::registry& registry)
+{
+	if (m_commandCount == 0)
+		return;
+
+	for (auto& batch : m_assignBatches)
+		batch->Playback(registry);
+
+	for (auto& batch : m_removeBatches)
+		batch->Playback(registry);
+
+	for (auto entity : m_destroyedEntities)
+	{
+		// The same entity might have been destroyed by more than one command.
+		if (registry.valid(entity))
+			registry.destroy(entity);
+	}
+
+	Clear();
+}
+
+
+void CCommandBuffer::Clear()
+{
+	for (auto& batch : m_assignBatches)
+		batch->Clear();
+
+	for (auto& batch : m_removeBatches)
+		batch->Clear();
+
+	m_destroyedEntities.clear();
+	m_commandCount = 0;
+}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+
+namespace Chrysalis::ECS
+{
+/** Records structural changes to a registry so they can be made later, at a sync point. Systems must not add or remove
+	components while they are iterating a view, or while other systems might be running on another thread, so instead
+	they record the change here and the scheduler plays it back once the phase is complete.
+
+	Commands are kept in batches, one for each kind of command and component type. Playback runs the batches in the order
+	they were first used, applying all the adds, then all the removes, and finally destroying any entities. The batches
+	keep their memory between frames, so once warmed up, recording a command doesn't need to allocate. */
+
+class CCommandBuffer
+{
+public:
+	CCommandBuffer() = default;
+	CCommandBuffer(const CCommandBuffer&) = delete;
+	CCommandBuffer(CCommandBuffer&&) = default;
+	CCommandBuffer& operator=(const CCommandBuffer&) = delete;
+	CCommandBuffer& operator=(CCommandBuffer&&) = default;
+
+	/** Assign a component to an entity, replacing it if the entity already has one. */
+	template<typename Component>
+	void Assign(entt::entity entity, Component component)
+	{
+		GetBatch<Component, CAssignBatch<Component>>(m_assignBatches).commands.emplace_back(entity, std::move(component));
+		++m_commandCount;
+	}
+
+
+	/** Remove a component from an entity. It isn't an error if the entity no longer has the component at playback. */
+	template<typename Component>
+	void Remove(entt::entity entity)
+	{
+		GetBatch<Component, CRemoveBatch<Component>>(m_removeBatches).entities.push_back(entity);
+		++m_commandCount;
+	}
+
+
+	/** Destroy an entity, along with all of it's components. */
+	void Destroy(entt::entity entity)
+	{
+		m_destroyedEntities.push_back(entity);
+		++m_commandCount;
+	}
+
+
+	/** Make all the recorded changes to the registry and then clear the buffer, ready to be used again. */
+	void Playback(entt::registry& registry);
+
+	/** Throw away any recorded commands without making the changes. */
+	void Clear();
+
+	/** The number of commands which are waiting for playback. */
+	size_t GetCommandCount() const { return m_commandCount; }
+
+	/** Is the buffer empty? */
+	bool IsEmpty() const { return m_commandCount == 0; }
+
+private:
+	struct ICommandBatch
+	{
+		virtual ~ICommandBatch() = default;
+
+		virtual void Playback(entt::registry& registry) = 0;
+		virtual void Clear() = 0;
+
+		/** The hashed name of the component type this batch handles. */
+		entt::hashed_string::hash_type typeId;
+	};
+
+
+	template<typename Component>
+	struct CAssignBatch : public ICommandBatch
+	{
+		void Playback(entt::registry& registry) override
+		{
+			for (auto& [entity, component] : commands)
+			{
+				if (registry.valid(entity))
+					registry.assign_or_replace<Component>(entity, std::move(component));
+			}
+		}
+
+
+		void Clear() override { commands.clear(); }
+
+		std::vector<std::pair<entt::entity, Component>> commands;
+	};
+
+
+	template<typename Component>
+	struct CRemoveBatch : public ICommandBatch
+	{
+		void Playback(entt::registry& registry) override
+		{
+			for (auto entity : entities)
+			{
+				if (registry.valid(entity) && registry.has<Component>(entity))
+					registry.remove<Component>(entity);
+			}
+		}
+
+
+		void Clear() override { entities.clear(); }
+
+		std::vector<entt::entity> entities;
+	};
+
+
+	/** Find the batch for this component type, creating it if this is the first time it has been used. There are only a
+	handful of component types in use by any one system, so a linear search is quicker than anything fancier. */
+	template<typename Component, typename Batch>
+	Batch& GetBatch(std::vector<std::unique_ptr<ICommandBatch>>& batches)
+	{
+		static const auto typeId = Component().GetHashedName().value();
+
+		for (auto& batch : batches)
+		{
+			if (batch->typeId == typeId)
+				return static_cast<Batch&>(*batch);
+		}
+
+		auto batch = std::make_unique<Batch>();
+		batch->typeId = typeId;
+		batches.push_back(std::move(batch));
+
+		return static_cast<Batch&>(*batches.back());
+	}
+
+	std::vector<std::unique_ptr<ICommandBatch>> m_assignBatches;
+	std::vector<std::unique_ptr<ICommandBatch>> m_removeBatches;
+	std::vector<entt::entity> m_destroyedEntities;
+	size_t m_commandCount {0};
+};
+}
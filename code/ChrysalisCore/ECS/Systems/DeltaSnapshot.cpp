@@ -0,0 +1,322 @@
+#include <StdAfx.h>
+
+#include "DeltaSnapshot.h"
+#include "ECS/Components/Components.h"
+#include "ECS/Systems/BinarySerializer.h"
+#include <CrySystem/File/ICryPak.h>
+
+
+namespace Chrysalis::ECS
+{
+void CChangeTracker::Disconnect()
+{
+	if (m_pRegistry)
+	{
+		for (auto& type : m_types)
+			type.disconnect(*m_pRegistry, *this);
+
+		m_pRegistry = nullptr;
+	}
+
+	m_types.clear();
+	m_version = 1;
+}
+
+
+CChangeTracker::STrackedType* CChangeTracker::FindType(uint32 typeId)
+{
+	auto it = std::find_if(m_types.begin(), m_types.end(), [typeId](const STrackedType& type) { return type.handlers.typeId == typeId; });
+
+	return it != m_types.end() ? &*it : nullptr;
+}
+
+
+void CChangeTracker::Stamp(STrackedType& type, entt::entity entity)
+{
+	// Only log the first change to an entity in each version, later ones in the same version add nothing.
+	auto& version = type.versions[entity];
+	if (version != m_version)
+	{
+		version = m_version;
+		type.log.push_back({m_version, entity});
+	}
+}
+
+
+uint64 CChangeTracker::WriteDelta(uint64 baseline, DynArray<char>& buffer)
+{
+	const uint64 current = Checkpoint();
+
+	buffer.clear();
+	auto write = [&buffer](const void* pData, size_t size)
+	{
+		auto pBytes = static_cast<const char*>(pData);
+		buffer.insert(buffer.end(), pBytes, pBytes + size);
+	};
+
+	BinarySnapshot::SDeltaHeader header {BinarySnapshot::deltaMagic, BinarySnapshot::version, baseline, current, 0};
+	const size_t headerOffset = buffer.size();
+	write(&header, sizeof(header));
+
+	std::vector<uint32> entities;
+	std::vector<uint32> recordSizes;
+	DynArray<char> data;
+	DynArray<char> record;
+	for (auto& type : m_types)
+	{
+		entities.clear();
+		recordSizes.clear();
+		data.clear();
+
+		// The log is in version order, so we can skip straight to the first change after the baseline.
+		auto first = std::upper_bound(type.log.begin(), type.log.end(), baseline,
+			[](uint64 version, const SChange& change) { return version < change.version; });
+
+		for (auto it = first; it != type.log.end(); ++it)
+		{
+			// Skip entries which have been superseded by a later change.
+			if (type.versions[it->entity] != it->version)
+				continue;
+
+			entities.push_back(static_cast<uint32>(it->entity));
+			if (auto pComponent = m_pRegistry->valid(it->entity) ? type.handlers.find(*m_pRegistry, it->entity) : nullptr)
+			{
+				record.clear();
+				Serialization::SaveBinaryBuffer(record, Serialization::SStruct(*pComponent));
+				recordSizes.push_back(static_cast<uint32>(record.size()));
+				data.insert(data.end(), record.begin(), record.end());
+			}
+			else
+			{
+				recordSizes.push_back(BinarySnapshot::removedRecord);
+			}
+		}
+
+		if (entities.empty())
+			continue;
+
+		BinarySnapshot::SBlockHeader blockHeader {type.handlers.typeId, static_cast<uint32>(entities.size()),
+			static_cast<uint32>(data.size())};
+		write(&blockHeader, sizeof(blockHeader));
+		write(entities.data(), sizeof(uint32) * entities.size());
+		write(recordSizes.data(), sizeof(uint32) * recordSizes.size());
+		write(data.data(), data.size());
+		++header.blockCount;
+	}
+
+	// Now we know how many blocks there are.
+	memcpy(buffer.data() + headerOffset, &header, sizeof(header));
+
+	return current;
+}
+
+
+uint64 CChangeTracker::SaveDelta(uint64 baseline, string fileName)
+{
+	DynArray<char> buffer;
+	const uint64 current = WriteDelta(baseline, buffer);
+
+	FILE* pFile = gEnv->pCryPak->FOpen(fileName, "wb");
+	if (!pFile)
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Unable to open ECS delta for writing: %s", fileName.c_str());
+		return 0;
+	}
+
+	gEnv->pCryPak->FWrite(buffer.data(), 1, buffer.size(), pFile);
+	gEnv->pCryPak->FClose(pFile);
+
+	return current;
+}
+
+
+void CChangeTracker::Compact(uint64 oldestBaseline)
+{
+	for (auto& type : m_types)
+	{
+		auto last = std::upper_bound(type.log.begin(), type.log.end(), oldestBaseline,
+			[](uint64 version, const SChange& change) { return version < change.version; });
+		type.log.erase(type.log.begin(), last);
+
+		for (auto it = type.versions.begin(); it != type.versions.end();)
+		{
+			if (it->second <= oldestBaseline)
+				it = type.versions.erase(it);
+			else
+				++it;
+		}
+	}
+}
+
+
+void CDeltaSnapshotApplier::RegisterType(const SComponentHandlers& handlers)
+{
+	auto it = std::find_if(m_types.begin(), m_types.end(), [&handlers](const SComponentHandlers& type) { return type.typeId == handlers.typeId; });
+	if (it == m_types.end())
+		m_types.push_back(handlers);
+}
+
+
+entt::entity CDeltaSnapshotApplier::GetEntity(uint32 sourceEntity, entt::registry& registry)
+{
+	auto it = m_entities.find(sourceEntity);
+	if ((it != m_entities.end()) && registry.valid(it->second))
+		return it->second;
+
+	auto entity = registry.create();
+	m_entities[sourceEntity] = entity;
+
+	return entity;
+}
+
+
+bool CDeltaSnapshotApplier::Apply(const char* pData, size_t size, entt::registry& registry)
+{
+	const char* pCursor = pData;
+	const char* pEnd = pData + size;
+
+	// Reads a value or array from the buffer, failing if there isn't enough data left.
+	auto read = [&pCursor, pEnd](void* pDestination, size_t size)
+	{
+		if (static_cast<size_t>(pEnd - pCursor) < size)
+			return false;
+
+		memcpy(pDestination, pCursor, size);
+		pCursor += size;
+
+		return true;
+	};
+
+	BinarySnapshot::SDeltaHeader header;
+	if (!read(&header, sizeof(header)) || (header.magic != BinarySnapshot::deltaMagic)
+		|| (header.version != BinarySnapshot::version))
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Not an ECS delta snapshot, or the wrong version.");
+		return false;
+	}
+
+	if (header.baseline > m_version)
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS delta snapshot starts at version %" PRIu64 ", but we only have up to version %" PRIu64 ".",
+			header.baseline, m_version);
+		return false;
+	}
+
+	// Walks the blocks, checking each fits in the buffer before handing it to blockFunction. The counts come straight from
+	// the buffer, so they are checked against what's left before anything is sized from them.
+	std::vector<uint32> entities;
+	std::vector<uint32> recordSizes;
+	const char* pBlocks = pCursor;
+	auto forEachBlock = [&](auto&& blockFunction)
+	{
+		pCursor = pBlocks;
+		for (uint32 blockIndex = 0; blockIndex < header.blockCount; ++blockIndex)
+		{
+			BinarySnapshot::SBlockHeader blockHeader;
+			if (!read(&blockHeader, sizeof(blockHeader))
+				|| (static_cast<uint64>(blockHeader.recordCount) * 2 * sizeof(uint32) > static_cast<uint64>(pEnd - pCursor)))
+				return false;
+
+			entities.resize(blockHeader.recordCount);
+			recordSizes.resize(blockHeader.recordCount);
+			if (!read(entities.data(), sizeof(uint32) * entities.size())
+				|| !read(recordSizes.data(), sizeof(uint32) * recordSizes.size())
+				|| (static_cast<size_t>(pEnd - pCursor) < blockHeader.dataSize))
+				return false;
+
+			// Records must stay inside the block.
+			uint64 recordBytes {0};
+			for (auto recordSize : recordSizes)
+			{
+				if (recordSize != BinarySnapshot::removedRecord)
+					recordBytes += recordSize;
+			}
+
+			if (recordBytes > blockHeader.dataSize)
+				return false;
+
+			blockFunction(blockHeader, pCursor);
+			pCursor += blockHeader.dataSize;
+		}
+
+		return true;
+	};
+
+	// Check the whole delta before touching the registry, so a bad one is rejected without being partly applied.
+	if (!forEachBlock([](const BinarySnapshot::SBlockHeader&, const char*) {}))
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS delta snapshot is truncated or corrupt.");
+		return false;
+	}
+
+	// References to other entities are by their identifier in the source registry, just like the records are.
+	auto remap = [this, &registry](entt::entity sourceEntity)
+	{
+		return (sourceEntity == entt::null) ? sourceEntity : GetEntity(static_cast<uint32>(sourceEntity), registry);
+	};
+
+	std::vector<std::pair<uint32, entt::entity>> removed;
+	forEachBlock([&](const BinarySnapshot::SBlockHeader& blockHeader, const char* pRecord)
+	{
+		auto type = std::find_if(m_types.begin(), m_types.end(), [&blockHeader](const SComponentHandlers& type) { return type.typeId == blockHeader.typeId; });
+		if (type == m_types.end())
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "ECS delta snapshot has an unregistered component type %u.", blockHeader.typeId);
+			return;
+		}
+
+		for (uint32 i = 0; i < blockHeader.recordCount; ++i)
+		{
+			if (recordSizes[i] == BinarySnapshot::removedRecord)
+			{
+				auto it = m_entities.find(entities[i]);
+				if ((it != m_entities.end()) && registry.valid(it->second))
+				{
+					type->remove(registry, it->second);
+					removed.push_back(*it);
+				}
+
+				continue;
+			}
+
+			type->load(registry, GetEntity(entities[i], registry), pRecord, recordSizes[i], remap);
+			pRecord += recordSizes[i];
+		}
+	});
+
+	// Entities which lost their last component are gone in the source registry.
+	for (auto& [sourceEntity, entity] : removed)
+	{
+		if (registry.valid(entity) && registry.orphan(entity))
+		{
+			registry.destroy(entity);
+			m_entities.erase(sourceEntity);
+		}
+	}
+
+	m_version = std::max(m_version, header.current);
+
+	return true;
+}
+
+
+bool CDeltaSnapshotApplier::ApplyFromFile(string fileName, entt::registry& registry)
+{
+	FILE* pFile = gEnv->pCryPak->FOpen(fileName, "rb");
+	if (!pFile)
+		return false;
+
+	std::vector<char> buffer(gEnv->pCryPak->FGetSize(pFile));
+	const size_t bytesRead = gEnv->pCryPak->FReadRaw(buffer.data(), 1, buffer.size(), pFile);
+	gEnv->pCryPak->FClose(pFile);
+
+	return Apply(buffer.data(), bytesRead, registry);
+}
+
+
+void CDeltaSnapshotApplier::Reset()
+{
+	m_entities.clear();
+	m_version = 0;
+}
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <CrySerialization/IArchiveHost.h>
+
+
+namespace Chrysalis::ECS
+{
+struct IComponent;
+
+/** Type erased access to a single component type, so the delta code can work with a list of types chosen at runtime. */
+
+struct SComponentHandlers
+{
+	template<typename Component>
+	static SComponentHandlers Of()
+	{
+		return {Component().GetHashedName().value(), &Find<Component>, &Load<Component>, &Remove<Component>};
+	}
+
+
+	/** The component's hashed name. */
+	uint32 typeId;
+
+	/** Returns the component on the entity, or nullptr if it doesn't have one. */
+	const IComponent* (*find)(const entt::registry& registry, entt::entity entity);
+
+	/** Serialises a record into the entity's component, assigning it if needed. References to other entities are passed
+	through remap. */
+	void (*load)(entt::registry& registry, entt::entity entity, const char* pData, size_t size,
+		const std::function<entt::entity(entt::entity)>& remap);
+
+	/** Removes the component from the entity, if it has one. */
+	void (*remove)(entt::registry& registry, entt::entity entity);
+
+private:
+	template<typename Component>
+	static const IComponent* Find(const entt::registry& registry, entt::entity entity)
+	{
+		return registry.has<Component>(entity) ? &registry.get<Component>(entity) : nullptr;
+	}
+
+
+	template<typename Component>
+	static void Load(entt::registry& registry, entt::entity entity, const char* pData, size_t size,
+		const std::function<entt::entity(entt::entity)>& remap)
+	{
+		// Loading into a copy means listeners for the replace signal see the new values.
+		Component component;
+		Serialization::LoadBinaryBuffer(Serialization::SStruct(component), pData, size);
+		component.RemapEntities(remap);
+		registry.assign_or_replace<Component>(entity, component);
+	}
+
+
+	template<typename Component>
+	static void Remove(entt::registry& registry, entt::entity entity)
+	{
+		if (registry.has<Component>(entity))
+			registry.remove<Component>(entity);
+	}
+};
+
+
+/** Tracks which components have changed in a registry, so a delta snapshot can be written containing only the components
+	which changed since an earlier point. This keeps the cost of autosaves and replication in proportion to how much is
+	changing, rather than to the size of the world.
+
+	Every change is stamped with the current version. Calling Checkpoint returns that version and moves on to the next
+	one, so a delta written with the returned version as it's baseline will hold everything that changed after it. A
+	baseline of zero gives every tracked component.
+
+	Construction, replacement and removal are picked up from the registry's signals. Components which are changed in
+	place, through registry.get, don't raise a signal and must be marked with MarkChanged. */
+
+class CChangeTracker
+{
+public:
+	CChangeTracker() = default;
+	~CChangeTracker() { Disconnect(); }
+
+	CChangeTracker(const CChangeTracker&) = delete;
+	CChangeTracker& operator=(const CChangeTracker&) = delete;
+
+	/** Start tracking the component types in a registry. Components which already exist count as changed. */
+	template<typename... Components>
+	void Track(entt::registry& registry)
+	{
+		CRY_ASSERT_MESSAGE(!m_pRegistry || m_pRegistry == &registry, "A change tracker can only track a single registry.");
+		m_pRegistry = &registry;
+
+		(TrackType<Components>(registry), ...);
+	}
+
+
+	/** Disconnects from the registry and forgets every change. */
+	void Disconnect();
+
+	/** Mark a component which was changed in place. */
+	template<typename Component>
+	void MarkChanged(entt::entity entity)
+	{
+		static const uint32 typeId = Component().GetHashedName().value();
+
+		if (auto pType = FindType(typeId))
+			Stamp(*pType, entity);
+	}
+
+
+	/** Mark a number of components which were changed in place. */
+	template<typename Component, typename Iterator>
+	void MarkChanged(Iterator first, Iterator last)
+	{
+		static const uint32 typeId = Component().GetHashedName().value();
+
+		if (auto pType = FindType(typeId))
+		{
+			for (; first != last; ++first)
+				Stamp(*pType, *first);
+		}
+	}
+
+
+	/** The version new changes are being stamped with. */
+	uint64 GetVersion() const { return m_version; }
+
+	/** Closes off the current version and returns it. Use this as the baseline for the next delta. */
+	uint64 Checkpoint() { return m_version++; }
+
+	/** Writes every change made after the baseline into a delta snapshot. Returns the version the delta is current to,
+	which is also closed off, ready to use as the next baseline. */
+	uint64 WriteDelta(uint64 baseline, DynArray<char>& buffer);
+
+	/** Writes a delta snapshot to a file. Returns the version the delta is current to, or zero on failure. */
+	uint64 SaveDelta(uint64 baseline, string fileName);
+
+	/** Forget about changes which no delta will need again i.e. anything at or before the oldest baseline in use. */
+	void Compact(uint64 oldestBaseline);
+
+private:
+	struct SChange
+	{
+		uint64 version;
+		entt::entity entity;
+	};
+
+	struct STrackedType
+	{
+		SComponentHandlers handlers;
+		void (*disconnect)(entt::registry& registry, CChangeTracker& tracker);
+
+		/** Every change in version order. An entity will have an entry for each time it changed, so only the entry matching
+		it's latest version is used. */
+		std::vector<SChange> log;
+
+		/** The version of the latest change for each entity. */
+		std::unordered_map<entt::entity, uint64> versions;
+	};
+
+	template<typename Component>
+	void TrackType(entt::registry& registry)
+	{
+		const uint32 typeId = Component().GetHashedName().value();
+		if (FindType(typeId))
+			return;
+
+		m_types.push_back({SComponentHandlers::Of<Component>(), &DisconnectType<Component>});
+
+		registry.on_construct<Component>().template connect<&CChangeTracker::OnChanged<Component>>(this);
+		registry.on_replace<Component>().template connect<&CChangeTracker::OnChanged<Component>>(this);
+		registry.on_destroy<Component>().template connect<&CChangeTracker::OnRemoved<Component>>(this);
+
+		auto& type = m_types.back();
+		auto view = registry.view<Component>();
+		for (auto entity : view)
+			Stamp(type, entity);
+	}
+
+
+	template<typename Component>
+	static void DisconnectType(entt::registry& registry, CChangeTracker& tracker)
+	{
+		registry.on_construct<Component>().template disconnect<&CChangeTracker::OnChanged<Component>>(&tracker);
+		registry.on_replace<Component>().template disconnect<&CChangeTracker::OnChanged<Component>>(&tracker);
+		registry.on_destroy<Component>().template disconnect<&CChangeTracker::OnRemoved<Component>>(&tracker);
+	}
+
+
+	template<typename Component>
+	void OnChanged(entt::registry& registry, entt::entity entity, Component& component)
+	{
+		MarkChanged<Component>(entity);
+	}
+
+
+	template<typename Component>
+	void OnRemoved(entt::registry& registry, entt::entity entity)
+	{
+		// The removal is written out as a change to a component which no longer exists.
+		MarkChanged<Component>(entity);
+	}
+
+
+	STrackedType* FindType(uint32 typeId);
+
+	void Stamp(STrackedType& type, entt::entity entity);
+
+	entt::registry* m_pRegistry {nullptr};
+
+	/** Tracked types, in the order they were added. */
+	std::vector<STrackedType> m_types;
+
+	/** Version that new changes are stamped with. Starts at one, so a baseline of zero includes everything. */
+	uint64 m_version {1};
+};
+
+
+/** Applies delta snapshots written by a CChangeTracker to another registry. Entities are matched up by their identifier in
+	the source registry, and fresh entities are created the first time a source entity is seen. Entities which are left
+	without any components are destroyed.
+
+	Deltas must be applied in order. A delta whose baseline is later than the last version applied would leave a gap, and
+	is rejected. */
+
+class CDeltaSnapshotApplier
+{
+public:
+	/** Register the component types which can be applied. Records for any other types are skipped. */
+	template<typename... Components>
+	void Register()
+	{
+		(RegisterType(SComponentHandlers::Of<Components>()), ...);
+	}
+
+
+	/** Applies a delta snapshot held in memory. */
+	bool Apply(const char* pData, size_t size, entt::registry& registry);
+
+	/** Applies a delta snapshot from a file. */
+	bool ApplyFromFile(string fileName, entt::registry& registry);
+
+	/** The version the registry is current to. */
+	uint64 GetVersion() const { return m_version; }
+
+	/** Forget the mapping between entities, e.g. after clearing the registry. */
+	void Reset();
+
+private:
+	void RegisterType(const SComponentHandlers& handlers);
+
+	/** Find the entity for a source entity, creating one if this is the first time we have seen it. */
+	entt::entity GetEntity(uint32 sourceEntity, entt::registry& registry);
+
+	std::vector<SComponentHandlers> m_types;
+
+	/** Source entity identifier to our entity. */
+	std::unordered_map<uint32, entt::entity> m_entities;
+
+	/** Version of the last delta applied. */
+	uint64 m_version {0};
+};
+}
@@ -9,7 +9,9 @@
 #include "ECS/Components/Qi.h"
 #include "ECS/Components/Spell.h"
 #include "ECS/Systems/Systems.h"
+#include "ECS/Systems/BinarySerializer.h"
 #include "ECS/Systems/XMLSerializer.h"
+#include "Console/CVars.h"
 #include <entt/entt.hpp>
 #include "Crymath/Random.h"
 
@@ -28,99 +30,227 @@ namespace Chrysalis::ECS
 //}
 
 
-const entt::entity GetHero(entt::registry& registry)
+const entt::entity GetHero(CNameIndex& actorNames)
 {
-	auto view = registry.view<ECS::Name>();
+	return actorNames.Find("Hero"_hs);
+}
 
-	for (auto entity : view)
-	{
-		auto& name = view.get<ECS::Name>(entity);
 
-		if (strcmp(name.name, "Hero") == 0)
-		{
-			return entity;
-		}
-	}
-
-	// Failed to find it.
-	return entt::null;
+const entt::entity GetVillain(CNameIndex& actorNames)
+{
+	return actorNames.Find("Villain"_hs);
 }
 
 
-const entt::entity GetVillain(entt::registry& registry)
+void ECSSimulation::Init()
 {
-	auto view = registry.view<ECS::Name>();
-
-	for (auto entity : view)
-	{
-		auto& name = view.get<ECS::Name>(entity);
+	ECS::RegisterComponentsWithMeta();
+	m_actorNames.Connect(m_actorRegistry);
+	m_spellNames.Connect(m_spellRegistry);
+	ConnectTimers();
+	RegisterSystems();
+
+	// Spell prototypes refer to entities in the spell registry, which is rebuilt from data each session, so they can't be
+	// carried across by a delta and aren't tracked.
+	m_actorChanges.Track<ECS::Name,
+		ECS::Health, ECS::Damage, ECS::DamageOverTime, ECS::Heal, ECS::HealOverTime,
+		ECS::Qi, ECS::UtiliseQi, ECS::UtiliseQiOverTime, ECS::ReplenishQi, ECS::ReplenishQiOverTime,
+		ECS::Spell, ECS::SourceAndTarget,
+		ECS::ItemClass>(m_actorRegistry);
+	m_actorReplicaDeltas.Register<ECS::Name,
+		ECS::Health, ECS::Damage, ECS::DamageOverTime, ECS::Heal, ECS::HealOverTime,
+		ECS::Qi, ECS::UtiliseQi, ECS::UtiliseQiOverTime, ECS::ReplenishQi, ECS::ReplenishQiOverTime,
+		ECS::Spell, ECS::SourceAndTarget,
+		ECS::ItemClass>();
+}
 
-		if (strcmp(name.name, "Villain") == 0)
-		{
-			return entity;
-		}
-	}
 
-	// Failed to find it.
-	return entt::null;
+void ECSSimulation::ConnectTimers()
+{
+	// Components which are replaced e.g. by a command buffer or a delta snapshot need scheduling again, just like new ones.
+	auto connect = [this](auto overTimeComponent, CTimerWheel& timers)
+	{
+		using TComponent = decltype(overTimeComponent);
+		m_actorRegistry.on_construct<TComponent>().template connect<&CTimerWheel::OnConstruct<TComponent>>(&timers);
+		m_actorRegistry.on_replace<TComponent>().template connect<&CTimerWheel::OnReplace<TComponent>>(&timers);
+	};
+
+	connect(ECS::DamageOverTime {}, m_damageOverTimeTimers);
+	connect(ECS::HealOverTime {}, m_healOverTimeTimers);
+	connect(ECS::UtiliseQiOverTime {}, m_utiliseQiOverTimeTimers);
+	connect(ECS::ReplenishQiOverTime {}, m_replenishQiOverTimeTimers);
 }
 
 
-void ECSSimulation::Init()
+void ECSSimulation::RegisterSystems()
 {
-	ECS::RegisterComponentsWithMeta();
+	m_immediateScheduler.Clear();
+	m_tickScheduler.Clear();
+
+	// Deltas are gathered into buffers by one set of systems and applied by another, so they are declared as resources.
+	static constexpr entt::hashed_string healthDecreases {"health-decreases"_hs};
+	static constexpr entt::hashed_string healthIncreases {"health-increases"_hs};
+	static constexpr entt::hashed_string qiDecreases {"qi-decreases"_hs};
+	static constexpr entt::hashed_string qiIncreases {"qi-increases"_hs};
+
+	// The health and qi deltas are applied once all the systems which gather them have finished.
+	auto addApplyDeltaSystems = [this](CSystemScheduler& scheduler)
+	{
+		scheduler.AddSystem("ECS::SystemApplyHealthDeltas",
+			[this](float, entt::registry& registry, CCommandBuffer&) { ECS::SystemApplyHealthDeltas(registry, m_healthAggregator, m_healthDecreases, m_healthIncreases); },
+			SystemAccess().Writes<ECS::Health>().WritesResource(healthDecreases).WritesResource(healthIncreases));
+		scheduler.AddSystem("ECS::SystemApplyQiDeltas",
+			[this](float, entt::registry& registry, CCommandBuffer&) { ECS::SystemApplyQiDeltas(registry, m_qiAggregator, m_qiDecreases, m_qiIncreases); },
+			SystemAccess().Writes<ECS::Qi>().WritesResource(qiDecreases).WritesResource(qiIncreases));
+		scheduler.AddSystem("ECS::SystemHealthCheck",
+			[](float, entt::registry& registry, CCommandBuffer&) { ECS::SystemHealthCheck(registry); },
+			SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::Health>());
+	};
+
+	// Immediate systems. Each one gathers into it's own buffer, so they are all able to run alongside each other.
+	m_immediateScheduler.AddSystem("ECS::SystemApplyDamage",
+		[this](float, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyDamage(registry, commands, m_healthDecreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::Damage>().WritesResource(healthDecreases));
+	m_immediateScheduler.AddSystem("ECS::SystemApplyHeal",
+		[this](float, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyHeal(registry, commands, m_healthIncreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::Heal>().WritesResource(healthIncreases));
+	m_immediateScheduler.AddSystem("ECS::SystemApplyQiUtilisation",
+		[this](float, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyQiUtilisation(registry, commands, m_qiDecreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::UtiliseQi>().WritesResource(qiDecreases));
+	m_immediateScheduler.AddSystem("ECS::SystemApplyQiReplenishment",
+		[this](float, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyQiReplenishment(registry, commands, m_qiIncreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::ReplenishQi>().WritesResource(qiIncreases));
+	addApplyDeltaSystems(m_immediateScheduler);
+	m_immediateScheduler.Build();
+
+	// Tick systems.
+	m_tickScheduler.AddSystem("ECS::SystemApplyDamageOverTime",
+		[this](float deltaTime, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyDamageOverTime(deltaTime, registry, commands, m_damageOverTimeTimers, m_healthDecreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::DamageOverTime>().WritesResource(healthDecreases));
+	m_tickScheduler.AddSystem("ECS::SystemApplyHealOverTime",
+		[this](float deltaTime, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyHealOverTime(deltaTime, registry, commands, m_healOverTimeTimers, m_healthIncreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::HealOverTime>().WritesResource(healthIncreases));
+	m_tickScheduler.AddSystem("ECS::SystemApplyQiUtilisationOverTime",
+		[this](float deltaTime, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyQiUtilisationOverTime(deltaTime, registry, commands, m_utiliseQiOverTimeTimers, m_qiDecreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::UtiliseQiOverTime>().WritesResource(qiDecreases));
+	m_tickScheduler.AddSystem("ECS::SystemApplyQiReplenishmentOverTime",
+		[this](float deltaTime, entt::registry& registry, CCommandBuffer& commands) { ECS::SystemApplyQiReplenishmentOverTime(deltaTime, registry, commands, m_replenishQiOverTimeTimers, m_qiIncreases); },
+		SystemAccess().Reads<ECS::SourceAndTarget>().Writes<ECS::ReplenishQiOverTime>().WritesResource(qiIncreases));
+	addApplyDeltaSystems(m_tickScheduler);
+	m_tickScheduler.Build();
 }
 
 
 void ECSSimulation::Update(const float deltaTime)
 {
-	// Run the ticks no more often than this interval.
-	static const float tickInterval {0.5f};
-
-	// Track the amount of time that has gone since we last run the tick code.
-	static float passedTime {0.0f};
+	// Hand over any entities which have finished loading.
+	if (IsLoading())
+		UpdateLoading();
 
 	// Update the things which should be handled immediately e.g direct damage and heals.
 	UpdateImmediate(deltaTime);
 
-	// Check if we need to tick.
-	passedTime += deltaTime;
-	if (passedTime >= tickInterval)
+	// Perform as many ticks as are due, up to the limits set on the timestep. Ticks beyond those limits are handled by the
+	// timestep's overrun policy, which drops them by default, so a very slow frame loses those ticks rather than catching up.
+	m_tickTimestep.Advance(deltaTime, [this](float stepTime)
+	{
+		UpdateTick(stepTime);
+	});
+}
+
+
+void ECSSimulation::UpdateLoading()
+{
+	// Loaders are handled in order, so the budget goes to the oldest first.
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+	for (auto& loader : m_loaders)
 	{
-		// Perform a tick.
-		// HACK: NOTE: This is just an approximation of how much time has passed. It will always be out by almost a frame's
-		// worth of time. For now, it appears better to have the tick nice and steady, even if it lags behind reality a bit.
-		UpdateTick(tickInterval);
+		const float remainingBudget = m_loadingBudget - (gEnv->pTimer->GetAsyncTime() - startTime).GetSeconds();
+		if (remainingBudget <= 0.0f)
+			break;
 
-		// HACK: We decrement by the interval size, so it will catch up if we miss some frames.
-		passedTime -= tickInterval;
+		loader->Update(remainingBudget);
 	}
+
+	// Finished loaders are kept count of, so the progress doesn't go backwards when they leave the list.
+	const size_t loaderCount = m_loaders.size();
+	m_loaders.erase(std::remove_if(m_loaders.begin(), m_loaders.end(),
+		[](const std::unique_ptr<CStreamingRegistryLoader>& loader) { return loader->IsComplete(); }), m_loaders.end());
+	m_completedLoaders += loaderCount - m_loaders.size();
+
+	// That's the end of this loading session.
+	if (m_loaders.empty())
+		m_completedLoaders = 0;
 }
 
 
-void ECSSimulation::UpdateImmediate(const float deltaTime)
+float ECSSimulation::GetLoadingProgress() const
 {
-	// Simluate some direct heals and direct damage.
-	ECS::SystemApplyDamage(m_actorRegistry);
-	ECS::SystemApplyHeal(m_actorRegistry);
-	ECS::SystemHealthCheck(m_actorRegistry);
+	if (m_loaders.empty())
+		return 1.0f;
+
+	// Each loader in the session counts for the same share, whether it has finished or not.
+	float progress = static_cast<float>(m_completedLoaders);
+	for (auto& loader : m_loaders)
+		progress += loader->GetProgress();
+
+	return progress / (m_completedLoaders + m_loaders.size());
+}
+
+
+void ECSSimulation::FinishLoading()
+{
+	for (auto& loader : m_loaders)
+		loader->Finish();
+
+	m_loaders.clear();
+	m_completedLoaders = 0;
+}
 
-	// Simluate some direct qi use and replenishment.
-	ECS::SystemApplyQiUtilisation(m_actorRegistry);
-	ECS::SystemApplyQiReplenishment(m_actorRegistry);
+
+void ECSSimulation::UpdateImmediate(const float deltaTime)
+{
+	// Direct heals, damage, qi use and replenishment.
+	m_immediateScheduler.Execute(deltaTime, m_actorRegistry, g_cvars.m_ecsParallelSystems != 0);
+	MarkInPlaceChanges();
 }
 
 
 void ECSSimulation::UpdateTick(const float deltaTime)
 {
-	// Health ticks.
-	ECS::SystemApplyDamageOverTime(deltaTime, m_actorRegistry);
-	ECS::SystemApplyHealOverTime(deltaTime, m_actorRegistry);
-	ECS::SystemHealthCheck(m_actorRegistry);
+	// Health and qi ticks.
+	m_tickScheduler.Execute(deltaTime, m_actorRegistry, g_cvars.m_ecsParallelSystems != 0);
+	MarkInPlaceChanges();
+}
+
+
+void ECSSimulation::MarkInPlaceChanges()
+{
+	// Attributes are changed on the targets of the deltas.
+	auto& healthTargets = m_healthAggregator.GetTargets();
+	m_actorChanges.MarkChanged<ECS::Health>(healthTargets.begin(), healthTargets.end());
+	auto& qiTargets = m_qiAggregator.GetTargets();
+	m_actorChanges.MarkChanged<ECS::Qi>(qiTargets.begin(), qiTargets.end());
+
+	// Over-time components count down their ticks as they fire. The immediate update doesn't advance the wheels, so each
+	// list is cleared once marked, or the same ticks would be marked again.
+	auto markFired = [this](auto overTimeComponent, CTimerWheel& timers)
+	{
+		auto& fired = timers.GetLastFired();
+		m_actorChanges.MarkChanged<decltype(overTimeComponent)>(fired.begin(), fired.end());
+		timers.ClearLastFired();
+	};
+
+	markFired(ECS::DamageOverTime {}, m_damageOverTimeTimers);
+	markFired(ECS::HealOverTime {}, m_healOverTimeTimers);
+	markFired(ECS::UtiliseQiOverTime {}, m_utiliseQiOverTimeTimers);
+	markFired(ECS::ReplenishQiOverTime {}, m_replenishQiOverTimeTimers);
+}
+
 
-	// Qi ticks.
-	ECS::SystemApplyQiUtilisationOverTime(deltaTime, m_actorRegistry);
-	ECS::SystemApplyQiReplenishmentOverTime(deltaTime, m_actorRegistry);
+entt::entity ECSSimulation::InstantiateSpell(entt::entity spellPrototype)
+{
+	return m_spellPrototypes.Instantiate(m_spellRegistry, spellPrototype, m_actorRegistry);
 }
 
 
@@ -129,14 +259,15 @@ void ECSSimulation::LoadSimulationData()
 	//update(10, saveRegistry);
 	//update(saveRegistry);
 
-	// Load the actor registry.
-	ECS::LoadECSFromXML("chrysalis/parameters/items/test.xml", m_actorRegistry);
+	// Load the actor registry. The files are parsed in the background and the entities handed over a few at a time.
+	m_loaders.emplace_back(std::make_unique<CStreamingRegistryLoader>("chrysalis/parameters/items/test.xml", m_actorRegistry));
 
-	// Load the spell registry.
-	ECS::LoadECSFromXML("chrysalis/parameters/spells/spells.xml", m_spellRegistry);
+	// Load the spell registry. The prototypes can only be built once every spell is loaded.
+	m_loaders.emplace_back(std::make_unique<CStreamingRegistryLoader>("chrysalis/parameters/spells/spells.xml", m_spellRegistry,
+		true, [this](entt::registry& registry) { m_spellPrototypes.Build(registry); }));
 
-	//auto villain = GetVillain(m_actorRegistry);
-	//auto hero = GetHero(m_actorRegistry);
+	//auto villain = GetVillain(m_actorNames);
+	//auto hero = GetHero(m_actorNames);
 	//if ((hero != entt::null) && (villain != entt::null))
 	//{
 	//	// Health test data.
@@ -156,6 +287,9 @@ void ECSSimulation::LoadSimulationData()
 
 void ECSSimulation::SaveSimulationData()
 {
+	// Make sure we have everything before writing it out.
+	FinishLoading();
+
 	// Actor related.
 	ECS::SerialiseECS actorSerial;
 	m_actorRegistry.snapshot()
@@ -167,6 +301,17 @@ void ECSSimulation::SaveSimulationData()
 		ECS::ItemClass>(actorSerial);
 	actorSerial.SaveToFile("chrysalis/parameters/items/test-out-snapshot.xml");
 
+	// The binary snapshot is able to carry references between entities, so it includes who is affecting whom.
+	ECS::SerialiseECSBinary actorBinary;
+	m_actorRegistry.snapshot()
+		.entities(actorBinary)
+		.component<ECS::Name,
+		ECS::Health, ECS::Damage, ECS::DamageOverTime, ECS::Heal, ECS::HealOverTime,
+		ECS::Qi, ECS::UtiliseQi, ECS::UtiliseQiOverTime, ECS::ReplenishQi, ECS::ReplenishQiOverTime,
+		ECS::Spell, ECS::SourceAndTarget,
+		ECS::ItemClass>(actorBinary);
+	actorBinary.SaveToFile("chrysalis/parameters/items/test-out-snapshot.ecs");
+
 	// Spell prototypes.
 	ECS::SerialiseECS spellSerial;
 	m_spellRegistry.snapshot()
@@ -177,5 +322,46 @@ void ECSSimulation::SaveSimulationData()
 		ECS::Spell>(spellSerial);
 
 	spellSerial.SaveToFile("chrysalis/parameters/spells/spells-snapshot.xml");
+
+	ECS::SerialiseECSBinary spellBinary;
+	m_spellRegistry.snapshot()
+		.entities(spellBinary)
+		.component<ECS::Name,
+		ECS::Health, ECS::Damage, ECS::DamageOverTime, ECS::Heal, ECS::HealOverTime,
+		ECS::Qi, ECS::UtiliseQi, ECS::UtiliseQiOverTime, ECS::ReplenishQi, ECS::ReplenishQiOverTime,
+		ECS::Spell>(spellBinary);
+	spellBinary.SaveToFile("chrysalis/parameters/spells/spells-snapshot.ecs");
+
+	// Actor changes since the last save. Nothing older than this will be asked for again.
+	if (const uint64 version = m_actorChanges.SaveDelta(m_actorSaveVersion, "chrysalis/parameters/items/test-out-delta.ecsd"))
+	{
+		m_actorChanges.Compact(version);
+		m_actorSaveVersion = version;
+	}
+}
+
+
+bool ECSSimulation::LoadActorSnapshot(const char* fileName)
+{
+	// Anything still streaming in should arrive before the snapshot, as it would have when the snapshot was saved.
+	FinishLoading();
+
+	return LoadECSFromBinary(fileName, m_actorRegistry);
+}
+
+
+bool ECSSimulation::ApplyActorDelta(const char* fileName)
+{
+	return m_actorReplicaDeltas.ApplyFromFile(fileName, m_actorReplica);
+}
+
+
+void ECSSimulation::LogSystemBatches() const
+{
+	CryLogAlways("Immediate systems:");
+	m_immediateScheduler.LogBatches();
+
+	CryLogAlways("Tick systems:");
+	m_tickScheduler.LogBatches();
 }
 }
@@ -1,6 +1,14 @@
 #pragma once
 
 #include <entt/entt.hpp>
+#include "ECS/Systems/AttributeDeltas.h"
+#include "ECS/Systems/DeltaSnapshot.h"
+#include "ECS/Systems/FixedTimestep.h"
+#include "ECS/Systems/NameIndex.h"
+#include "ECS/Systems/SpellPrototypes.h"
+#include "ECS/Systems/StreamingLoader.h"
+#include "ECS/Systems/SystemScheduler.h"
+#include "ECS/Systems/TimerWheel.h"
 
 
 namespace Chrysalis::ECS
@@ -26,14 +34,116 @@ public:
 	/** Temporary function for testing the simulation during development. */
 	void SaveSimulationData();
 
+	/** Adds the entities from a binary snapshot to the actor registry. Nothing is added if the snapshot can't be read. */
+	bool LoadActorSnapshot(const char* fileName);
+
+	/** Applies a delta saved from the actor changes to the actor replica. Deltas need applying in the order they were
+	saved. Nothing is applied if the delta can't be read, or doesn't follow on from the last one. */
+	bool ApplyActorDelta(const char* fileName);
+
+	/** Writes the batches for the immediate and tick schedulers out to the log. */
+	void LogSystemBatches() const;
+
+	/** Are there any registries still being loaded? */
+	bool IsLoading() const { return !m_loaders.empty(); }
+
+	/** Progress through all the registries being loaded, in the range [0, 1]. Useful for loading screens. */
+	float GetLoadingProgress() const;
+
+	/** Complete any loading which is still in progress, no matter how long it takes. */
+	void FinishLoading();
+
 	/** Get a reference to the registry for actors. */
 	entt::registry* GetActorRegistry() { return &m_actorRegistry; }
 
 	/** Get a reference to the spell registry, which keeps prototypes for all the spells. */
 	entt::registry* GetSpellRegistry() { return &m_spellRegistry; }
 
+	/** Find an entity in the actor registry by it's name. Returns entt::null if there isn't one. */
+	entt::entity GetActorByName(const entt::hashed_string& name) { return m_actorNames.Find(name); }
+
+	/** Find a spell prototype in the spell registry by it's name. Returns entt::null if there isn't one. */
+	entt::entity GetSpellByName(const entt::hashed_string& name) { return m_spellNames.Find(name); }
+
+	/** Creates an instance of a spell prototype in the actor registry, ready to be rewired for the source and target.
+	Returns entt::null if the entity isn't a spell prototype. */
+	entt::entity InstantiateSpell(entt::entity spellPrototype);
+
+	/** The fixed timestep which drives the tick updates. Use this to configure the step size, catch-up limits and budget. */
+	CFixedTimestep& GetTickTimestep() { return m_tickTimestep; }
+
+	/** Tracks changes to the actor registry, for autosaves and replication. */
+	CChangeTracker& GetActorChanges() { return m_actorChanges; }
+
+	/** A copy of the actor registry, rebuilt from the saved deltas. */
+	entt::registry* GetActorReplica() { return &m_actorReplica; }
+
+	/** How far we are between the last tick and the next one, in the range [0, 1). Use this to interpolate presentation. */
+	float GetTickInterpolationAlpha() const { return m_tickTimestep.GetInterpolationAlpha(); }
+
 private:
+	/** Registers the systems with the schedulers, declaring which components each of them reads and writes. */
+	void RegisterSystems();
+
+	/** Connects the timer wheels to the actor registry, so new over-time components are scheduled for their first tick. */
+	void ConnectTimers();
+
+	/** Marks the components which the systems changed in place, since those changes don't raise any signals. */
+	void MarkInPlaceChanges();
+
 	entt::registry m_actorRegistry;
 	entt::registry m_spellRegistry;
+
+	/** Hands over a batch of loaded entities to the registries, within the loading budget. */
+	void UpdateLoading();
+
+	/** Registries which are still being loaded. */
+	std::vector<std::unique_ptr<CStreamingRegistryLoader>> m_loaders;
+
+	/** Loaders which have finished since the loading session started. A session ends when there are no loaders left. */
+	size_t m_completedLoaders {0};
+
+	/** Time we can spend each frame handing over loaded entities, in seconds. */
+	float m_loadingBudget {0.004f};
+
+	/** Name indices for each registry. */
+	CNameIndex m_actorNames;
+	CNameIndex m_spellNames;
+
+	/** Component lists for each of the spell prototypes, used when casting spells. */
+	CSpellPrototypes m_spellPrototypes;
+
+	/** Systems run during the immediate update. */
+	CSystemScheduler m_immediateScheduler;
+
+	/** Systems run during the tick update. */
+	CSystemScheduler m_tickScheduler;
+
+	/** Tick every half second, catching up by no more than four ticks, or 2ms of work, in a single frame. */
+	CFixedTimestep m_tickTimestep {0.5f, 4, 0.002f, EStepOverrunPolicy::drop};
+
+	/** Timer wheels for the over-time components. Each system has it's own wheel, so they are still free to run in parallel. */
+	CTimerWheel m_damageOverTimeTimers;
+	CTimerWheel m_healOverTimeTimers;
+	CTimerWheel m_utiliseQiOverTimeTimers;
+	CTimerWheel m_replenishQiOverTimeTimers;
+
+	/** Attribute changes gathered during a phase, waiting to be applied. */
+	SAttributeDeltas m_healthDecreases;
+	SAttributeDeltas m_healthIncreases;
+	SAttributeDeltas m_qiDecreases;
+	SAttributeDeltas m_qiIncreases;
+
+	/** Applies the gathered attribute changes. One for each attribute, so they are able to run in parallel. */
+	CAttributeAggregator m_healthAggregator;
+	CAttributeAggregator m_qiAggregator;
+
+	/** Changes to the actor registry, and the version it was last saved at. */
+	CChangeTracker m_actorChanges;
+	uint64 m_actorSaveVersion {0};
+
+	/** The actor registry as rebuilt from the deltas, and the applier which keeps track of how far along it is. */
+	entt::registry m_actorReplica;
+	CDeltaSnapshotApplier m_actorReplicaDeltas;
 };
 }
\ No newline at end of file
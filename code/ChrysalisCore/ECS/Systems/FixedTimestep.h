@@ -0,0 +1,130 @@
+#pragma once
+
+
+namespace Chrysalis::ECS
+{
+/** What to do with the backlog of steps when we run out of catch-up steps, or the time budget is exceeded. */
+enum class EStepOverrunPolicy
+{
+	drop,		// Throw away the whole steps we didn't have time for. The simulation falls behind wall time.
+	merge		// Run a single step which covers all the whole steps we didn't have time for. Systems are handed the longer step
+				// and must catch up on everything due within it e.g. the over-time effects apply every tick which came due.
+};
+
+
+/** A fixed timestep accumulator. Frame time is added to the accumulator and whole steps are taken from it. When frames
+	run long, several steps are taken to catch up, limited by a maximum number of steps and a time budget for each frame.
+	Whatever is left in the accumulator is reported as an interpolation alpha, so presentation can blend between the last
+	two steps. */
+
+class CFixedTimestep
+{
+public:
+	CFixedTimestep() = default;
+
+	CFixedTimestep(float stepSize, int maxCatchUpSteps, float timeBudget, EStepOverrunPolicy overrunPolicy) :
+		m_stepSize(std::max(stepSize, FLT_EPSILON)), m_maxCatchUpSteps(std::max(maxCatchUpSteps, 1)), m_timeBudget(timeBudget),
+		m_overrunPolicy(overrunPolicy)
+	{
+	}
+
+
+	/** Adds the frame time to the accumulator and calls stepFunction once for each step that is due. The step function
+	is passed the amount of time it should simulate, which is the step size unless steps were merged. */
+	template<typename StepFunction>
+	void Advance(float deltaTime, StepFunction&& stepFunction)
+	{
+		m_accumulator += deltaTime;
+		m_lastStepCount = 0;
+		m_lastOverrunSteps = 0;
+
+		const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+		while (m_accumulator >= m_stepSize)
+		{
+			// Check if we have run out of steps or time for this frame.
+			const bool isOverSteps = m_lastStepCount >= m_maxCatchUpSteps;
+			const bool isOverBudget = (m_timeBudget > 0.0f) && (m_lastStepCount > 0)
+				&& ((gEnv->pTimer->GetAsyncTime() - startTime).GetSeconds() >= m_timeBudget);
+
+			if (isOverSteps || isOverBudget)
+			{
+				HandleOverrun(stepFunction);
+				break;
+			}
+
+			stepFunction(m_stepSize);
+			m_accumulator -= m_stepSize;
+			++m_lastStepCount;
+		}
+
+		m_alpha = m_accumulator / m_stepSize;
+	}
+
+
+	/** Fraction of a step which is still waiting in the accumulator, in the range [0, 1). Use this to interpolate between
+	the previous and current simulation state. */
+	float GetInterpolationAlpha() const { return m_alpha; }
+
+	/** The number of steps taken during the last call to Advance, including any merged step. */
+	int GetLastStepCount() const { return m_lastStepCount; }
+
+	/** The number of whole steps which were dropped or merged during the last call to Advance. */
+	int GetLastOverrunSteps() const { return m_lastOverrunSteps; }
+
+	float GetStepSize() const { return m_stepSize; }
+	void SetStepSize(float stepSize) { m_stepSize = std::max(stepSize, FLT_EPSILON); }
+
+	int GetMaxCatchUpSteps() const { return m_maxCatchUpSteps; }
+	void SetMaxCatchUpSteps(int maxCatchUpSteps) { m_maxCatchUpSteps = std::max(maxCatchUpSteps, 1); }
+
+	float GetTimeBudget() const { return m_timeBudget; }
+	void SetTimeBudget(float timeBudget) { m_timeBudget = timeBudget; }
+
+	EStepOverrunPolicy GetOverrunPolicy() const { return m_overrunPolicy; }
+	void SetOverrunPolicy(EStepOverrunPolicy overrunPolicy) { m_overrunPolicy = overrunPolicy; }
+
+	/** Empty the accumulator. Useful after loading, when the frame time is meaningless. */
+	void Reset()
+	{
+		m_accumulator = 0.0f;
+		m_alpha = 0.0f;
+	}
+
+private:
+	template<typename StepFunction>
+	void HandleOverrun(StepFunction&& stepFunction)
+	{
+		// Only whole steps are dealt with, the remainder is kept for interpolation and the next frame.
+		m_lastOverrunSteps = static_cast<int>(m_accumulator / m_stepSize);
+		const float overrunTime = m_lastOverrunSteps * m_stepSize;
+		m_accumulator -= overrunTime;
+
+		if (m_overrunPolicy == EStepOverrunPolicy::merge)
+		{
+			stepFunction(overrunTime);
+			++m_lastStepCount;
+		}
+	}
+
+	/** Simulation time for each step, in seconds. */
+	float m_stepSize {0.5f};
+
+	/** Maximum number of steps we are allowed to take in a single frame. */
+	int m_maxCatchUpSteps {4};
+
+	/** Maximum wall time we will spend stepping in a single frame, in seconds. Zero means there is no budget. */
+	float m_timeBudget {0.0f};
+
+	/** What we do with steps that don't fit within the limits. */
+	EStepOverrunPolicy m_overrunPolicy {EStepOverrunPolicy::drop};
+
+	/** Simulation time which hasn't been stepped yet. */
+	float m_accumulator {0.0f};
+
+	/** Interpolation alpha from the last call to Advance. */
+	float m_alpha {0.0f};
+
+	int m_lastStepCount {0};
+	int m_lastOverrunSteps {0};
+};
+}
@@ -0,0 +1,116 @@
+#include <StdAfx.h>
+
+#include "NameIndex.h"
+#include "ECS/Components/Components.h"
+
+
+namespace Chrysalis::ECS
+{
+void CNameIndex::Connect(entt::registry& registry)
+{
+	Disconnect();
+	m_pRegistry = &registry;
+
+	registry.on_construct<ECS::Name>().connect<&CNameIndex::OnConstruct>(this);
+	registry.on_replace<ECS::Name>().connect<&CNameIndex::OnReplace>(this);
+	registry.on_destroy<ECS::Name>().connect<&CNameIndex::OnDestroy>(this);
+
+	// Pick up anything that was named before we connected.
+	auto view = registry.view<ECS::Name>();
+	for (auto entity : view)
+		m_pending.push_back(entity);
+}
+
+
+void CNameIndex::Disconnect()
+{
+	if (m_pRegistry)
+	{
+		m_pRegistry->on_construct<ECS::Name>().disconnect<&CNameIndex::OnConstruct>(this);
+		m_pRegistry->on_replace<ECS::Name>().disconnect<&CNameIndex::OnReplace>(this);
+		m_pRegistry->on_destroy<ECS::Name>().disconnect<&CNameIndex::OnDestroy>(this);
+		m_pRegistry = nullptr;
+	}
+
+	m_entities.clear();
+	m_names.clear();
+	m_pending.clear();
+}
+
+
+entt::entity CNameIndex::Find(const entt::hashed_string& name)
+{
+	IndexPending();
+
+	auto it = m_entities.find(name.value());
+	if (it != m_entities.end())
+		return it->second.front();
+
+	// Failed to find it.
+	return entt::null;
+}
+
+
+void CNameIndex::OnConstruct(entt::registry& registry, entt::entity entity, ECS::Name& name)
+{
+	m_pending.push_back(entity);
+}
+
+
+void CNameIndex::OnReplace(entt::registry& registry, entt::entity entity, ECS::Name& name)
+{
+	Remove(entity);
+	m_pending.push_back(entity);
+}
+
+
+void CNameIndex::OnDestroy(entt::registry& registry, entt::entity entity)
+{
+	Remove(entity);
+
+	// It might not have been indexed yet.
+	m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), entity), m_pending.end());
+}
+
+
+void CNameIndex::Remove(entt::entity entity)
+{
+	auto it = m_names.find(entity);
+	if (it != m_names.end())
+	{
+		// Other entities might share the name, in which case the next of them is found from now on.
+		auto entry = m_entities.find(it->second);
+		if (entry != m_entities.end())
+		{
+			auto& holders = entry->second;
+			holders.erase(std::remove(holders.begin(), holders.end(), entity), holders.end());
+			if (holders.empty())
+				m_entities.erase(entry);
+		}
+
+		m_names.erase(it);
+	}
+}
+
+
+void CNameIndex::IndexPending()
+{
+	if (m_pending.empty() || !m_pRegistry)
+		return;
+
+	for (auto entity : m_pending)
+	{
+		if (!m_pRegistry->valid(entity) || !m_pRegistry->has<ECS::Name>(entity))
+			continue;
+
+		// An entity can be queued more than once, so clear out anything we already have for it.
+		Remove(entity);
+
+		const auto hash = entt::hashed_string {m_pRegistry->get<ECS::Name>(entity).name.c_str()}.value();
+		m_names[entity] = hash;
+		m_entities[hash].push_back(entity);
+	}
+
+	m_pending.clear();
+}
+}
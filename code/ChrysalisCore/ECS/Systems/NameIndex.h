@@ -0,0 +1,61 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+
+namespace Chrysalis::ECS
+{
+struct Name;
+
+/** An index from the hashed value of an entity's name to the entity. The index is kept in sync with the registry
+	through the construction, replacement and destruction signals for the Name component.
+
+	Names are often filled in after the component is constructed e.g. when loading from XML, so new and replaced names
+	are queued and only hashed the next time a lookup is made. If you change a name in place, rather than through
+	registry.replace, the index won't know about it.
+
+	If two entities share the same name, the first one to be indexed wins. Should it go away, the next one to have been
+	indexed with that name takes over. */
+
+class CNameIndex
+{
+public:
+	CNameIndex() = default;
+	CNameIndex(const CNameIndex&) = delete;
+	CNameIndex& operator=(const CNameIndex&) = delete;
+
+	/** Connects the index to a registry's signals. Any entities which already have a name are added to the index. */
+	void Connect(entt::registry& registry);
+
+	/** Disconnects from the registry and empties the index. */
+	void Disconnect();
+
+	/** Find the entity with the given name. Returns entt::null if there isn't one. */
+	entt::entity Find(const entt::hashed_string& name);
+
+	/** Find the entity with the given name. Returns entt::null if there isn't one. */
+	entt::entity Find(const char* name) { return Find(entt::hashed_string {name}); }
+
+private:
+	void OnConstruct(entt::registry& registry, entt::entity entity, ECS::Name& name);
+	void OnReplace(entt::registry& registry, entt::entity entity, ECS::Name& name);
+	void OnDestroy(entt::registry& registry, entt::entity entity);
+
+	/** Removes any existing entry for this entity. */
+	void Remove(entt::entity entity);
+
+	/** Hashes the names of any entities which are waiting to be indexed. */
+	void IndexPending();
+
+	entt::registry* m_pRegistry {nullptr};
+
+	/** Hashed name to every entity with that name, in the order they were indexed. Lookups return the first. */
+	std::unordered_map<entt::hashed_string::hash_type, std::vector<entt::entity>> m_entities;
+
+	/** Entity to hashed name, so we can find the entry to remove without needing the old name. */
+	std::unordered_map<entt::entity, entt::hashed_string::hash_type> m_names;
+
+	/** Entities whose names haven't been hashed yet. */
+	std::vector<entt::entity> m_pending;
+};
+}
@@ -0,0 +1,45 @@
+#include <StdAfx.h>
+
+#include "SpellPrototypes.h"
+#include "ECS/Components/Components.h"
+#include "ECS/Components/Health.h"
+#include "ECS/Components/Qi.h"
+#include "ECS/Components/Spell.h"
+
+
+namespace Chrysalis::ECS
+{
+void CSpellPrototypes::Build(entt::registry& spellRegistry)
+{
+	m_prototypes.clear();
+
+	auto view = spellRegistry.view<ECS::Spell>();
+	for (auto prototypeEntity : view)
+	{
+		auto& copyFunctions = m_prototypes[prototypeEntity];
+
+		// Only the components which change during the life of a spell need copying. The name and spell components are
+		// shared with the prototype.
+		AddOwnedComponents<ECS::Health, ECS::Damage, ECS::DamageOverTime, ECS::Heal, ECS::HealOverTime,
+			ECS::Qi, ECS::UtiliseQi, ECS::UtiliseQiOverTime, ECS::ReplenishQi, ECS::ReplenishQiOverTime>
+			(spellRegistry, prototypeEntity, copyFunctions);
+	}
+}
+
+
+entt::entity CSpellPrototypes::Instantiate(const entt::registry& spellRegistry, entt::entity prototypeEntity,
+	entt::registry& actorRegistry) const
+{
+	auto prototype = m_prototypes.find(prototypeEntity);
+	if (prototype == m_prototypes.end())
+		return entt::null;
+
+	auto instanceEntity = actorRegistry.create();
+	actorRegistry.assign<ECS::SpellPrototype>(instanceEntity, prototypeEntity);
+
+	for (auto copyFunction : prototype->second)
+		copyFunction(spellRegistry, prototypeEntity, actorRegistry, instanceEntity);
+
+	return instanceEntity;
+}
+}
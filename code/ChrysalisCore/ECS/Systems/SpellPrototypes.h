@@ -0,0 +1,50 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+
+namespace Chrysalis::ECS
+{
+/** Keeps a list of the mutable components owned by each spell prototype, so casting a spell only copies the components
+	the prototype actually has. The lists are built once, after the spell registry is loaded.
+
+	Immutable data, such as the name and spell components, is not copied. Each instance is given a SpellPrototype
+	component instead, which refers back to the prototype so that data can be shared. */
+
+class CSpellPrototypes
+{
+public:
+	/** Builds the component lists for every spell in the spell registry. Call this each time the registry is loaded. */
+	void Build(entt::registry& spellRegistry);
+
+	/** Creates a new instance of the spell prototype in the actor registry. Returns entt::null if the entity isn't a
+	known spell prototype. */
+	entt::entity Instantiate(const entt::registry& spellRegistry, entt::entity prototypeEntity, entt::registry& actorRegistry) const;
+
+	/** Forget all the prototypes. */
+	void Clear() { m_prototypes.clear(); }
+
+private:
+	using CopyFunction = void(*)(const entt::registry& source, entt::entity sourceEntity, entt::registry& destination,
+		entt::entity destinationEntity);
+
+	template<typename Component>
+	static void CopyComponent(const entt::registry& source, entt::entity sourceEntity, entt::registry& destination,
+		entt::entity destinationEntity)
+	{
+		destination.assign<Component>(destinationEntity, source.get<Component>(sourceEntity));
+	}
+
+
+	/** Adds a copy function to the list for each of the components the prototype owns. */
+	template<typename... Components>
+	static void AddOwnedComponents(const entt::registry& spellRegistry, entt::entity prototypeEntity,
+		std::vector<CopyFunction>& copyFunctions)
+	{
+		((spellRegistry.has<Components>(prototypeEntity) ? copyFunctions.push_back(&CopyComponent<Components>) : void()), ...);
+	}
+
+	/** The copy functions for each prototype's mutable components. */
+	std::unordered_map<entt::entity, std::vector<CopyFunction>> m_prototypes;
+};
+}
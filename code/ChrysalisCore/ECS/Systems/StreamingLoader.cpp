@@ -0,0 +1,148 @@
+#include <StdAfx.h>
+
+#include "StreamingLoader.h"
+#include "ECS/Components/Components.h"
+
+
+namespace Chrysalis::ECS
+{
+CStreamingRegistryLoader::CStreamingRegistryLoader(string fileName, entt::registry& registry, bool isBackground,
+	CompletionFunction onComplete) :
+	m_fileName(fileName), m_registry(registry), m_onComplete(std::move(onComplete))
+{
+	if (isBackground && gEnv->pJobManager)
+	{
+		m_hasJob = true;
+		gEnv->pJobManager->AddLambdaJob("ECS::CStreamingRegistryLoader::Parse", [this]()
+		{
+			Parse();
+		}, JobManager::eRegularPriority, &m_jobState);
+	}
+	else
+	{
+		Parse();
+	}
+}
+
+
+CStreamingRegistryLoader::~CStreamingRegistryLoader()
+{
+	// The job refers to us, so it must finish before we go.
+	if (m_hasJob)
+		gEnv->pJobManager->WaitForJob(m_jobState);
+}
+
+
+void CStreamingRegistryLoader::Parse()
+{
+	// Load the file into an in-memory structure.
+	if (XmlNodeRef entitiesNode = GetISystem()->LoadXmlFromFile(m_fileName))
+	{
+		m_stagedEntities.resize(entitiesNode->getChildCount());
+
+		// Iterate through all the children which should be individual entities.
+		for (int i = 0, n = entitiesNode->getChildCount(); i < n; ++i)
+		{
+			XmlNodeRef entityNode = entitiesNode->getChild(i);
+
+			// Get the components node - this holds all the components for this entity.
+			if (XmlNodeRef componentsNode = entityNode->findChild("components"))
+			{
+				auto& components = m_stagedEntities[i].components;
+				components.reserve(componentsNode->getChildCount());
+
+				for (int j = 0, m = componentsNode->getChildCount(); j < m; ++j)
+				{
+					// Using the tag as a unique ID for the class. Hashing it here saves the main thread from doing it.
+					XmlNodeRef componentNode = componentsNode->getChild(j);
+					components.push_back({entt::hashed_string {componentNode->getTag()}.value(), componentNode});
+				}
+			}
+		}
+	}
+	else
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Unable to load ECS data from %s", m_fileName.c_str());
+	}
+
+	m_isParsed = true;
+}
+
+
+void CStreamingRegistryLoader::Create(const SStagedEntity& stagedEntity)
+{
+	// We should create a fresh entity for the components to attach onto.
+	auto entity = m_registry.create();
+
+	for (auto& stagedComponent : stagedEntity.components)
+	{
+		// Ask the system for the class and default construct a component of that type.
+		if (auto component = entt::resolve(stagedComponent.typeId))
+		{
+			// Uses the registry to construct a component, assign it to the entity, and then return a reference for us to use.
+			auto any = component.construct(entity, &m_registry);
+
+			// Serialise the properties across to the component.
+			auto& iComponent = any.cast<ECS::IComponent>();
+			Serialization::LoadXmlNode(iComponent, stagedComponent.componentNode);
+		}
+	}
+}
+
+
+bool CStreamingRegistryLoader::Update(float timeBudget)
+{
+	if (m_isComplete)
+		return true;
+
+	if (!m_isParsed)
+		return false;
+
+	// Always hand over at least one entity, so we make progress even on a very small budget.
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+	do
+	{
+		if (m_nextEntity >= m_stagedEntities.size())
+			break;
+
+		Create(m_stagedEntities[m_nextEntity++]);
+	} while ((gEnv->pTimer->GetAsyncTime() - startTime).GetSeconds() < timeBudget);
+
+	if (m_nextEntity >= m_stagedEntities.size())
+	{
+		m_isComplete = true;
+
+		// Let go of the XML as soon as we're done with it.
+		m_stagedEntities.clear();
+		m_stagedEntities.shrink_to_fit();
+
+		if (m_onComplete)
+			m_onComplete(m_registry);
+	}
+
+	return m_isComplete;
+}
+
+
+void CStreamingRegistryLoader::Finish()
+{
+	if (m_hasJob)
+		gEnv->pJobManager->WaitForJob(m_jobState);
+
+	while (!Update(FLT_MAX))
+	{
+	}
+}
+
+
+float CStreamingRegistryLoader::GetProgress() const
+{
+	if (m_isComplete)
+		return 1.0f;
+
+	if (!m_isParsed || m_stagedEntities.empty())
+		return 0.0f;
+
+	return 0.1f + 0.9f * (static_cast<float>(m_nextEntity) / static_cast<float>(m_stagedEntities.size()));
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <CryThreading/IJobManager.h>
+
+
+namespace Chrysalis::ECS
+{
+/** Loads the entities and components from an XML file into a registry over a number of frames. The file is read and
+	parsed, optionally on a background thread, into a list of staged entities. The staged entities are then handed over
+	to the registry on the main thread, a batch at a time, for as long as the time budget for the frame allows.
+
+	This uses the same format as LoadECSFromXML, and ends up with the same result. */
+
+class CStreamingRegistryLoader
+{
+public:
+	using CompletionFunction = std::function<void(entt::registry& registry)>;
+
+	CStreamingRegistryLoader(string fileName, entt::registry& registry, bool isBackground = true,
+		CompletionFunction onComplete = nullptr);
+	~CStreamingRegistryLoader();
+
+	CStreamingRegistryLoader(const CStreamingRegistryLoader&) = delete;
+	CStreamingRegistryLoader& operator=(const CStreamingRegistryLoader&) = delete;
+
+	/** Hand over as many staged entities as fit within the time budget. Must be called from the main thread. Returns
+	true once loading is complete. */
+	bool Update(float timeBudget);
+
+	/** Finish loading right now, no matter how long it takes. */
+	void Finish();
+
+	/** Has every entity been handed over to the registry? */
+	bool IsComplete() const { return m_isComplete; }
+
+	/** Progress through the load in the range [0, 1]. Parsing the file counts as the first tenth. */
+	float GetProgress() const;
+
+	const string& GetFileName() const { return m_fileName; }
+
+private:
+	struct SStagedComponent
+	{
+		/** Hash of the component's tag, which identifies it's type. */
+		entt::hashed_string::hash_type typeId;
+
+		/** The node holding the component's properties. */
+		XmlNodeRef componentNode;
+	};
+
+	struct SStagedEntity
+	{
+		std::vector<SStagedComponent> components;
+	};
+
+	/** Reads the file and stages all the entities. This is the part which runs in the background. */
+	void Parse();
+
+	/** Creates an entity in the registry from a staged entity. */
+	void Create(const SStagedEntity& stagedEntity);
+
+	string m_fileName;
+	entt::registry& m_registry;
+	CompletionFunction m_onComplete;
+
+	/** Staged entities. Only touched by the background job until m_isParsed is set. */
+	std::vector<SStagedEntity> m_stagedEntities;
+
+	/** The next staged entity to hand over. */
+	size_t m_nextEntity {0};
+
+	std::atomic<bool> m_isParsed {false};
+	bool m_isComplete {false};
+
+	JobManager::SJobState m_jobState;
+	bool m_hasJob {false};
+};
+}
@@ -0,0 +1,146 @@
+#include <StdAfx.h>
+
+#include "SystemScheduler.h"
+
+
+namespace Chrysalis::ECS
+{
+bool SystemAccess::ConflictsWith(const SystemAccess& rhs) const
+{
+	auto contains = [](const std::vector<TypeId>& typeIds, TypeId typeId)
+	{
+		return std::find(typeIds.begin(), typeIds.end(), typeId) != typeIds.end();
+	};
+
+	// Our writes against anything they touch.
+	for (auto typeId : writes)
+	{
+		if (contains(rhs.writes, typeId) || contains(rhs.reads, typeId))
+			return true;
+	}
+
+	// Our reads against their writes.
+	for (auto typeId : reads)
+	{
+		if (contains(rhs.writes, typeId))
+			return true;
+	}
+
+	return false;
+}
+
+
+void SystemAccess::PreparePools(entt::registry& registry) const
+{
+	for (auto preparePool : m_preparePools)
+		preparePool(registry);
+}
+
+
+void CSystemScheduler::AddSystem(const char* name, SystemFunction function, SystemAccess access)
+{
+	m_systems.push_back({name, std::move(function), std::move(access), CCommandBuffer {}});
+}
+
+
+void CSystemScheduler::Build()
+{
+	m_batches.clear();
+
+	// Each system is placed one batch after the latest batch of any earlier system it conflicts with. This is the
+	// longest path through the dependency graph, which keeps the number of sync points as low as possible.
+	std::vector<size_t> batchForSystem(m_systems.size(), 0);
+	for (size_t i = 0; i < m_systems.size(); ++i)
+	{
+		size_t batch {0};
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (m_systems[i].access.ConflictsWith(m_systems[j].access))
+				batch = std::max(batch, batchForSystem[j] + 1);
+		}
+
+		batchForSystem[i] = batch;
+		if (batch >= m_batches.size())
+			m_batches.resize(batch + 1);
+
+		// Systems are added in serial order, so each batch keeps that order too.
+		m_batches[batch].push_back(i);
+	}
+
+	// Job states can't be copied or moved, so we keep one for each system that might be handed to the job manager.
+	m_jobStates.clear();
+	for (auto& batch : m_batches)
+	{
+		while (m_jobStates.size() + 1 < batch.size())
+			m_jobStates.emplace_back(std::make_unique<JobManager::SJobState>());
+	}
+}
+
+
+void CSystemScheduler::Execute(float deltaTime, entt::registry& registry, bool parallel)
+{
+	if (!parallel || !gEnv->pJobManager)
+	{
+		for (auto& system : m_systems)
+			system.function(deltaTime, registry, system.commands);
+
+		Playback(registry);
+
+		return;
+	}
+
+	// The registry creates pools lazily, which isn't safe to do from more than one thread at a time.
+	for (auto& system : m_systems)
+		system.access.PreparePools(registry);
+
+	for (auto& batch : m_batches)
+	{
+		// Hand off all but the last system to the job manager and run the last one on this thread while we wait.
+		for (size_t i = 0; i + 1 < batch.size(); ++i)
+		{
+			auto& system = m_systems[batch[i]];
+			gEnv->pJobManager->AddLambdaJob(system.name, [&system, deltaTime, &registry]()
+			{
+				system.function(deltaTime, registry, system.commands);
+			}, JobManager::eRegularPriority, m_jobStates[i].get());
+		}
+
+		auto& lastSystem = m_systems[batch.back()];
+		lastSystem.function(deltaTime, registry, lastSystem.commands);
+
+		// Sync point. No system in the next batch may start until everything in this batch is complete.
+		for (size_t i = 0; i + 1 < batch.size(); ++i)
+			gEnv->pJobManager->WaitForJob(*m_jobStates[i]);
+	}
+
+	Playback(registry);
+}
+
+
+void CSystemScheduler::Playback(entt::registry& registry)
+{
+	// Systems only ever record into their own buffer, so playing them back in system order keeps the results the same
+	// whether or not the systems ran in parallel.
+	for (auto& system : m_systems)
+		system.commands.Playback(registry);
+}
+
+
+void CSystemScheduler::Clear()
+{
+	m_systems.clear();
+	m_batches.clear();
+	m_jobStates.clear();
+}
+
+
+void CSystemScheduler::LogBatches() const
+{
+	for (size_t batch = 0; batch < m_batches.size(); ++batch)
+	{
+		CryLogAlways("ECS batch %zu:", batch);
+		for (auto index : m_batches[batch])
+			CryLogAlways("    %s", m_systems[index].name);
+	}
+}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <CryThreading/IJobManager.h>
+#include "ECS/Systems/CommandBuffer.h"
+
+
+namespace Chrysalis::ECS
+{
+/** Describes which component types a system reads and writes. The scheduler uses this to decide which systems are able
+	to run alongside each other. Component types are identified by their hashed name, which keeps this in step with the
+	meta registration and serialisation code. */
+
+struct SystemAccess
+{
+	using TypeId = entt::hashed_string::hash_type;
+
+	template<typename... Components>
+	SystemAccess& Reads()
+	{
+		(Add<Components>(reads), ...);
+
+		return *this;
+	}
+
+
+	template<typename... Components>
+	SystemAccess& Writes()
+	{
+		(Add<Components>(writes), ...);
+
+		return *this;
+	}
+
+
+	/** Resources are shared data which aren't components, such as buffers which are filled by one system and consumed
+	by another. They are identified by name and follow the same rules as component types. */
+	SystemAccess& ReadsResource(const entt::hashed_string& name)
+	{
+		reads.push_back(name.value());
+
+		return *this;
+	}
+
+
+	SystemAccess& WritesResource(const entt::hashed_string& name)
+	{
+		writes.push_back(name.value());
+
+		return *this;
+	}
+
+
+	/** Two systems conflict if either of them writes to a component type the other one reads or writes. */
+	bool ConflictsWith(const SystemAccess& rhs) const;
+
+	/** Ensures the storage for every component we touch exists. Pools must not be created while systems run in parallel. */
+	void PreparePools(entt::registry& registry) const;
+
+	/** Component types and resources this system only reads. */
+	std::vector<TypeId> reads;
+
+	/** Component types and resources this system writes, adds or removes. */
+	std::vector<TypeId> writes;
+
+private:
+	template<typename Component>
+	static void PreparePool(entt::registry& registry)
+	{
+		// Requesting a view is enough to have the registry create the pool.
+		static_cast<void>(registry.view<Component>());
+	}
+
+
+	template<typename Component>
+	void Add(std::vector<TypeId>& typeIds)
+	{
+		typeIds.push_back(Component().GetHashedName().value());
+		m_preparePools.push_back(&PreparePool<Component>);
+	}
+
+	std::vector<void(*)(entt::registry&)> m_preparePools;
+};
+
+
+/** Runs a set of systems as a dependency graph. Systems are added in their serial order. Any system which conflicts with
+	an earlier one is placed in a later batch, so conflicting systems always run in the order they were added, while
+	systems in the same batch touch disjoint data and may run in parallel on the job manager. This means the results are
+	identical to running the systems one after another.
+
+	Each system records structural changes into it's own command buffer. The buffers are played back in system order once
+	every batch has run, which is the sync point at the end of the phase. */
+
+class CSystemScheduler
+{
+public:
+	using SystemFunction = std::function<void(float deltaTime, entt::registry& registry, CCommandBuffer& commands)>;
+
+	/** Adds a system. Systems are considered to run in the order they are added. */
+	void AddSystem(const char* name, SystemFunction function, SystemAccess access);
+
+	/** Builds the batches from the dependency graph. Must be called after the last system is added. */
+	void Build();
+
+	/** Runs each batch of systems in turn and then plays back their command buffers. If parallel is false, the systems
+	are run serially in the order they were added. */
+	void Execute(float deltaTime, entt::registry& registry, bool parallel);
+
+	/** Remove all the systems and batches. */
+	void Clear();
+
+	/** Writes the batches out to the log. Useful for checking the read / write declarations. */
+	void LogBatches() const;
+
+private:
+	/** Plays back the command buffer for each system, in the order the systems were added. */
+	void Playback(entt::registry& registry);
+
+	struct SSystem
+	{
+		const char* name;
+		SystemFunction function;
+		SystemAccess access;
+		CCommandBuffer commands;
+	};
+
+	/** Every system, in serial order. */
+	std::vector<SSystem> m_systems;
+
+	/** Indices into m_systems for each batch. Batches are run in order, with a sync point between each one. */
+	std::vector<std::vector<size_t>> m_batches;
+
+	/** Job states for the systems we hand off to the job manager. Sized to fit the largest batch. */
+	std::vector<std::unique_ptr<JobManager::SJobState>> m_jobStates;
+};
+}
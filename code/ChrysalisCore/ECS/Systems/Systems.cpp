@@ -9,128 +9,139 @@
 
 namespace Chrysalis::ECS
 {
+/** Shared handling for the over-time components. New components are given their first tick, then the timer wheel is
+	advanced and applyFunction is called for each component which is due to tick. Components which have no ticks
+	remaining are removed once the phase is complete. */
+template<typename OverTimeComponent, typename ApplyFunction>
+void ApplyOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers, ApplyFunction&& applyFunction)
+{
+	// Components added or replaced since the last tick have been loaded by now, so their intervals are correct. A
+	// replacement which already has a tick coming up keeps it, otherwise it starts a fresh interval. Ticks due further off
+	// than an interval came from a snapshot of a different session, and start afresh too.
+	timers.SchedulePending([&registry, &timers](entt::entity entity)
+	{
+		if (registry.valid(entity) && registry.has<OverTimeComponent>(entity))
+		{
+			auto& overTime = registry.get<OverTimeComponent>(entity);
+			if ((overTime.nextTickTime <= timers.GetTime()) || (overTime.nextTickTime > timers.GetTime() + overTime.interval))
+				overTime.nextTickTime = timers.GetTime() + overTime.interval;
+
+			timers.Schedule(entity, overTime.nextTickTime);
+		}
+	});
+
+	timers.Advance(dt, [&](entt::entity entity, double dueTime)
+	{
+		// Ignore entries for components that are gone, or which have been replaced since they were scheduled.
+		if (!registry.valid(entity) || !registry.has<OverTimeComponent>(entity))
+			return;
+
+		auto& overTime = registry.get<OverTimeComponent>(entity);
+		if (overTime.nextTickTime != dueTime)
+			return;
+
+		// A merged step can cover several intervals, so we apply every tick which has come due, not just the first.
+		const double interval = std::max(overTime.interval, FLT_EPSILON);
+		double nextTickTime = dueTime;
+		do
+		{
+			if ((overTime.ticksRemaining >= 1.0f) && registry.has<ECS::SourceAndTarget>(entity))
+			{
+				overTime.ticksRemaining--;
+				applyFunction(overTime, registry.get<ECS::SourceAndTarget>(entity));
+			}
+
+			nextTickTime += interval;
+		} while ((nextTickTime <= timers.GetTime()) && (overTime.ticksRemaining >= 1.0f));
+
+		if (overTime.ticksRemaining >= 1.0f)
+		{
+			// Schedule the next tick.
+			overTime.nextTickTime = nextTickTime;
+			timers.Schedule(entity, overTime.nextTickTime);
+		}
+		else
+		{
+			// Remove just the component, once the phase is complete.
+			commands.Remove<OverTimeComponent>(entity);
+		}
+	});
+}
+
+
 // ***
 // *** Health System
 // ***
 
 
-void SystemApplyDamage(entt::registry& registry)
+void SystemApplyDamage(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& healthDecreases)
 {
-	// Apply any damage to the damage modifiers.
+	// Gather any damage, ready to apply to the health modifiers.
 	auto view = registry.view<ECS::Damage, ECS::SourceAndTarget>();
 	for (auto entity : view)
 	{
 		// Get the components.
 		auto& damage = view.get<ECS::Damage>(entity);
 		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-		auto& targetHealth = registry.get<ECS::Health>(sourceAndTarget.targetEntity);
 
-		// Get the health component for the target entity and apply the damage to it's health modifier.
-		targetHealth.health.modifiers -= damage.quantity;
+		// The damage is applied to the target entity's health modifier when the deltas are applied.
+		healthDecreases.Add(sourceAndTarget.targetEntity, damage.quantity);
 
-		// Remove just the component.
-		registry.remove<ECS::Damage>(entity);
+		// Remove just the component, once the phase is complete.
+		commands.Remove<ECS::Damage>(entity);
 	}
 }
 
 
-void SystemApplyDamageOverTime(float dt, entt::registry& registry)
+void SystemApplyDamageOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& healthDecreases)
 {
-	// Apply any damage to the damage modifiers.
-	auto view = registry.view<ECS::DamageOverTime, ECS::SourceAndTarget>();
-	for (auto entity : view)
+	// Gather any damage which is due, ready to apply to the health modifiers.
+	ApplyOverTime<ECS::DamageOverTime>(dt, registry, commands, timers,
+		[&healthDecreases](ECS::DamageOverTime& damage, ECS::SourceAndTarget& sourceAndTarget)
 	{
-		// Get the components..
-		auto& damage = view.get<ECS::DamageOverTime>(entity);
-		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-
-		damage.deltaSinceTick += dt;
-		if ((damage.deltaSinceTick >= damage.interval) && (damage.ticksRemaining >= 1.0f))
-		{
-			damage.ticksRemaining--;
-			damage.deltaSinceTick -= damage.interval;
-
-			// Get the health component for the target entity and apply the damage to it's health modifier.
-			auto& targetHealth = registry.get<ECS::Health>(sourceAndTarget.targetEntity);
-			targetHealth.health.modifiers -= damage.quantity;
-		}
-
-		if (damage.ticksRemaining <= 0.0f)
-		{
-			// Remove just the component.
-			registry.remove<ECS::DamageOverTime>(entity);
-		}
-	}
+		healthDecreases.Add(sourceAndTarget.targetEntity, damage.quantity);
+	});
 }
 
 
-void SystemApplyHeal(entt::registry& registry)
+void SystemApplyHeal(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& healthIncreases)
 {
-	// Apply any heals to the health modifiers.
+	// Gather any heals, ready to apply to the health modifiers.
 	auto view = registry.view<ECS::Heal, ECS::SourceAndTarget>();
 	for (auto entity : view)
 	{
 		// Get the components..
 		auto& heal = view.get<ECS::Heal>(entity);
 		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-		auto& targetHealth = registry.get<ECS::Health>(sourceAndTarget.targetEntity);
 
-		// Check for overheals.
-		float newModifier = targetHealth.health.modifiers + heal.quantity;
-		if (newModifier > 0.0f)
-		{
-			// It was an overheal.
-			targetHealth.health.modifiers = 0.0f;
-		}
-		else
-		{
-			targetHealth.health.modifiers = newModifier;
-		}
+		// Overheals are clamped when the deltas are applied.
+		healthIncreases.Add(sourceAndTarget.targetEntity, heal.quantity);
 
-		// Remove just the component.
-		registry.remove<ECS::Heal>(entity);
+		// Remove just the component, once the phase is complete.
+		commands.Remove<ECS::Heal>(entity);
 	}
 }
 
 
-void SystemApplyHealOverTime(float dt, entt::registry& registry)
+void SystemApplyHealOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& healthIncreases)
 {
-	// Apply any heal to the health modifiers.
-	auto view = registry.view<ECS::HealOverTime, ECS::SourceAndTarget>();
-	for (auto entity : view)
+	// Gather any heals which are due, ready to apply to the health modifiers.
+	ApplyOverTime<ECS::HealOverTime>(dt, registry, commands, timers,
+		[&healthIncreases](ECS::HealOverTime& heal, ECS::SourceAndTarget& sourceAndTarget)
 	{
-		// Get the components..
-		auto& heal = view.get<ECS::HealOverTime>(entity);
-		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-
-		heal.deltaSinceTick += dt;
-		if ((heal.deltaSinceTick >= heal.interval) && (heal.ticksRemaining >= 1.0f))
-		{
-			heal.ticksRemaining--;
-			heal.deltaSinceTick -= heal.interval;
-
-			// Get the health component for the target entity and apply the heal to it's health modifier.
-			auto& targetHealth = registry.get<ECS::Health>(sourceAndTarget.targetEntity);
+		healthIncreases.Add(sourceAndTarget.targetEntity, heal.quantity);
+	});
+}
 
-			// Check for overheals.
-			float newModifier = targetHealth.health.modifiers + heal.quantity;
-			if (newModifier > 0.0f)
-			{
-				// It was an overheal.
-				targetHealth.health.modifiers = 0.0f;
-			}
-			else
-			{
-				targetHealth.health.modifiers = newModifier;
-			}
 
-			if (heal.ticksRemaining <= 0.0f)
-			{
-				// Remove just the component.
-				registry.remove<ECS::HealOverTime>(entity);
-			}
-		}
-	}
+void SystemApplyHealthDeltas(entt::registry& registry, CAttributeAggregator& aggregator,
+	SAttributeDeltas& healthDecreases, SAttributeDeltas& healthIncreases)
+{
+	// Apply all the damage and heals gathered this phase to the health modifiers, checking for overheals.
+	aggregator.Apply<ECS::Health>(registry, healthDecreases, healthIncreases,
+		[](ECS::Health& health) -> AttributeType<float>& { return health.health; });
 }
 
 
@@ -153,129 +164,81 @@ void SystemHealthCheck(entt::registry& registry)
 			// TODO: Inform them they died with -newHealth being the amount of overkill.
 		}
 	}
+}
 
 
-	// ***
-	// *** Chi System
-	// ***
+// ***
+// *** Qi System
+// ***
 
 
-}void SystemApplyQiUtilisation(entt::registry& registry)
+void SystemApplyQiUtilisation(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& qiDecreases)
 {
-	// Apply any qi usage to the modifiers.
+	// Gather any qi usage, ready to apply to the modifiers.
 	auto view = registry.view<ECS::UtiliseQi, ECS::SourceAndTarget>();
 	for (auto entity : view)
 	{
 		// Get the components..
 		auto& qi = view.get<ECS::UtiliseQi>(entity);
 		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-		auto& sourceQi = registry.get<ECS::Qi>(sourceAndTarget.sourceEntity);
 
-		// Get the qi component for the target entity and apply the usage to it's modifier.
-		sourceQi.qi.modifiers -= qi.quantity;
+		// The usage is applied to the source entity's qi modifier when the deltas are applied.
+		qiDecreases.Add(sourceAndTarget.sourceEntity, qi.quantity);
 
-		// Remove just the component.
-		registry.remove<ECS::UtiliseQi>(entity);
+		// Remove just the component, once the phase is complete.
+		commands.Remove<ECS::UtiliseQi>(entity);
 	}
 }
 
 
-void SystemApplyQiUtilisationOverTime(float dt, entt::registry& registry)
+void SystemApplyQiUtilisationOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& qiDecreases)
 {
-	// Apply any qi to the modifiers.
-	auto view = registry.view<ECS::UtiliseQiOverTime, ECS::SourceAndTarget>();
-	for (auto entity : view)
+	// Gather any qi usage which is due, ready to apply to the modifiers.
+	ApplyOverTime<ECS::UtiliseQiOverTime>(dt, registry, commands, timers,
+		[&qiDecreases](ECS::UtiliseQiOverTime& qi, ECS::SourceAndTarget& sourceAndTarget)
 	{
-		// Get the components..
-		auto& qi = view.get<ECS::UtiliseQiOverTime>(entity);
-		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-
-		qi.deltaSinceTick += dt;
-		if ((qi.deltaSinceTick >= qi.interval) && (qi.ticksRemaining >= 1.0f))
-		{
-			qi.ticksRemaining--;
-			qi.deltaSinceTick -= qi.interval;
-
-			// Get the qi component for the target entity and apply the usage to it's modifier.
-			auto& sourceQi = registry.get<ECS::Qi>(sourceAndTarget.sourceEntity);
-			sourceQi.qi.modifiers -= qi.quantity;
-		}
-
-		if (qi.ticksRemaining <= 0.0f)
-		{
-			// Remove just the component.
-			registry.remove<ECS::UtiliseQiOverTime>(entity);
-		}
-	}
+		qiDecreases.Add(sourceAndTarget.sourceEntity, qi.quantity);
+	});
 }
 
 
-void SystemApplyQiReplenishment(entt::registry& registry)
+void SystemApplyQiReplenishment(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& qiIncreases)
 {
-	// Apply any replenishment to the qi modifiers.
+	// Gather any replenishment, ready to apply to the qi modifiers.
 	auto view = registry.view<ECS::ReplenishQi, ECS::SourceAndTarget>();
 	for (auto entity : view)
 	{
 		// Get the components..
 		auto& replenish = view.get<ECS::ReplenishQi>(entity);
 		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-		auto& targetQi = registry.get<ECS::Qi>(sourceAndTarget.targetEntity);
 
-		// Check for over-replenishment.
-		float newModifier = targetQi.qi.modifiers + replenish.quantity;
-		if (newModifier > 0.0f)
-		{
-			// It was an over-replenishment.
-			targetQi.qi.modifiers = 0.0f;
-		}
-		else
-		{
-			targetQi.qi.modifiers = newModifier;
-		}
+		// Over-replenishment is clamped when the deltas are applied.
+		qiIncreases.Add(sourceAndTarget.targetEntity, replenish.quantity);
 
-		// Remove just the component.
-		registry.remove<ECS::ReplenishQi>(entity);
+		// Remove just the component, once the phase is complete.
+		commands.Remove<ECS::ReplenishQi>(entity);
 	}
 }
 
 
-void SystemApplyQiReplenishmentOverTime(float dt, entt::registry& registry)
+void SystemApplyQiReplenishmentOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& qiIncreases)
 {
-	// Apply any replenishment to the qi modifiers.
-	auto view = registry.view<ECS::ReplenishQiOverTime, ECS::SourceAndTarget>();
-	for (auto entity : view)
+	// Gather any replenishment which is due, ready to apply to the qi modifiers.
+	ApplyOverTime<ECS::ReplenishQiOverTime>(dt, registry, commands, timers,
+		[&qiIncreases](ECS::ReplenishQiOverTime& replenish, ECS::SourceAndTarget& sourceAndTarget)
 	{
-		// Get the components..
-		auto& replenish = view.get<ECS::ReplenishQiOverTime>(entity);
-		auto& sourceAndTarget = view.get<ECS::SourceAndTarget>(entity);
-
-		replenish.deltaSinceTick += dt;
-		if ((replenish.deltaSinceTick >= replenish.interval) && (replenish.ticksRemaining >= 1.0f))
-		{
-			replenish.ticksRemaining--;
-			replenish.deltaSinceTick -= replenish.interval;
-
-			// Get the qi component for the target entity and apply the replenishment to it's modifier.
-			auto& targetQi = registry.get<ECS::Qi>(sourceAndTarget.targetEntity);
+		qiIncreases.Add(sourceAndTarget.targetEntity, replenish.quantity);
+	});
+}
 
-			// Check for over-replenishment.
-			float newModifier = targetQi.qi.modifiers + replenish.quantity;
-			if (newModifier > 0.0f)
-			{
-				// It was an over-replenishment.
-				targetQi.qi.modifiers = 0.0f;
-			}
-			else
-			{
-				targetQi.qi.modifiers = newModifier;
-			}
 
-			if (replenish.ticksRemaining <= 0.0f)
-			{
-				// Remove just the component.
-				registry.remove<ECS::ReplenishQiOverTime>(entity);
-			}
-		}
-	}
-}
+void SystemApplyQiDeltas(entt::registry& registry, CAttributeAggregator& aggregator,
+	SAttributeDeltas& qiDecreases, SAttributeDeltas& qiIncreases)
+{
+	// Apply all the qi usage and replenishment gathered this phase to the qi modifiers, checking for over-replenishment.
+	aggregator.Apply<ECS::Qi>(registry, qiDecreases, qiIncreases,
+		[](ECS::Qi& qi) -> AttributeType<float>& { return qi.qi; });
 }
+}
\ No newline at end of file
@@ -1,26 +1,39 @@
 #pragma once
 
 #include <entt/entt.hpp>
+#include "ECS/Systems/AttributeDeltas.h"
+#include "ECS/Systems/CommandBuffer.h"
+#include "ECS/Systems/TimerWheel.h"
 
 namespace Chrysalis::ECS
 {
 // Health.
-void SystemApplyDamage(entt::registry& registry);
+void SystemApplyDamage(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& healthDecreases);
 
-void SystemApplyDamageOverTime(float dt, entt::registry& registry);
+void SystemApplyDamageOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& healthDecreases);
 
-void SystemApplyHeal(entt::registry& registry);
+void SystemApplyHeal(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& healthIncreases);
 
-void SystemApplyHealOverTime(float dt, entt::registry& registry);
+void SystemApplyHealOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& healthIncreases);
+
+void SystemApplyHealthDeltas(entt::registry& registry, CAttributeAggregator& aggregator,
+	SAttributeDeltas& healthDecreases, SAttributeDeltas& healthIncreases);
 
 void SystemHealthCheck(entt::registry& registry);
 
 // Qi.
-void SystemApplyQiUtilisation(entt::registry& registry);
+void SystemApplyQiUtilisation(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& qiDecreases);
+
+void SystemApplyQiUtilisationOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& qiDecreases);
 
-void SystemApplyQiUtilisationOverTime(float dt, entt::registry& registry);
+void SystemApplyQiReplenishment(entt::registry& registry, CCommandBuffer& commands, SAttributeDeltas& qiIncreases);
 
-void SystemApplyQiReplenishment(entt::registry& registry);
+void SystemApplyQiReplenishmentOverTime(float dt, entt::registry& registry, CCommandBuffer& commands, CTimerWheel& timers,
+	SAttributeDeltas& qiIncreases);
 
-void SystemApplyQiReplenishmentOverTime(float dt, entt::registry& registry);
+void SystemApplyQiDeltas(entt::registry& registry, CAttributeAggregator& aggregator,
+	SAttributeDeltas& qiDecreases, SAttributeDeltas& qiIncreases);
 }
\ No newline at end of file
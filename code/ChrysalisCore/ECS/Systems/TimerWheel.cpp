@@ -0,0 +1,75 @@
+#include <StdAfx.h>
+
+#include "TimerWheel.h"
+
+
+namespace Chrysalis::ECS
+{
+CTimerWheel::CTimerWheel(float slotDuration, size_t slotCount) :
+	m_slotDuration(slotDuration), m_slots(slotCount)
+{
+	CRY_ASSERT_MESSAGE(slotDuration > 0.0f && slotCount > 0, "Timer wheel requires at least one slot of a positive duration.");
+}
+
+
+void CTimerWheel::Schedule(entt::entity entity, double dueTime)
+{
+	// Anything due in a slot we have already moved past goes into the current slot instead, so it fires on the next advance.
+	const int64 tick = std::max(GetTick(dueTime), m_processedTick);
+	m_slots[static_cast<size_t>(tick % static_cast<int64>(m_slots.size()))].push_back({entity, dueTime});
+	++m_scheduledCount;
+}
+
+
+void CTimerWheel::CollectDue(int64 firstTick, int64 lastTick)
+{
+	m_due.clear();
+
+	// If we moved more than one revolution, every slot needs checking, but only once.
+	const int64 slotCount = static_cast<int64>(m_slots.size());
+	lastTick = std::min(lastTick, firstTick + slotCount - 1);
+
+	for (int64 tick = firstTick; tick <= lastTick; ++tick)
+	{
+		auto& slot = m_slots[static_cast<size_t>(tick % slotCount)];
+		for (size_t i = 0; i < slot.size();)
+		{
+			if (slot[i].dueTime <= m_time)
+			{
+				// Swap and pop, we don't care about order within a slot.
+				m_due.push_back(slot[i]);
+				slot[i] = slot.back();
+				slot.pop_back();
+				--m_scheduledCount;
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	// Fire in order of due time, falling back to the entity to keep things deterministic.
+	std::sort(m_due.begin(), m_due.end(), [](const SEntry& lhs, const SEntry& rhs)
+	{
+		if (lhs.dueTime != rhs.dueTime)
+			return lhs.dueTime < rhs.dueTime;
+
+		return lhs.entity < rhs.entity;
+	});
+}
+
+
+void CTimerWheel::Clear()
+{
+	for (auto& slot : m_slots)
+		slot.clear();
+
+	m_due.clear();
+	m_fired.clear();
+	m_pending.clear();
+	m_time = 0.0;
+	m_processedTick = 0;
+	m_scheduledCount = 0;
+}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+
+namespace Chrysalis::ECS
+{
+/** A hashed timer wheel for entities which need attention at some point in the future, such as the over-time effects.
+	Each entity is placed in the slot for the time it is next due, so advancing the wheel only needs to visit the slots
+	that have come due, rather than every entity. Entries which are due more than one revolution from now share a slot
+	with nearer entries and are simply skipped until their time comes around.
+
+	Entries are never removed early. If the entity or component goes away, or the entry is replaced by a newer one, the
+	caller is expected to notice when the stale entry fires and ignore it. */
+
+class CTimerWheel
+{
+public:
+	CTimerWheel(float slotDuration = 0.25f, size_t slotCount = 256);
+
+	/** Schedule an entity to be due at the given simulation time. Times in the past are due on the next advance. */
+	void Schedule(entt::entity entity, double dueTime);
+
+	/** Queue an entity which needs to be scheduled, but can't be right now e.g. it's component isn't fully loaded yet. */
+	void QueuePending(entt::entity entity) { m_pending.push_back(entity); }
+
+	/** Signal handler for component construction. Connect this to a registry to have new components queued as pending. */
+	template<typename Component>
+	void OnConstruct(entt::registry& registry, entt::entity entity, Component& component)
+	{
+		QueuePending(entity);
+	}
+
+
+	/** Signal handler for component replacement. Connect this to a registry to have replaced components queued as pending,
+	since the replacement won't match the entry scheduled for the component it replaced. */
+	template<typename Component>
+	void OnReplace(entt::registry& registry, entt::entity entity, Component& component)
+	{
+		QueuePending(entity);
+	}
+
+
+	/** Calls scheduleFunction once for each pending entity, and then empties the pending list. */
+	template<typename ScheduleFunction>
+	void SchedulePending(ScheduleFunction&& scheduleFunction)
+	{
+		for (auto entity : m_pending)
+			scheduleFunction(entity);
+
+		m_pending.clear();
+	}
+
+
+	/** Moves the wheel forward by deltaTime and calls dueFunction(entity, dueTime) for each entry which has come due.
+	Entries are fired in order of due time. It is safe to schedule more entries from inside dueFunction, and if they
+	are also due before the new time they will be fired before this returns. */
+	template<typename DueFunction>
+	void Advance(float deltaTime, DueFunction&& dueFunction)
+	{
+		m_time += deltaTime;
+		m_fired.clear();
+		const int64 firstTick = m_processedTick;
+		const int64 lastTick = GetTick(m_time);
+
+		do
+		{
+			CollectDue(firstTick, lastTick);
+			for (auto& entry : m_due)
+			{
+				m_fired.push_back(entry.entity);
+				dueFunction(entry.entity, entry.dueTime);
+			}
+		} while (!m_due.empty());
+
+		m_processedTick = lastTick;
+	}
+
+
+	/** The current simulation time for the wheel, in seconds. */
+	double GetTime() const { return m_time; }
+
+	/** Entities which came due during the last call to Advance, including any stale entries. */
+	const std::vector<entt::entity>& GetLastFired() const { return m_fired; }
+
+	/** Forget the entities which came due, once they have been dealt with. */
+	void ClearLastFired() { m_fired.clear(); }
+
+	/** Number of entries in the wheel, including any stale ones. */
+	size_t GetScheduledCount() const { return m_scheduledCount; }
+
+	/** Empty the wheel and reset the time back to zero. */
+	void Clear();
+
+private:
+	struct SEntry
+	{
+		entt::entity entity;
+		double dueTime;
+	};
+
+	int64 GetTick(double time) const { return static_cast<int64>(std::floor(time / m_slotDuration)); }
+
+	/** Moves every entry from the slots between the two ticks which is due by now into m_due, sorted by due time. */
+	void CollectDue(int64 firstTick, int64 lastTick);
+
+	/** Length of time covered by each slot, in seconds. */
+	float m_slotDuration;
+
+	/** The slots. Each slot holds the entries for every time which hashes into it. */
+	std::vector<std::vector<SEntry>> m_slots;
+
+	/** Entries which are due, ready to fire. Kept as a member to avoid allocating each frame. */
+	std::vector<SEntry> m_due;
+
+	/** Entities which came due during the last advance. */
+	std::vector<entt::entity> m_fired;
+
+	/** Entities waiting to be scheduled. */
+	std::vector<entt::entity> m_pending;
+
+	/** Simulation time. */
+	double m_time {0.0};
+
+	/** The tick for the last slot we processed. It is processed again next time, since it might only have been partly due. */
+	int64 m_processedTick {0};
+
+	size_t m_scheduledCount {0};
+};
+}
@@ -40,13 +40,17 @@ struct IInteraction
 	virtual const string GetVerbUI() const { return "@" + GetVerb(); };
 
 	bool IsEnabled() const { return m_isEnabled; };
-	void SetEnabled(bool isEnabled) { m_isEnabled = isEnabled; };
+	void SetEnabled(bool isEnabled) { if (m_isEnabled != isEnabled) { m_isEnabled = isEnabled; ++m_stateVersion; } };
 	bool IsHidden() const { return m_isHidden; };
-	void SetHidden(bool isHidden) { m_isHidden = isHidden; };
+	void SetHidden(bool isHidden) { if (m_isHidden != isHidden) { m_isHidden = isHidden; ++m_stateVersion; } };
+
+	/** Goes up each time the interaction is enabled, disabled, hidden or shown. Lets owners know to refresh their verbs. */
+	uint32 GetStateVersion() const { return m_stateVersion; };
 
 protected:
 	bool m_isEnabled { true };
 	bool m_isHidden { false };
+	uint32 m_stateVersion { 0 };
 };
 DECLARE_SHARED_POINTERS(IInteraction);
 
@@ -5,16 +5,25 @@
 #include <CryAnimation/ICryAnimation.h>
 #include "Item/Parameters/ItemParameter.h"
 #include <CryString/StringUtils.h>
+#include <CrySystem/File/ICryPak.h>
+#include "Console/CVars.h"
 
 
 namespace Chrysalis
 {
 CGameCache::CGameCache()
+	: m_pSelf(std::make_shared<CGameCache*>(this))
 {}
 
 
 CGameCache::~CGameCache()
 {
+	// Streaming callbacks still on their way will find we're gone.
+	m_pSelf.reset();
+
+	// The manifest jobs refer to their preloads, so they must finish before we go.
+	while (!m_preloads.empty())
+		CancelPreload(m_preloads.back()->id);
 }
 
 
@@ -25,10 +34,16 @@ void CGameCache::Init()
 
 void CGameCache::Reset()
 {
-	m_textureCache.clear();
-	m_materialCache.clear();
-	m_statiObjectCache.clear();
-	m_particleEffectCache.clear();
+	while (!m_preloads.empty())
+		CancelPreload(m_preloads.back()->id);
+
+	m_textureCache.Clear();
+	m_materialCache.Clear();
+	m_statiObjectCache.Clear();
+	m_particleEffectCache.Clear();
+	m_characterCache.Clear();
+	m_animationDatabaseCache.clear();
+	m_controllerDefinitionCache.clear();
 }
 
 
@@ -36,69 +51,487 @@ void CGameCache::GetMemoryUsage(ICrySizer *s) const
 {
 	s->Add(*this);
 
-	s->AddContainer(m_textureCache);
-	s->AddContainer(m_materialCache);
-	s->AddContainer(m_statiObjectCache);
-	s->AddContainer(m_particleEffectCache);
+	m_textureCache.GetMemoryUsage(s);
+	m_materialCache.GetMemoryUsage(s);
+	m_statiObjectCache.GetMemoryUsage(s);
+	m_particleEffectCache.GetMemoryUsage(s);
+
+	m_characterCache.GetMemoryUsage(s);
+	m_animationDatabaseCache.GetMemoryUsage(s);
+	m_controllerDefinitionCache.GetMemoryUsage(s);
+
+	s->AddObject(m_preloads.data(), m_preloads.capacity() * sizeof(m_preloads [0]));
+	for (const auto& pPreload : m_preloads)
+	{
+		s->AddObject(pPreload.get(), sizeof(SPreload));
+		s->AddContainer(pPreload->assetPaths);
+		s->AddContainer(pPreload->streamingCharacters);
+	}
+}
+
+
+void CGameCache::Update()
+{
+	// Always issue at least one asset a frame, so we make progress even on a very small budget.
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+	bool hasIssued {false};
+
+	for (size_t i = 0; i < m_preloads.size();)
+	{
+		SPreload& preload = *m_preloads [i];
+
+		if (preload.isParsed)
+		{
+			while ((preload.nextAsset < preload.assetPaths.size())
+				&& (!hasIssued || ((gEnv->pTimer->GetAsyncTime() - startTime).GetSeconds() < m_preloadBudget)))
+			{
+				IssuePreload(preload, preload.assetPaths [preload.nextAsset++]);
+				hasIssued = true;
+			}
+
+			// Characters are locked into the cache once their resources have streamed in, which is then a cheap operation.
+			for (size_t j = 0; j < preload.streamingCharacters.size();)
+			{
+				const string& assetPath = preload.streamingCharacters [j];
+				if (gEnv->pCharacterManager->StreamHasCharacterResources(assetPath, 0))
+				{
+					CacheCharacter(assetPath);
+					if (IsCharacterCached(assetPath))
+						++preload.loadedCount;
+					else
+						++preload.failedCount;
+
+					gEnv->pCharacterManager->StreamKeepCharacterResourcesResident(assetPath, 0, false);
+
+					preload.streamingCharacters [j] = preload.streamingCharacters.back();
+					preload.streamingCharacters.pop_back();
+				}
+				else
+				{
+					++j;
+				}
+			}
+
+			const bool isComplete = (preload.nextAsset >= preload.assetPaths.size())
+				&& (preload.streamingGeometryCount == 0) && preload.streamingCharacters.empty();
+
+			if (isComplete)
+			{
+				CryLog("Game cache preload %u finished: %u loaded, %u failed.", preload.id, preload.loadedCount, preload.failedCount);
+
+				// The callback is free to start another preload, so we're done with this one before it's called.
+				const uint32 preloadId = preload.id;
+				const uint32 loadedCount = preload.loadedCount;
+				const uint32 failedCount = preload.failedCount;
+				TPreloadCallback callback = std::move(preload.callback);
+				m_preloads.erase(m_preloads.begin() + i);
+
+				if (callback)
+					callback(preloadId, loadedCount, failedCount);
+
+				continue;
+			}
+		}
+
+		++i;
+	}
+
+	// Textures grow and shrink as their mips are streamed in and out.
+	m_textureCache.ForEach([this](const STextureKey&, TGameTextureCache::SEntry& entry)
+	{
+		m_textureCache.Resize(entry, GetResourceSize(entry.pResource.get()));
+	});
+
+	// The budgets are in megabytes.
+	m_statiObjectCache.SetBudget(size_t(std::max(g_cvars.m_gameCacheBudgetGeometry, 0)) << 20);
+	m_textureCache.SetBudget(size_t(std::max(g_cvars.m_gameCacheBudgetTexture, 0)) << 20);
+	m_materialCache.SetBudget(size_t(std::max(g_cvars.m_gameCacheBudgetMaterial, 0)) << 20);
+	m_particleEffectCache.SetBudget(size_t(std::max(g_cvars.m_gameCacheBudgetParticleEffect, 0)) << 20);
+	m_characterCache.SetBudget(size_t(std::max(g_cvars.m_gameCacheBudgetCharacter, 0)) << 20);
+
+	// Letting go of something which is held elsewhere wouldn't free it's bytes, so those are kept.
+	auto isHeldElsewhere = [](const auto& pResource) { return IsHeldElsewhere(pResource.get()); };
+	m_statiObjectCache.Trim(isHeldElsewhere);
+	m_textureCache.Trim(isHeldElsewhere);
+	m_materialCache.Trim(isHeldElsewhere);
+	m_particleEffectCache.Trim(isHeldElsewhere);
+
+	// Each user gets their own instance of a character rather than the cached one, so those in use are kept by their pins.
+	m_characterCache.Trim([](const std::shared_ptr<SCachedCharacter>&) { return false; });
+}
+
+
+bool CGameCache::Pin(ECacheCategory category, const char* assetPath, int textureFlags)
+{
+	if (!assetPath || !assetPath [0])
+		return false;
+
+	const CryHash hashName = CryStringUtils::HashString(assetPath);
+
+	switch (category)
+	{
+		case eCC_Geometry:
+			return m_statiObjectCache.Pin(hashName);
+
+		case eCC_Texture:
+			return m_textureCache.Pin(STextureKey(hashName, textureFlags));
+
+		case eCC_Material:
+			return m_materialCache.Pin(hashName);
+
+		case eCC_ParticleEffect:
+			return m_particleEffectCache.Pin(hashName);
+
+		case eCC_Character:
+			return m_characterCache.Pin(hashName);
+	}
+
+	return false;
+}
+
+
+void CGameCache::Unpin(ECacheCategory category, const char* assetPath, int textureFlags)
+{
+	if (!assetPath || !assetPath [0])
+		return;
+
+	const CryHash hashName = CryStringUtils::HashString(assetPath);
+
+	switch (category)
+	{
+		case eCC_Geometry:
+			m_statiObjectCache.Unpin(hashName);
+			break;
+
+		case eCC_Texture:
+			m_textureCache.Unpin(STextureKey(hashName, textureFlags));
+			break;
+
+		case eCC_Material:
+			m_materialCache.Unpin(hashName);
+			break;
+
+		case eCC_ParticleEffect:
+			m_particleEffectCache.Unpin(hashName);
+			break;
+
+		case eCC_Character:
+			m_characterCache.Unpin(hashName);
+			break;
+	}
+}
+
+
+template<typename Cache>
+static void LogGameCacheStatistics(const char* categoryName, const Cache& cache)
+{
+	const SResourceCacheStatistics& statistics = cache.GetStatistics();
+	const uint32 lookupCount = statistics.hitCount + statistics.missCount;
+
+	CryLogAlways("%-16s %6" PRISIZE_T " %6" PRISIZE_T " %10.2f %10.2f %10u %10u %6.1f%% %10u", categoryName,
+		cache.size(), cache.GetPinnedCount(),
+		static_cast<float>(cache.GetSizeInBytes()) / (1024.0f * 1024.0f), static_cast<float>(cache.GetBudget()) / (1024.0f * 1024.0f),
+		statistics.hitCount, statistics.missCount,
+		(lookupCount > 0) ? 100.0f * static_cast<float>(statistics.hitCount) / static_cast<float>(lookupCount) : 0.0f,
+		statistics.evictionCount);
+}
+
+
+template<typename Cache>
+static void LogGameCacheMannequinStatistics(const char* categoryName, const Cache& cache, const SResourceCacheStatistics& statistics)
+{
+	uint32 inUseCount {0};
+	for (const auto& entry : cache)
+	{
+		if (entry.value.referenceCount > 0)
+			++inUseCount;
+	}
+
+	// These are owned by the animation database manager, so they have no size we can budget or evict.
+	const uint32 lookupCount = statistics.hitCount + statistics.missCount;
+	CryLogAlways("%-16s %6" PRISIZE_T " %6u %10s %10s %10u %10u %6.1f%% %10s", categoryName, cache.size(), inUseCount, "-", "-",
+		statistics.hitCount, statistics.missCount,
+		(lookupCount > 0) ? 100.0f * static_cast<float>(statistics.hitCount) / static_cast<float>(lookupCount) : 0.0f, "-");
+}
+
+
+void CGameCache::LogStatistics() const
+{
+	CryLogAlways("%-16s %6s %6s %10s %10s %10s %10s %7s %10s", "Category", "Count", "Pinned", "Size (MB)", "Budget", "Hits", "Misses", "Hit %", "Evictions");
+	LogGameCacheStatistics("Geometry", m_statiObjectCache);
+	LogGameCacheStatistics("Texture", m_textureCache);
+	LogGameCacheStatistics("Material", m_materialCache);
+	LogGameCacheStatistics("Particle effect", m_particleEffectCache);
+	LogGameCacheStatistics("Character", m_characterCache);
+	LogGameCacheMannequinStatistics("Animation db", m_animationDatabaseCache, m_animationDatabaseStatistics);
+	LogGameCacheMannequinStatistics("Controller def", m_controllerDefinitionCache, m_controllerDefinitionStatistics);
+}
+
+
+size_t CGameCache::GetResourceSize(IStatObj* pStaticObject)
+{
+	IStatObj::SStatistics statistics;
+	pStaticObject->GetStatistics(statistics);
+
+	return statistics.nMeshSizeLoaded + statistics.nPhysProxySize;
+}
+
+
+size_t CGameCache::GetResourceSize(ITexture* pTexture)
+{
+	// Only what is resident on the device, which changes as the texture streams.
+	return pTexture->GetDeviceDataSize();
+}
+
+
+size_t CGameCache::GetResourceSize(IMaterial* pMaterial)
+{
+	ICrySizer* pSizer = gEnv->pSystem->CreateSizer();
+	pMaterial->GetMemoryUsage(pSizer);
+	const size_t sizeInBytes = pSizer->GetTotalSize();
+	pSizer->Release();
+
+	return sizeInBytes;
+}
+
+
+size_t CGameCache::GetResourceSize(IParticleEffect* pParticleEffect)
+{
+	ICrySizer* pSizer = gEnv->pSystem->CreateSizer();
+	pParticleEffect->GetMemoryUsage(pSizer);
+	const size_t sizeInBytes = pSizer->GetTotalSize();
+	pSizer->Release();
+
+	return sizeInBytes;
+}
+
+
+size_t CGameCache::GetResourceSize(ICharacterInstance* pCharacterInstance)
+{
+	ICrySizer* pSizer = gEnv->pSystem->CreateSizer();
+	pCharacterInstance->GetMemoryUsage(pSizer);
+	const size_t sizeInBytes = pSizer->GetTotalSize();
+	pSizer->Release();
+
+	return sizeInBytes;
+}
+
+
+bool CGameCache::IsHeldElsewhere(IStatObj* pStaticObject)
+{
+	return pStaticObject->GetNumRefs() > 1;
+}
+
+
+bool CGameCache::IsHeldElsewhere(ITexture* pTexture)
+{
+	// Textures only give their count back from AddRef and Release.
+	const int referenceCount = pTexture->AddRef() - 1;
+	pTexture->Release();
+
+	return referenceCount > 1;
+}
+
+
+bool CGameCache::IsHeldElsewhere(IMaterial* pMaterial)
+{
+	return pMaterial->GetNumRefs() > 1;
+}
+
+
+bool CGameCache::IsHeldElsewhere(IParticleEffect* pParticleEffect)
+{
+	return pParticleEffect->UseCount() > 1;
 }
 
 
 // ***
-// *** Character Geometry Cache
+// *** Character Cache
 // ***
 
 
-bool CGameCache::AddCachedCharacterFileModel(const ECharacterFileModelCacheType type, const char* szFileName)
+CGameCache::SCachedCharacter::SCachedCharacter(const char* _fileName, ICharacterInstance* _pInstance)
+	: fileName(_fileName)
+	, pInstance(_pInstance)
+{
+	gEnv->pCharacterManager->StreamKeepCharacterResourcesResident(fileName, 0, true);
+}
+
+
+CGameCache::SCachedCharacter::~SCachedCharacter()
+{
+	gEnv->pCharacterManager->StreamKeepCharacterResourcesResident(fileName, 0, false);
+}
+
+
+void CGameCache::CacheCharacter(const char* characterFileName)
 {
-	uint32 fileNameHash = 0;
-	bool bCached = IsCharacterFileModelCached(szFileName, fileNameHash);
+	const bool validName = (characterFileName && characterFileName [0]);
 
-	if (!bCached && szFileName && szFileName [0])
+	if (validName)
 	{
-		if (gEnv->IsEditor())
+		const CryHash hashName = CryStringUtils::HashString(characterFileName);
+
+		if (!m_characterCache.Touch(hashName))
 		{
-			ICharacterInstance *pCachedInstance = gEnv->pCharacterManager->CreateInstance(szFileName);
-			if (pCachedInstance)
+			if (ICharacterInstance* pCharacterInstance = gEnv->pCharacterManager->CreateInstance(characterFileName))
 			{
-				m_editorCharacterFileModelCache [type].insert(TEditorCharacterFileModelCache::value_type(fileNameHash, TCharacterInstancePtr(pCachedInstance)));
-				bCached = true;
+				m_characterCache.Insert(hashName, std::make_shared<SCachedCharacter>(characterFileName, pCharacterInstance),
+					GetResourceSize(pCharacterInstance));
 			}
 		}
+	}
+}
+
+
+bool CGameCache::IsCharacterCached(const char* characterFileName) const
+{
+	const bool validName = (characterFileName && characterFileName [0]);
+
+	return validName && m_characterCache.Find(CryStringUtils::HashString(characterFileName));
+}
+
+
+CGameCache::TCharacterInstanceSmartPtr CGameCache::AcquireCharacter(const char* characterFileName)
+{
+	const bool validName = (characterFileName && characterFileName [0]);
+
+	if (validName)
+	{
+		CacheCharacter(characterFileName);
+
+		return AcquireCachedCharacter(m_characterCache.Find(CryStringUtils::HashString(characterFileName)));
+	}
+
+	return nullptr;
+}
+
+
+void CGameCache::ReleaseCharacter(CryHash characterFileHash)
+{
+	m_characterCache.Unpin(characterFileHash);
+}
+
+
+CGameCache::TCharacterInstanceSmartPtr CGameCache::AcquireCachedCharacter(TGameCharacterCache::SEntry* pEntry)
+{
+	if (!pEntry)
+		return nullptr;
+
+	// The model, skeleton and animation set are already resident, so this only needs to build the instance.
+	TCharacterInstanceSmartPtr pCharacterInstance = gEnv->pCharacterManager->CreateInstance(pEntry->pResource->fileName);
+	if (pCharacterInstance)
+		++pEntry->pinCount;
+
+	return pCharacterInstance;
+}
+
+
+// ***
+// *** Animation Database Cache
+// ***
+
+
+void CGameCache::CacheAnimationDatabase(const char* databaseFileName)
+{
+	const bool validName = (databaseFileName && databaseFileName [0]);
+
+	if (validName)
+	{
+		const CryHash hashName = CryStringUtils::HashString(databaseFileName);
+
+		if (m_animationDatabaseCache.Find(hashName))
+		{
+			++m_animationDatabaseStatistics.hitCount;
+		}
 		else
 		{
-			bool hasLoaded = gEnv->pCharacterManager->LoadAndLockResources(szFileName, 0);
-			if (hasLoaded)
+			++m_animationDatabaseStatistics.missCount;
+
+			IAnimationDatabaseManager& animationDatabaseManager = gEnv->pGameFramework->GetMannequinInterface().GetAnimationDatabaseManager();
+			if (const IAnimationDatabase* pDatabase = animationDatabaseManager.Load(databaseFileName))
 			{
+				m_animationDatabaseCache [hashName].pResource = pDatabase;
 			}
 		}
 	}
-
-	return bCached;
 }
 
 
-ILINE bool CGameCache::IsCharacterFileModelCached(const char* szFileName, uint32& outputFileNameHash) const
+const IAnimationDatabase* CGameCache::AcquireAnimationDatabase(const char* databaseFileName)
 {
-	outputFileNameHash = 0;
+	const bool validName = (databaseFileName && databaseFileName [0]);
 
-	if (szFileName && szFileName [0])
+	if (validName)
 	{
-		outputFileNameHash = CCrc32::Compute(szFileName);
-		if (gEnv->IsEditor())
+		CacheAnimationDatabase(databaseFileName);
+
+		if (auto pEntry = m_animationDatabaseCache.Find(CryStringUtils::HashString(databaseFileName)))
 		{
-			for (uint32 i = eCFMCache_Default; i < eCFMCache_COUNT; ++i)
-			{
-				TEditorCharacterFileModelCache::const_iterator itCache = m_editorCharacterFileModelCache [i].find(outputFileNameHash);
+			++pEntry->referenceCount;
+			return pEntry->pResource;
+		}
+	}
+
+	return nullptr;
+}
+
+
+void CGameCache::ReleaseAnimationDatabase(CryHash databaseFileHash)
+{
+	if (auto pEntry = m_animationDatabaseCache.Find(databaseFileHash))
+	{
+		CRY_ASSERT_MESSAGE(pEntry->referenceCount > 0, "Animation database released more times than it was acquired.");
+		if (pEntry->referenceCount > 0)
+			--pEntry->referenceCount;
+	}
+}
+
 
-				if (itCache == m_editorCharacterFileModelCache [i].end())
-					continue;
+const SControllerDef* CGameCache::AcquireControllerDefinition(const char* controllerDefinitionFileName)
+{
+	const bool validName = (controllerDefinitionFileName && controllerDefinitionFileName [0]);
+
+	if (validName)
+	{
+		const CryHash hashName = CryStringUtils::HashString(controllerDefinitionFileName);
+		auto pEntry = m_controllerDefinitionCache.Find(hashName);
 
-				return true;
+		if (pEntry)
+		{
+			++m_controllerDefinitionStatistics.hitCount;
+		}
+		else
+		{
+			++m_controllerDefinitionStatistics.missCount;
+
+			IAnimationDatabaseManager& animationDatabaseManager = gEnv->pGameFramework->GetMannequinInterface().GetAnimationDatabaseManager();
+			if (const SControllerDef* pControllerDefinition = animationDatabaseManager.LoadControllerDef(controllerDefinitionFileName))
+			{
+				pEntry = &m_controllerDefinitionCache [hashName];
+				pEntry->pResource = pControllerDefinition;
 			}
 		}
+
+		if (pEntry)
+		{
+			++pEntry->referenceCount;
+			return pEntry->pResource;
+		}
 	}
 
-	return false;
+	return nullptr;
+}
+
+
+void CGameCache::ReleaseControllerDefinition(CryHash controllerDefinitionFileHash)
+{
+	if (auto pEntry = m_controllerDefinitionCache.Find(controllerDefinitionFileHash))
+	{
+		CRY_ASSERT_MESSAGE(pEntry->referenceCount > 0, "Controller definition released more times than it was acquired.");
+		if (pEntry->referenceCount > 0)
+			--pEntry->referenceCount;
+	}
 }
 
 
@@ -114,20 +547,20 @@ void CGameCache::CacheGeometry(const char* geometryFileName)
 	{
 		stack_string ext(PathUtil::GetExt(geometryFileName));
 
-		if ((ext == "cdf") || (ext == "chr") || (ext == "cga"))
+		if ((ext == "cdf") || (ext == "chr") || (ext == "cga") || (ext == "skin"))
 		{
-			AddCachedCharacterFileModel(eCFMCache_Default, geometryFileName);
+			CacheCharacter(geometryFileName);
 		}
 		else
 		{
 			const CryHash hashName = CryStringUtils::HashString(geometryFileName);
 
-			if (m_statiObjectCache.find(hashName) == m_statiObjectCache.end())
+			if (!m_statiObjectCache.Touch(hashName))
 			{
 				IStatObj* pStaticObject = gEnv->p3DEngine->LoadStatObj(geometryFileName);
 				if (pStaticObject)
 				{
-					m_statiObjectCache.insert(TGameStaticObjectCacheMap::value_type(hashName, TStaticObjectSmartPtr(pStaticObject)));
+					m_statiObjectCache.Insert(hashName, TStaticObjectSmartPtr(pStaticObject), GetResourceSize(pStaticObject));
 				}
 			}
 		}
@@ -135,6 +568,20 @@ void CGameCache::CacheGeometry(const char* geometryFileName)
 }
 
 
+CGameCache::TStaticObjectSmartPtr CGameCache::GetGeometry(const char* geometryFileName)
+{
+	const bool validName = (geometryFileName && geometryFileName [0]);
+
+	if (validName)
+	{
+		if (auto pEntry = m_statiObjectCache.Touch(CryStringUtils::HashString(geometryFileName)))
+			return pEntry->pResource;
+	}
+
+	return nullptr;
+}
+
+
 // ***
 // *** Texture Cache
 // ***
@@ -148,12 +595,12 @@ void CGameCache::CacheTexture(const char* textureFileName, const int textureFlag
 	{
 		const STextureKey textureKey(CryStringUtils::HashString(textureFileName), textureFlags);
 
-		if (m_textureCache.find(textureKey) == m_textureCache.end())
+		if (!m_textureCache.Touch(textureKey))
 		{
 			ITexture* pTexture = gEnv->pRenderer->EF_LoadTexture(textureFileName, textureFlags);
 			if (pTexture)
 			{
-				m_textureCache.insert(TGameTextureCacheMap::value_type(textureKey, TTextureSmartPtr(pTexture)));
+				m_textureCache.Insert(textureKey, TTextureSmartPtr(pTexture), GetResourceSize(pTexture));
 				pTexture->Release();
 			}
 		}
@@ -161,6 +608,20 @@ void CGameCache::CacheTexture(const char* textureFileName, const int textureFlag
 }
 
 
+CGameCache::TTextureSmartPtr CGameCache::GetTexture(const char* textureFileName, const int textureFlags)
+{
+	const bool validName = (textureFileName && textureFileName [0]);
+
+	if (validName)
+	{
+		if (auto pEntry = m_textureCache.Touch(STextureKey(CryStringUtils::HashString(textureFileName), textureFlags)))
+			return pEntry->pResource;
+	}
+
+	return nullptr;
+}
+
+
 // ***
 // *** Material Cache
 // ***
@@ -174,28 +635,27 @@ void CGameCache::CacheMaterial(const char* materialFileName)
 	{
 		const CryHash hashName = CryStringUtils::HashString(materialFileName);
 
-		if (m_materialCache.find(hashName) == m_materialCache.end())
+		if (!m_materialCache.Touch(hashName))
 		{
 			IMaterial* pMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(materialFileName);
 			if (pMaterial)
 			{
-				m_materialCache.insert(TGameMaterialCacheMap::value_type(hashName, TMaterialSmartPtr(pMaterial)));
+				m_materialCache.Insert(hashName, TMaterialSmartPtr(pMaterial), GetResourceSize(pMaterial));
 			}
 		}
 	}
 }
 
 
-CGameCache::TMaterialSmartPtr CGameCache::GetMaterial(const char* materialFileName) const
+CGameCache::TMaterialSmartPtr CGameCache::GetMaterial(const char* materialFileName)
 {
 	const bool validName = (materialFileName && materialFileName [0]);
 
 	if (validName)
 	{
 		const CryHash hashName = CryStringUtils::HashString(materialFileName);
-		auto it = m_materialCache.find(hashName);
-		if (it != m_materialCache.end())
-			return it->second;
+		if (auto pEntry = m_materialCache.Touch(hashName))
+			return pEntry->pResource;
 	}
 
 	return nullptr;
@@ -215,28 +675,270 @@ void CGameCache::CacheParticleEffect(const char* particleEffectFileName)
 	{
 		const CryHash hashName = CryStringUtils::HashString(particleEffectFileName);
 
-		if (m_particleEffectCache.find(hashName) == m_particleEffectCache.end())
+		if (!m_particleEffectCache.Touch(hashName))
 		{
 			IParticleEffect* pParticleEffect = gEnv->p3DEngine->GetParticleManager()->FindEffect(particleEffectFileName, "CGameCache::CacheParticleEffect");
 			if (pParticleEffect)
 			{
-				m_particleEffectCache.insert(TGameParticleEffectCacheMap::value_type(hashName, TParticleEffectSmartPtr(pParticleEffect)));
+				m_particleEffectCache.Insert(hashName, TParticleEffectSmartPtr(pParticleEffect), GetResourceSize(pParticleEffect));
 			}
 		}
 	}
 }
 
 
-CGameCache::TParticleEffectSmartPtr CGameCache::GetParticleEffect(const char* particleEffectFileName) const
+CGameCache::TParticleEffectSmartPtr CGameCache::GetParticleEffect(const char* particleEffectFileName)
 {
 	const bool validName = (particleEffectFileName && particleEffectFileName [0]);
 
 	if (validName)
 	{
 		const CryHash hashName = CryStringUtils::HashString(particleEffectFileName);
-		auto it = m_particleEffectCache.find(hashName);
-		if (it != m_particleEffectCache.end())
-			return it->second;
+		if (auto pEntry = m_particleEffectCache.Touch(hashName))
+			return pEntry->pResource;
+	}
+
+	return nullptr;
+}
+
+
+// ***
+// *** Preloading
+// ***
+
+
+uint32 CGameCache::Preload(const std::vector<string>& assetPaths, TPreloadCallback callback)
+{
+	auto pPreload = stl::make_unique<SPreload>();
+	pPreload->id = m_nextPreloadId++;
+	pPreload->assetPaths = assetPaths;
+	pPreload->callback = std::move(callback);
+
+	const uint32 preloadId = pPreload->id;
+	m_preloads.push_back(std::move(pPreload));
+
+	return preloadId;
+}
+
+
+uint32 CGameCache::PreloadManifest(const char* manifestFileName, TPreloadCallback callback)
+{
+	auto pPreload = stl::make_unique<SPreload>();
+	pPreload->id = m_nextPreloadId++;
+	pPreload->callback = std::move(callback);
+	pPreload->isParsed = false;
+
+	// The preload is held by pointer, so it stays put while the job fills it in.
+	SPreload* pParsingPreload = pPreload.get();
+	auto parse = [pParsingPreload, fileName = string(manifestFileName)]()
+	{
+		if (XmlNodeRef manifestNode = GetISystem()->LoadXmlFromFile(fileName))
+		{
+			pParsingPreload->assetPaths.reserve(manifestNode->getChildCount());
+
+			for (int i = 0, n = manifestNode->getChildCount(); i < n; ++i)
+			{
+				XmlNodeRef assetNode = manifestNode->getChild(i);
+				const char* assetPath = assetNode->getAttr("path");
+				if (assetNode->isTag("Asset") && assetPath [0])
+					pParsingPreload->assetPaths.push_back(assetPath);
+			}
+		}
+		else
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Unable to load the preload manifest %s", fileName.c_str());
+		}
+
+		pParsingPreload->isParsed = true;
+	};
+
+	if (gEnv->pJobManager)
+	{
+		pPreload->hasJob = true;
+		gEnv->pJobManager->AddLambdaJob("CGameCache::PreloadManifest", parse, JobManager::eRegularPriority, &pPreload->jobState);
+	}
+	else
+	{
+		parse();
+	}
+
+	const uint32 preloadId = pPreload->id;
+	m_preloads.push_back(std::move(pPreload));
+
+	return preloadId;
+}
+
+
+uint32 CGameCache::WarmUpLevel()
+{
+	const char* warmUpFileName = gEnv->p3DEngine->GetLevelFilePath("GameCacheWarmUp.xml");
+	if (!gEnv->pCryPak->IsFileExist(warmUpFileName))
+		return 0;
+
+	return PreloadManifest(warmUpFileName);
+}
+
+
+void CGameCache::CancelPreload(uint32 preloadId)
+{
+	auto it = std::find_if(m_preloads.begin(), m_preloads.end(), [preloadId](const std::unique_ptr<SPreload>& pPreload)
+	{
+		return pPreload->id == preloadId;
+	});
+
+	if (it != m_preloads.end())
+	{
+		SPreload& preload = **it;
+
+		if (preload.hasJob)
+			gEnv->pJobManager->WaitForJob(preload.jobState);
+
+		// Let the streaming know we no longer need the characters kept in memory.
+		for (const auto& assetPath : preload.streamingCharacters)
+			gEnv->pCharacterManager->StreamKeepCharacterResourcesResident(assetPath, 0, false);
+
+		m_preloads.erase(it);
+	}
+}
+
+
+bool CGameCache::IsPreloadComplete(uint32 preloadId) const
+{
+	return FindPreload(preloadId) == nullptr;
+}
+
+
+float CGameCache::GetPreloadProgress(uint32 preloadId) const
+{
+	const SPreload* pPreload = FindPreload(preloadId);
+	if (!pPreload)
+		return 1.0f;
+
+	if (!pPreload->isParsed || pPreload->assetPaths.empty())
+		return 0.0f;
+
+	return static_cast<float>(pPreload->loadedCount + pPreload->failedCount) / static_cast<float>(pPreload->assetPaths.size());
+}
+
+
+CGameCache::EPreloadAssetType CGameCache::GetPreloadAssetType(const char* assetPath)
+{
+	stack_string ext(PathUtil::GetExt(assetPath));
+	ext.MakeLower();
+
+	if ((ext == "cdf") || (ext == "chr") || (ext == "cga") || (ext == "skin"))
+		return ePAT_Character;
+
+	if (ext == "adb")
+		return ePAT_AnimationDatabase;
+
+	if ((ext == "dds") || (ext == "tif") || (ext == "png"))
+		return ePAT_Texture;
+
+	if (ext == "mtl")
+		return ePAT_Material;
+
+	if (ext.empty())
+		return ePAT_ParticleEffect;
+
+	return ePAT_Geometry;
+}
+
+
+void CGameCache::IssuePreload(SPreload& preload, const string& assetPath)
+{
+	const EPreloadAssetType assetType = GetPreloadAssetType(assetPath);
+
+	// Anything which streams needs to exist, or we would be waiting on it forever.
+	const bool isStreamed = (assetType == ePAT_Geometry) || (assetType == ePAT_Character);
+	if (isStreamed && !gEnv->pCryPak->IsFileExist(assetPath))
+	{
+		++preload.failedCount;
+		return;
+	}
+
+	bool isCached {false};
+
+	switch (assetType)
+	{
+		case ePAT_Geometry:
+			if (m_statiObjectCache.Find(CryStringUtils::HashString(assetPath)))
+			{
+				isCached = true;
+				break;
+			}
+
+			// The engine calls us back on the main thread once the object has streamed in. There's no way to withdraw the
+			// request, so the callback checks we're still around and leaves the rest to the preload id.
+			++preload.streamingGeometryCount;
+			gEnv->p3DEngine->LoadStatObjAsync([pWeakSelf = std::weak_ptr<CGameCache*>(m_pSelf), preloadId = preload.id, assetPath](IStatObj* pStaticObject)
+			{
+				if (auto pSelf = pWeakSelf.lock())
+					(*pSelf)->OnPreloadGeometryLoaded(preloadId, assetPath, pStaticObject);
+			}, assetPath);
+			return;
+
+		case ePAT_Character:
+			gEnv->pCharacterManager->StreamKeepCharacterResourcesResident(assetPath, 0, true);
+			preload.streamingCharacters.push_back(assetPath);
+			return;
+
+		case ePAT_AnimationDatabase:
+			CacheAnimationDatabase(assetPath);
+			isCached = m_animationDatabaseCache.Find(CryStringUtils::HashString(assetPath)) != nullptr;
+			break;
+
+		case ePAT_Texture:
+			// Only the texture header is read here, the mips are streamed in by the renderer.
+			CacheTexture(assetPath, 0);
+			isCached = m_textureCache.Find(STextureKey(CryStringUtils::HashString(assetPath), 0)) != nullptr;
+			break;
+
+		case ePAT_Material:
+			CacheMaterial(assetPath);
+			isCached = m_materialCache.Find(CryStringUtils::HashString(assetPath)) != nullptr;
+			break;
+
+		case ePAT_ParticleEffect:
+			CacheParticleEffect(assetPath);
+			isCached = m_particleEffectCache.Find(CryStringUtils::HashString(assetPath)) != nullptr;
+			break;
+	}
+
+	if (isCached)
+		++preload.loadedCount;
+	else
+		++preload.failedCount;
+}
+
+
+void CGameCache::OnPreloadGeometryLoaded(uint32 preloadId, const string& assetPath, IStatObj* pStaticObject)
+{
+	// The preload may have been cancelled, or the cache reset, while the object was streaming.
+	SPreload* pPreload = FindPreload(preloadId);
+	if (!pPreload)
+		return;
+
+	--pPreload->streamingGeometryCount;
+
+	if (pStaticObject)
+	{
+		m_statiObjectCache.Insert(CryStringUtils::HashString(assetPath), TStaticObjectSmartPtr(pStaticObject), GetResourceSize(pStaticObject));
+		++pPreload->loadedCount;
+	}
+	else
+	{
+		++pPreload->failedCount;
+	}
+}
+
+
+CGameCache::SPreload* CGameCache::FindPreload(uint32 preloadId) const
+{
+	for (const auto& pPreload : m_preloads)
+	{
+		if (pPreload->id == preloadId)
+			return pPreload.get();
 	}
 
 	return nullptr;
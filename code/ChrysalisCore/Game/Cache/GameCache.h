@@ -9,6 +9,10 @@ trying to reduce the surface area and dependancies of the code.
 #pragma once
 
 #include <Utility/CryHash.h>
+#include <Utility/FlatHashMap.h>
+#include "ResourceCache.h"
+#include <CryThreading/IJobManager.h>
+#include <ICryMannequin.h>
 
 
 namespace Chrysalis
@@ -18,8 +22,6 @@ struct CItemParameter;
 
 // TODO: Add more caches, and ability to query for items in the caches.
 // TODO: Implement material loading for geometry cache. See ItemResourceCache for how.
-// TODO: Add animation cache.
-// TODO: Flush caches.
 
 class CGameCache
 {
@@ -53,29 +55,173 @@ public:
 	void GetMemoryUsage(ICrySizer *s) const;
 
 
+	/**
+	Issues the next preload requests and reports any preloads which have finished. Each category is then trimmed back to
+	it's budget. Must be called on the main thread.
+	**/
+	void Update();
+
+
+	/** The kinds of resource which are cached. Each has it's own budget and statistics. */
+	enum ECacheCategory
+	{
+		eCC_Geometry,
+		eCC_Texture,
+		eCC_Material,
+		eCC_ParticleEffect,
+		eCC_Character,
+		eCC_COUNT,
+	};
+
+
+	/**
+	Keeps a cached resource loaded regardless of the budget, until it's unpinned. Pins are counted, so each needs a
+	matching unpin.
+
+	\param	category	 The category of the resource.
+	\param	assetPath	 The resource's path, or name for particle effects.
+	\param	textureFlags The flags the texture was cached with. Only used for textures.
+
+	\return True if the resource is cached and is now pinned.
+	**/
+	bool Pin(ECacheCategory category, const char* assetPath, int textureFlags = 0);
+
+
+	/** Removes a pin added by Pin. */
+	void Unpin(ECacheCategory category, const char* assetPath, int textureFlags = 0);
+
+
+	/**
+	Writes the size, budget, hits, misses and evictions for each category to the log. The budgets are set by the
+	gamecache_budget_* cvars.
+	**/
+	void LogStatistics() const;
+
+private:
+	/** Bytes held by a resource. */
+	static size_t GetResourceSize(IStatObj* pStaticObject);
+	static size_t GetResourceSize(ITexture* pTexture);
+	static size_t GetResourceSize(IMaterial* pMaterial);
+	static size_t GetResourceSize(IParticleEffect* pParticleEffect);
+	static size_t GetResourceSize(ICharacterInstance* pCharacterInstance);
+
+	/** Does anything besides the cache hold a reference to the resource? */
+	static bool IsHeldElsewhere(IStatObj* pStaticObject);
+	static bool IsHeldElsewhere(ITexture* pTexture);
+	static bool IsHeldElsewhere(IMaterial* pMaterial);
+	static bool IsHeldElsewhere(IParticleEffect* pParticleEffect);
+
+
+
 	// ***
-	// *** Character Geometry Cache
+	// *** Character Cache
 	// ***
 
 public:
-	enum ECharacterFileModelCacheType
+	typedef _smart_ptr<ICharacterInstance> TCharacterInstanceSmartPtr;
+
+	/**
+	Loads a character (cdf, chr, cga or skin) into the cache. The cache keeps an instance of it's own, which holds the
+	model, skeleton and animation set resident, so instances created later for the same rig share the loaded data.
+
+	\param	characterFileName The character file name.
+	**/
+	void CacheCharacter(const char* characterFileName);
+
+
+	/** Is this character in the cache? */
+	bool IsCharacterCached(const char* characterFileName) const;
+
+
+	/**
+	Creates an instance of a character for an entity, caching the character first if needed. The character is kept in
+	the cache, regardless of budget, until every acquire is matched by a release.
+
+	\param	characterFileName The character file name.
+
+	\return The new instance, or null if the character couldn't be loaded.
+	**/
+	TCharacterInstanceSmartPtr AcquireCharacter(const char* characterFileName);
+
+
+	/** Releases a character acquired by AcquireCharacter. The cache may let go of the character once it's not in use. */
+	void ReleaseCharacter(CryHash characterFileHash);
+
+private:
+	/** A character held by the cache. While this is alive, the character's resources are kept resident. */
+	struct SCachedCharacter
 	{
-		eCFMCache_Default = 0,
-		eCFMCache_Client,
-		eCFMCache_Shadow,
-		eCFMCache_COUNT,
+		SCachedCharacter(const char* _fileName, ICharacterInstance* _pInstance);
+		~SCachedCharacter();
+
+		string fileName;
+		TCharacterInstanceSmartPtr pInstance;
 	};
 
-	typedef std::shared_ptr<ICharacterInstance> TCharacterInstancePtr;
+	typedef TResourceCache<CryHash, std::shared_ptr<SCachedCharacter>> TGameCharacterCache;
+	TGameCharacterCache m_characterCache;
+
+	/** Pins a cached character and creates a new instance of it. */
+	TCharacterInstanceSmartPtr AcquireCachedCharacter(TGameCharacterCache::SEntry* pEntry);
+
+
+	// ***
+	// *** Animation Database Cache
+	// ***
+
+public:
+	/**
+	Loads a Mannequin animation database (adb) into the cache. The databases are owned by the animation database
+	manager and are never unloaded, so the cache only saves finding them again by name.
+
+	\param	databaseFileName The animation database file name.
+	**/
+	void CacheAnimationDatabase(const char* databaseFileName);
 
-	// Character file model cache helpers
-	bool AddCachedCharacterFileModel(const ECharacterFileModelCacheType type, const char* szFileName);
-	bool IsCharacterFileModelCached(const char* szFileName, uint32& outputFileNameHash) const;
+
+	/**
+	Gets an animation database, caching it first if needed. Each acquire should be matched by a release.
+
+	\param	databaseFileName The animation database file name.
+
+	\return The animation database, or null if it couldn't be loaded.
+	**/
+	const IAnimationDatabase* AcquireAnimationDatabase(const char* databaseFileName);
+
+
+	/** Releases an animation database acquired by AcquireAnimationDatabase. */
+	void ReleaseAnimationDatabase(CryHash databaseFileHash);
+
+
+	/**
+	Gets a Mannequin controller definition, caching it first if needed. Each acquire should be matched by a release.
+
+	\param	controllerDefinitionFileName The controller definition file name.
+
+	\return The controller definition, or null if it couldn't be loaded.
+	**/
+	const SControllerDef* AcquireControllerDefinition(const char* controllerDefinitionFileName);
+
+
+	/** Releases a controller definition acquired by AcquireControllerDefinition. */
+	void ReleaseControllerDefinition(CryHash controllerDefinitionFileHash);
 
 private:
-	// Character file model cache.
-	typedef std::map<uint32, TCharacterInstancePtr> TEditorCharacterFileModelCache;
-	TEditorCharacterFileModelCache   m_editorCharacterFileModelCache [eCFMCache_COUNT];
+	/** A Mannequin resource, which is owned by the animation database manager, and the number of users it has. */
+	template<typename Resource>
+	struct TMannequinEntry
+	{
+		const Resource* pResource {nullptr};
+		uint32 referenceCount {0};
+	};
+
+	typedef TFlatHashMap<CryHash, TMannequinEntry<IAnimationDatabase>> TGameAnimationDatabaseCache;
+	TGameAnimationDatabaseCache m_animationDatabaseCache;
+	SResourceCacheStatistics m_animationDatabaseStatistics;
+
+	typedef TFlatHashMap<CryHash, TMannequinEntry<SControllerDef>> TGameControllerDefinitionCache;
+	TGameControllerDefinitionCache m_controllerDefinitionCache;
+	SResourceCacheStatistics m_controllerDefinitionStatistics;
 
 
 	// ***
@@ -86,10 +232,11 @@ public:
 	typedef _smart_ptr<IStatObj> TStaticObjectSmartPtr;
 
 	void CacheGeometry(const char* geometryObjectFileName);
+	TStaticObjectSmartPtr GetGeometry(const char* geometryObjectFileName);
 
 private:
-	typedef std::map<CryHash, TStaticObjectSmartPtr> TGameStaticObjectCacheMap;
-	TGameStaticObjectCacheMap m_statiObjectCache;
+	typedef TResourceCache<CryHash, TStaticObjectSmartPtr> TGameStaticObjectCache;
+	TGameStaticObjectCache m_statiObjectCache;
 
 
 	// ***
@@ -109,11 +256,16 @@ public:
 			, textureFlags(_textureFlags)
 		{}
 
-		struct compare
+		bool operator==(const STextureKey& rhs) const
+		{
+			return (nameHash == rhs.nameHash) && (textureFlags == rhs.textureFlags);
+		}
+
+		struct hash
 		{
-			bool operator()(const STextureKey& k1, const STextureKey& k2) const
+			size_t operator()(const STextureKey& key) const
 			{
-				return (k1.nameHash < k2.nameHash) || ((k1.nameHash == k2.nameHash) && (k1.textureFlags < k2.textureFlags));
+				return (uint64(key.nameHash) << 32) | uint32(key.textureFlags);
 			}
 		};
 
@@ -123,10 +275,11 @@ public:
 
 	typedef _smart_ptr<ITexture> TTextureSmartPtr;
 	void CacheTexture(const char* textureFileName, const int textureFlags);
+	TTextureSmartPtr GetTexture(const char* textureFileName, const int textureFlags);
 
 private:
-	typedef	std::map<STextureKey, TTextureSmartPtr, STextureKey::compare> TGameTextureCacheMap;
-	TGameTextureCacheMap m_textureCache;
+	typedef	TResourceCache<STextureKey, TTextureSmartPtr, STextureKey::hash> TGameTextureCache;
+	TGameTextureCache m_textureCache;
 
 
 	// ***
@@ -134,14 +287,15 @@ private:
 	// ***
 
 public:
-	typedef std::shared_ptr<IMaterial> TMaterialSmartPtr;
+	// Materials are reference counted by the engine, so they can't be held by a std::shared_ptr once they can be evicted.
+	typedef _smart_ptr<IMaterial> TMaterialSmartPtr;
 
 	void CacheMaterial(const char* materialFileName);
-	TMaterialSmartPtr GetMaterial(const char* materialFileName) const;
+	TMaterialSmartPtr GetMaterial(const char* materialFileName);
 
 private:
-	typedef std::map<CryHash, TMaterialSmartPtr> TGameMaterialCacheMap;
-	TGameMaterialCacheMap m_materialCache;
+	typedef TResourceCache<CryHash, TMaterialSmartPtr> TGameMaterialCache;
+	TGameMaterialCache m_materialCache;
 
 
 	// ***
@@ -149,13 +303,150 @@ private:
 	// ***
 
 public:
-	typedef std::shared_ptr<IParticleEffect> TParticleEffectSmartPtr;
+	// Particle effects are reference counted by the engine, the same as materials.
+	typedef _smart_ptr<IParticleEffect> TParticleEffectSmartPtr;
 
 	void CacheParticleEffect(const char* particleEffectFileName);
-	TParticleEffectSmartPtr GetParticleEffect(const char* particleEffectFileName) const;
+	TParticleEffectSmartPtr GetParticleEffect(const char* particleEffectFileName);
 
 private:
-	typedef std::map<CryHash, TParticleEffectSmartPtr> TGameParticleEffectCacheMap;
-	TGameParticleEffectCacheMap m_particleEffectCache;
+	typedef TResourceCache<CryHash, TParticleEffectSmartPtr> TGameParticleEffectCache;
+	TGameParticleEffectCache m_particleEffectCache;
+
+
+	// ***
+	// *** Preloading
+	// ***
+
+public:
+	/**
+	Called once every asset in a preload has either loaded or failed to.
+
+	\param	preloadId   The preload which finished.
+	\param	loadedCount Number of assets which are now in the cache.
+	\param	failedCount Number of assets which couldn't be loaded.
+	**/
+	typedef std::function<void(uint32 preloadId, uint32 loadedCount, uint32 failedCount)> TPreloadCallback;
+
+
+	/**
+	Starts loading a list of assets into the cache without stalling the main thread. The kind of each asset is taken from
+	it's extension: geometry (cgf), characters (cdf, chr, cga, skin), animation databases (adb), textures (dds, tif, png),
+	materials (mtl), and anything without an extension is taken to be a particle effect name.
+
+	Geometry, characters and textures are handed to the engine's streaming, and complete when it's finished with them.
+	Animation databases, materials and particle effects can only be loaded on the main thread, so they are loaded a few
+	at a time during Update, for as long as the preload budget allows.
+
+	\param	assetPaths The asset paths.
+	\param	callback   Optional. Called from Update once the preload has finished.
+
+	\return An id for the preload.
+	**/
+	uint32 Preload(const std::vector<string>& assetPaths, TPreloadCallback callback = nullptr);
+
+
+	/**
+	Starts loading the assets listed in a manifest file. The manifest is read on a background job, and the assets are
+	then loaded just like Preload. The file is of the form:
+
+	<Preload>
+		<Asset path="Objects/props/crate.cgf" />
+	</Preload>
+
+	\param	manifestFileName The manifest file name.
+	\param	callback		 Optional. Called from Update once the preload has finished.
+
+	\return An id for the preload.
+	**/
+	uint32 PreloadManifest(const char* manifestFileName, TPreloadCallback callback = nullptr);
+
+
+	/**
+	Preloads the warm-up list for the level which is loading, if it has one. This is a manifest named
+	GameCacheWarmUp.xml in the level folder, listing the characters, animation databases and other assets the level
+	will need, so actors spawned later find them already resident.
+
+	\return An id for the preload, or zero if the level has no warm-up list.
+	**/
+	uint32 WarmUpLevel();
+
+
+	/** Stops a preload. Assets which have already loaded are left in the cache, and the callback is never called. */
+	void CancelPreload(uint32 preloadId);
+
+
+	/** Is this preload finished? Unknown ids, including cancelled preloads, count as finished. */
+	bool IsPreloadComplete(uint32 preloadId) const;
+
+
+	/** Progress through a preload in the range [0, 1]. This stays at zero while a manifest is being read. */
+	float GetPreloadProgress(uint32 preloadId) const;
+
+
+	/** Wall time, in seconds, that Update may spend loading assets which must be loaded on the main thread. */
+	float GetPreloadBudget() const { return m_preloadBudget; }
+	void SetPreloadBudget(float preloadBudget) { m_preloadBudget = preloadBudget; }
+
+private:
+	enum EPreloadAssetType
+	{
+		ePAT_Geometry,
+		ePAT_Character,
+		ePAT_AnimationDatabase,
+		ePAT_Texture,
+		ePAT_Material,
+		ePAT_ParticleEffect,
+	};
+
+	struct SPreload
+	{
+		uint32 id {0};
+
+		/** The asset paths. Only touched by the manifest job until isParsed is set. */
+		std::vector<string> assetPaths;
+
+		/** The next asset to issue. */
+		size_t nextAsset {0};
+
+		/** Characters which have been handed to the engine's streaming and haven't arrived yet. */
+		std::vector<string> streamingCharacters;
+
+		/** Geometry which has been handed to the engine's streaming and hasn't arrived yet. */
+		uint32 streamingGeometryCount {0};
+
+		uint32 loadedCount {0};
+		uint32 failedCount {0};
+
+		TPreloadCallback callback;
+
+		std::atomic<bool> isParsed {true};
+		JobManager::SJobState jobState;
+		bool hasJob {false};
+	};
+
+	/** Works out the kind of asset from it's path. */
+	static EPreloadAssetType GetPreloadAssetType(const char* assetPath);
+
+	/** Starts loading one asset for a preload. Assets which can't be streamed are loaded right away. */
+	void IssuePreload(SPreload& preload, const string& assetPath);
+
+	/** Called by the engine's streaming once a piece of geometry for a preload has loaded. */
+	void OnPreloadGeometryLoaded(uint32 preloadId, const string& assetPath, IStatObj* pStaticObject);
+
+	/** Gets the preload with this id, or null if it's finished or was cancelled. */
+	SPreload* FindPreload(uint32 preloadId) const;
+
+	/** The preloads which haven't finished. These are held by pointer since the manifest jobs refer to them. */
+	std::vector<std::unique_ptr<SPreload>> m_preloads;
+
+	/** The id the next preload will be given. Ids are never reused, so a stale id can't match a later preload. */
+	uint32 m_nextPreloadId {1};
+
+	/** Handed to the engine's streaming by weak pointer, so a callback arriving after we're gone can tell. */
+	std::shared_ptr<CGameCache*> m_pSelf;
+
+	/** Wall time, in seconds, that Update may spend loading assets which must be loaded on the main thread. */
+	float m_preloadBudget {0.002f};
 };
 }
\ No newline at end of file
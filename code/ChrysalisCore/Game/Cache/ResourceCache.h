@@ -0,0 +1,256 @@
+#pragma once
+
+#include <Utility/FlatHashMap.h>
+
+
+namespace Chrysalis
+{
+/** How often a cache has been asked for resources it did and didn't have, and how many it has let go of. */
+struct SResourceCacheStatistics
+{
+	uint32 hitCount {0};
+	uint32 missCount {0};
+	uint32 evictionCount {0};
+};
+
+
+/**
+Holds a reference to a set of loaded resources to keep them loaded. Each entry records how many bytes it's resource
+holds, when it was last used, and how many users have pinned it. Once the cache is over budget, the least recently used
+entries are let go of, oldest first. Pinned entries are never let go of, and neither are entries whose resource is still
+held outside the cache, since letting go of those wouldn't free anything. A cache with everything in use can stay over
+budget.
+
+\tparam	Key		 The key, usually a hash of the resource name.
+\tparam	Resource A smart pointer to the resource.
+\tparam	KeyHash	 Hashes a key to a size_t.
+**/
+template<typename Key, typename Resource, typename KeyHash = std::hash<Key>>
+class TResourceCache
+{
+public:
+	struct SEntry
+	{
+		/** The resource. This reference is what keeps it loaded. */
+		Resource pResource;
+
+		/** Number of users who need this kept in the cache. */
+		uint32 pinCount {0};
+
+		/** The last frame time this was asked for. */
+		CTimeValue lastTouchTime;
+
+		/** Bytes held by the resource. */
+		size_t sizeInBytes {0};
+	};
+
+
+	/**
+	Finds a resource and marks it as used. This counts as a hit or a miss in the statistics.
+
+	\param	key The key.
+
+	\return The entry, or null if it's not in the cache.
+	**/
+	SEntry* Touch(const Key& key)
+	{
+		if (SEntry* pEntry = m_entries.Find(key))
+		{
+			++m_statistics.hitCount;
+			pEntry->lastTouchTime = gEnv->pTimer->GetFrameStartTime();
+
+			return pEntry;
+		}
+
+		++m_statistics.missCount;
+
+		return nullptr;
+	}
+
+
+	/** Finds a resource without marking it as used or counting it in the statistics. */
+	SEntry* Find(const Key& key) { return m_entries.Find(key); }
+	const SEntry* Find(const Key& key) const { return m_entries.Find(key); }
+
+
+	/**
+	Adds a resource which has just been loaded. If the key is already in the cache, the existing entry is kept.
+
+	\param	key			The key.
+	\param	pResource	The resource.
+	\param	sizeInBytes Bytes held by the resource.
+
+	\return The entry for the key.
+	**/
+	SEntry& Insert(const Key& key, Resource pResource, size_t sizeInBytes)
+	{
+		auto result = m_entries.insert(key, SEntry());
+		SEntry& entry = result.first->value;
+
+		if (result.second)
+		{
+			entry.pResource = std::move(pResource);
+			entry.sizeInBytes = sizeInBytes;
+			m_sizeInBytes += sizeInBytes;
+		}
+
+		entry.lastTouchTime = gEnv->pTimer->GetFrameStartTime();
+
+		return entry;
+	}
+
+
+	/**
+	Keeps a resource in the cache until it's unpinned. Pins are counted, so each needs a matching unpin.
+
+	\param	key The key.
+
+	\return True if the resource is in the cache and is now pinned.
+	**/
+	bool Pin(const Key& key)
+	{
+		if (SEntry* pEntry = m_entries.Find(key))
+		{
+			++pEntry->pinCount;
+			return true;
+		}
+
+		return false;
+	}
+
+
+	/** Removes a pin added by Pin. */
+	void Unpin(const Key& key)
+	{
+		if (SEntry* pEntry = m_entries.Find(key))
+		{
+			CRY_ASSERT_MESSAGE(pEntry->pinCount > 0, "Resource cache entry unpinned more times than it was pinned.");
+			if (pEntry->pinCount > 0)
+				--pEntry->pinCount;
+		}
+	}
+
+
+	/** Updates the size of a resource, for resources such as textures which grow and shrink as they stream. */
+	void Resize(SEntry& entry, size_t sizeInBytes)
+	{
+		m_sizeInBytes = m_sizeInBytes - entry.sizeInBytes + sizeInBytes;
+		entry.sizeInBytes = sizeInBytes;
+	}
+
+
+	/**
+	Lets go of the least recently used entries which aren't in use, until the cache is back within budget. Only the bytes
+	of the entries let go of are taken off the size, so it stays a count of what the cache is keeping loaded.
+
+	\param	isHeldElsewhere Returns true if anything besides the cache holds a reference to the resource. Those entries are
+							kept, as their resource would stay loaded anyway.
+	**/
+	template<typename IsHeldElsewhere>
+	void Trim(IsHeldElsewhere isHeldElsewhere)
+	{
+		if ((m_budget == 0) || (m_sizeInBytes <= m_budget))
+			return;
+
+		m_evictionCandidates.clear();
+		for (const auto& entry : m_entries)
+		{
+			if ((entry.value.pinCount == 0) && !isHeldElsewhere(entry.value.pResource))
+				m_evictionCandidates.push_back({entry.value.lastTouchTime, entry.key});
+		}
+
+		std::sort(m_evictionCandidates.begin(), m_evictionCandidates.end(), [](const SEvictionCandidate& lhs, const SEvictionCandidate& rhs)
+		{
+			return lhs.lastTouchTime < rhs.lastTouchTime;
+		});
+
+		for (const auto& candidate : m_evictionCandidates)
+		{
+			if (m_sizeInBytes <= m_budget)
+				break;
+
+			m_sizeInBytes -= m_entries.Find(candidate.key)->sizeInBytes;
+			m_entries.erase(candidate.key);
+			++m_statistics.evictionCount;
+		}
+	}
+
+
+	/** Lets go of every resource, pinned or not. */
+	void Clear()
+	{
+		m_entries.clear();
+		m_sizeInBytes = 0;
+	}
+
+
+	/** Calls a function with the key and entry of every resource in the cache. The function mustn't add or remove resources. */
+	template<typename Function>
+	void ForEach(Function function)
+	{
+		for (auto& entry : m_entries)
+			function(entry.key, entry.value);
+	}
+
+
+	/** Number of resources in the cache. */
+	size_t size() const { return m_entries.size(); }
+
+
+	/** Number of resources which are pinned. */
+	size_t GetPinnedCount() const
+	{
+		size_t pinnedCount {0};
+		for (const auto& entry : m_entries)
+		{
+			if (entry.value.pinCount > 0)
+				++pinnedCount;
+		}
+
+		return pinnedCount;
+	}
+
+
+	/** Bytes held by all the resources in the cache. */
+	size_t GetSizeInBytes() const { return m_sizeInBytes; }
+
+
+	/** Bytes the resources are allowed to hold before the least recently used are let go of. Zero means no limit. */
+	size_t GetBudget() const { return m_budget; }
+	void SetBudget(size_t budget) { m_budget = budget; }
+
+
+	const SResourceCacheStatistics& GetStatistics() const { return m_statistics; }
+
+
+	/** Adds the cache, and the bytes held by each resource in it. */
+	void GetMemoryUsage(ICrySizer* pSizer) const
+	{
+		m_entries.GetMemoryUsage(pSizer);
+		pSizer->AddContainer(m_evictionCandidates);
+
+		for (const auto& entry : m_entries)
+			pSizer->AddObject(entry.value.pResource.get(), entry.value.sizeInBytes);
+	}
+
+private:
+	struct SEvictionCandidate
+	{
+		CTimeValue lastTouchTime;
+		Key key;
+	};
+
+	TFlatHashMap<Key, SEntry, KeyHash> m_entries;
+
+	/** Kept between trims so we don't need to allocate one each time. */
+	std::vector<SEvictionCandidate> m_evictionCandidates;
+
+	/** Bytes held by all the resources in the cache. */
+	size_t m_sizeInBytes {0};
+
+	/** Bytes the resources are allowed to hold. Zero means no limit. */
+	size_t m_budget {0};
+
+	SResourceCacheStatistics m_statistics;
+};
+}
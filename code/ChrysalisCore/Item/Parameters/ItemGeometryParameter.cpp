@@ -39,6 +39,18 @@ bool CItemGeometryParameter::Read(const XmlNodeRef& node)
 	reader.ReadParamValue("useCgfStreaming", useCgfStreaming);
 	reader.ReadParamValue("useParentMaterial", useParentMaterial);
 
+	// Start the model and material loading in the background, rather than stalling while the items are read. The preload
+	// works out what each asset is from it's extension, and material names are often given without one.
+	std::vector<string> assetPaths;
+	if (!modelPath.empty())
+		assetPaths.push_back(modelPath);
+
+	if (!material.empty())
+		assetPaths.push_back(PathUtil::ReplaceExtension(material, "mtl"));
+
+	if (!assetPaths.empty())
+		CChrysalisCorePlugin::Get()->GetGameCache()->Preload(assetPaths);
+
 	return true;
 }
 }
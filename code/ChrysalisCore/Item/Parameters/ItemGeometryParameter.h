@@ -58,7 +58,8 @@ public:
 	virtual void OnResetState();
 
 	/**
-	Reads the given node.
+	Reads the given node. The model and material are preloaded into the game cache in the background, so they are
+	usually resident by the time the item's geometry is set up.
 
 	\param	node	The node to read.
 
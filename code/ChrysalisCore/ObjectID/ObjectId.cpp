@@ -2,6 +2,7 @@
 
 #include "ObjectId.h"
 #include <atomic>
+#include <thread>
 #include <CryCore/Assert/CryAssert.h>
 #include <time.h>
 #include <CryMath/Random.h>
@@ -9,68 +10,118 @@
 
 namespace Chrysalis
 {
+/** Hands out an identifier to each factory as it's constructed. */
+static std::atomic<uint32> nextFactoryId { 1 };
+
+/** Number of factories each thread can keep a reserved block for at once. */
+static const uint32 maxReservedFactories = 8;
+
+
+/** The blocks of Ids this thread has reserved, for each factory it has used recently. */
+struct SThreadReservation
+{
+	uint32 factoryId { 0 };
+	uint32 secondsSinceEpoch { 0 };
+	uint32 next { 0 };
+	uint32 end { 0 };
+};
+
+static thread_local SThreadReservation threadReservations [maxReservedFactories];
+
+
+/**
+The current time in seconds since epoch.
+
+We're rounding our time down to 32 bit, so this code here is susceptible to the Y2038 problem in 2038 when the value
+will roll over. It will still provide a 1 second window, but the dates derived from using this number will be nonsense.
+Still, it will take 70+ years before it starts to clash - so plenty of time to switch to 64 bit numbers or another
+method.
+*/
+static uint32 GetTimeNow()
+{
+	return static_cast<uint32> (time(nullptr));
+}
+
+
 CObjectIdFactory::CObjectIdFactory(uint32 instanceId)
 	: m_instanceId(instanceId),
-	m_randomVariant(0),
-	m_secondsSinceEpoch(0)
+	m_randomVariantSalt(cry_random_uint32()),
+	m_factoryId(nextFactoryId++)
 {}
 
 
-ObjectId CObjectIdFactory::CreateObjectId()
+CObjectIdFactory::SReservedBlock CObjectIdFactory::ReserveBlock(uint32 count)
 {
-	// Validation during testing / debug. For speed reasons we will not validate
-	// input in a release build. This decision might be wise to reconsider if you need the validation.
-	CRY_ASSERT(m_instanceId < MaxInstanceId);
-	CRY_ASSERT(m_randomVariant < MaxRandomVariant);
-
-	ObjectId objectId = InvalidId;
+	const uint32 now = GetTimeNow();
+	const uint32 idsPerSecond = MaxRandomVariant + 1;
 
-	std::atomic<bool> spinLock { false };
+	uint64 reserved = m_reserved.load(std::memory_order_relaxed);
+	for (;;)
 	{
-		// Spin on this until we can get a lock.
-		while (spinLock.exchange(true)) {}
+		uint32 secondsSinceEpoch = static_cast<uint32> (reserved >> 32);
+		uint32 used = static_cast<uint32> (reserved);
 
-		// We're rounding our time down to 32 bit, so this code here is susceptible to the Y2038 problem in 2038 when
-		// the value will roll over. It will still provide a 1 second window, but the dates derived from using this
-		// number will be nonsense. Still, it will take 70+ years before it starts to clash - so plenty of time to
-		// switch to 64 bit numbers or another method.
-		auto now = static_cast<int32> (time(nullptr));
-
-		if (m_secondsSinceEpoch == now)
+		// Catch up with the clock. If we're ahead of it from borrowing, or the clock went backwards, stay where we are
+		// so we can't hand out the same Id twice.
+		if (secondsSinceEpoch < now)
 		{
-			// Check for overflow on the variant.
-			m_randomVariant = (m_randomVariant + 1) & MaxRandomVariant;
-			if (m_lastRandomVariantSeed == m_randomVariant)
-			{
-				// #TODO: Don't let this assert happen for the dedicated server, since no-one will be
-				// there to notice.
-				CryLogAlways("Too many ObjectIds requested at once. See docs for limitations on ObjectId generation.");
-				CRY_ASSERT_MESSAGE(false, "Too many ObjectIds requested at once. See docs for limitations on ObjectId generation.");
-				return InvalidId;
-			}
+			secondsSinceEpoch = now;
+			used = 0;
 		}
-		else
-		{
-			// Bring the seconds up to date.
-			m_secondsSinceEpoch = now;
 
-			// We generate a new random seed to make keys harder to guess. It's fairly weak but better
-			// than nothing at all.
-			m_lastRandomVariantSeed = m_randomVariant = cry_random_uint32() & MaxRandomVariant;
+		// Out of Ids for this second, so borrow the next one instead of failing.
+		if (used >= idsPerSecond)
+		{
+			++secondsSinceEpoch;
+			used = 0;
 		}
 
-		// Pack the values tightly into our data member. We're using the max values as a way to mask the raw
-		// data value packed in. This is a cheap operation to perform and should help prevent dirty data
-		// slipping in.
-		objectId = (static_cast<uint64_t>(m_secondsSinceEpoch) << (InstanceIdBits + RandomVariantBits))
-			+ (static_cast<uint64_t>((m_instanceId & MaxInstanceId)) << RandomVariantBits)
-			+ (m_randomVariant & MaxRandomVariant);
+		const uint32 reserveCount = std::min(count, idsPerSecond - used);
+		const uint64 next = (static_cast<uint64> (secondsSinceEpoch) << 32) | (used + reserveCount);
+		if (m_reserved.compare_exchange_weak(reserved, next, std::memory_order_relaxed))
+			return { secondsSinceEpoch, used, reserveCount };
+	}
+}
+
 
-		// Unlock!
-		spinLock = false;
+ObjectId CObjectIdFactory::MakeObjectId(uint32 secondsSinceEpoch, uint32 index) const
+{
+	// We generate a new random starting point each second to make keys harder to guess. It's fairly weak but better
+	// than nothing at all. It's worked out from the seconds, so every thread agrees on it without sharing anything.
+	uint32 seed = (secondsSinceEpoch ^ m_randomVariantSalt) * 0x9E3779B1u;
+	seed ^= seed >> 16;
+	const uint32 randomVariant = (seed + index) & MaxRandomVariant;
+
+	// Pack the values tightly into our data member. We're using the max values as a way to mask the raw
+	// data value packed in. This is a cheap operation to perform and should help prevent dirty data
+	// slipping in.
+	return (static_cast<uint64_t>(secondsSinceEpoch) << (InstanceIdBits + RandomVariantBits))
+		+ (static_cast<uint64_t>((m_instanceId & MaxInstanceId)) << RandomVariantBits)
+		+ randomVariant;
+}
+
+
+ObjectId CObjectIdFactory::CreateObjectId()
+{
+	// Validation during testing / debug. For speed reasons we will not validate
+	// input in a release build. This decision might be wise to reconsider if you need the validation.
+	CRY_ASSERT(m_instanceId < MaxInstanceId);
+
+	// Each factory has a slot in the thread's reservations. Another factory using the same slot just takes it over.
+	auto& reservation = threadReservations [m_factoryId % maxReservedFactories];
+
+	// Only use a reserved block during the second it was reserved in, or while we're borrowing ahead of the clock.
+	if ((reservation.factoryId != m_factoryId) || (reservation.next == reservation.end)
+		|| (reservation.secondsSinceEpoch < GetTimeNow()))
+	{
+		const SReservedBlock block = ReserveBlock(ReservedBlockSize);
+		reservation.factoryId = m_factoryId;
+		reservation.secondsSinceEpoch = block.secondsSinceEpoch;
+		reservation.next = block.first;
+		reservation.end = block.first + block.count;
 	}
 
-	return objectId;
+	return MakeObjectId(reservation.secondsSinceEpoch, reservation.next++);
 }
 
 
@@ -90,4 +141,55 @@ uint32 CObjectIdFactory::GetRandomVariant(ObjectId objectId)
 {
 	return objectId & MaxRandomVariant;
 }
+
+
+void CObjectIdFactory::LogBenchmark(uint32 threadCount, uint32 idsPerThread)
+{
+	std::vector<ObjectId> objectIds(threadCount * idsPerThread);
+
+	// Each run gets a fresh factory, with an instance Id no real instance will use.
+	auto run = [&objectIds, threadCount, idsPerThread](bool useBlocks)
+	{
+		CObjectIdFactory factory(MaxInstanceId - 1);
+		std::vector<std::thread> threads;
+
+		const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+		for (uint32 thread = 0; thread < threadCount; ++thread)
+		{
+			threads.emplace_back([&factory, &objectIds, thread, idsPerThread, useBlocks]()
+			{
+				ObjectId* pObjectIds = objectIds.data() + thread * idsPerThread;
+				for (uint32 i = 0; i < idsPerThread; ++i)
+				{
+					if (useBlocks)
+					{
+						pObjectIds [i] = factory.CreateObjectId();
+					}
+					else
+					{
+						// Every Id goes through the shared state.
+						const SReservedBlock block = factory.ReserveBlock(1);
+						pObjectIds [i] = factory.MakeObjectId(block.secondsSinceEpoch, block.first);
+					}
+				}
+			});
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+
+		const float milliseconds = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		// Every Id should be unique.
+		std::sort(objectIds.begin(), objectIds.end());
+		const bool isUnique = std::adjacent_find(objectIds.begin(), objectIds.end()) == objectIds.end();
+
+		CryLogAlways("ObjectId benchmark, %u threads, %u Ids each, %s: %.3fms, %.0f Ids per second, %s",
+			threadCount, idsPerThread, useBlocks ? "reserved blocks" : "shared only", milliseconds,
+			milliseconds > 0.0f ? objectIds.size() * 1000.0f / milliseconds : 0.0f, isUnique ? "all unique" : "DUPLICATES FOUND");
+	};
+
+	run(false);
+	run(true);
+}
 }
\ No newline at end of file
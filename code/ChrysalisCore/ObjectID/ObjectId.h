@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 
 namespace Chrysalis
 {
@@ -16,8 +18,9 @@ the bits, use the accessors provided instead.
 32-49	:	An instance ID that is unique for every running instance of this code. These need to be unique
 and should be carefully assigned on a as-needed basis.
 50-63	:	A random component. Each second a new starting point is generated, and it increments with each
-Id generated during that second. This forces a hard limit on the number of Ids that can be generated
-in a single second. Currently this limit is 16,384. /
+Id generated during that second. This limits the number of Ids that can be generated in a single second
+to 16,384. Once they run out, the factory moves on to the next second early, so the seconds in an Id can
+run a little ahead of the clock during a burst.
 */
 
 typedef uint64_t ObjectId;
@@ -26,8 +29,12 @@ typedef uint64_t ObjectId;
 /** A factory class needed to properly construct valid ObjectIds. The class is dependant on
 having a valid instanceId prior to instantiation.
 
+Ids can be created from any thread. Each thread reserves a block of Ids from the factory at a time, and hands them
+out without touching any shared state until the block is used up. Reserving a block is lock-free. Unused Ids in a
+block are dropped when the second it was reserved in has passed, so Ids don't end up with old timestamps.
+
 It is recommended that you create an instance of this factory for every entity class where you think
-you will need to create more the hard limit of ObjectId's / second. Currently, this limit is 16,384.
+you will need to create more than 16,384 ObjectId's / second, to keep the seconds in the Ids close to the clock.
 */
 class CObjectIdFactory
 {
@@ -50,6 +57,9 @@ public:
 	/** Magic number to signify an invalid ID. */
 	static const ObjectId InvalidId = 0;
 
+	/** The number of Ids each thread reserves from the factory at a time. */
+	static const uint32 ReservedBlockSize = 64;
+
 
 	/**
 	Constructor.
@@ -58,12 +68,15 @@ public:
 	*/
 	CObjectIdFactory(uint32 instanceId);
 
+	CObjectIdFactory(const CObjectIdFactory&) = delete;
+	CObjectIdFactory& operator=(const CObjectIdFactory&) = delete;
+
 
 	/**
 	Makes a request to the factory to create a new valid ObjectId.
 
 	Only the factory should be allowed to construct these, since it has all the information needed to ensure the key is
-	generated correctly.
+	generated correctly. This is safe to call from any thread.
 
 	\return	The new object identifier.
 	*/
@@ -93,11 +106,56 @@ public:
 	*/
 	uint32 GetRandomVariant(ObjectId objectId);
 
+
+	/**
+	Times creating Ids from a number of threads at once, both with and without each thread reserving blocks of them,
+	checks they were all unique, and writes the results to the log.
+
+	\param	threadCount	  Number of threads.
+	\param	idsPerThread Number of Ids each thread creates.
+	*/
+	static void LogBenchmark(uint32 threadCount, uint32 idsPerThread);
+
 private:
+	/** A run of Ids reserved from the factory. */
+	struct SReservedBlock
+	{
+		uint32 secondsSinceEpoch { 0 };
+		uint32 first { 0 };
+		uint32 count { 0 };
+	};
+
+
+	/**
+	Reserves a run of Ids from the shared state.
+
+	\param	count	The most Ids wanted. Fewer are reserved if there aren't enough left in the current second.
+
+	\return	The reserved block.
+	*/
+	SReservedBlock ReserveBlock(uint32 count);
+
+
+	/**
+	Packs an Id together.
+
+	\param	secondsSinceEpoch	The seconds since epoch.
+	\param	index				How many Ids were created before this one in that second.
+
+	\return	The object identifier.
+	*/
+	ObjectId MakeObjectId(uint32 secondsSinceEpoch, uint32 index) const;
+
 	uint32 m_instanceId;
-	uint32 m_randomVariant;
-	uint32 m_lastRandomVariantSeed;
-	int32 m_secondsSinceEpoch;
+
+	/** Makes the starting point for the random variant each second harder to guess. */
+	uint32 m_randomVariantSalt;
+
+	/** Identifies this factory in the per-thread reserved blocks, as the address may be reused by a later factory. */
+	uint32 m_factoryId;
+
+	/** The seconds since epoch in the upper 32 bits, and the number of Ids reserved during that second in the lower. */
+	std::atomic<uint64> m_reserved { 0 };
 
 	// DO NOT IMPLEMENT.
 	CObjectIdFactory();
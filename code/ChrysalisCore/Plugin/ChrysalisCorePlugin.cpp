@@ -8,8 +8,12 @@
 #include <CrySystem/ISystem.h>
 #include <IGameObjectSystem.h>
 #include <IGameObject.h>
+#include "Actor/ActorControllerManager.h"
 #include "Components/Player/PlayerComponent.h"
+#include "Components/Interaction/AwarenessSpatialIndex.h"
+#include "Components/Interaction/AwarenessScheduler.h"
 #include "Console/CVars.h"
+#include "DynamicResponseSystem/ConditionActorNamed.h"
 #include "DynamicResponseSystem/ConditionDistanceToEntity.h"
 #include "DynamicResponseSystem/ActionClose.h"
 #include "DynamicResponseSystem/ActionLock.h"
@@ -17,6 +21,7 @@
 #include "DynamicResponseSystem/ActionPlayAnimation.h"
 #include "DynamicResponseSystem/ActionSwitch.h"
 #include "DynamicResponseSystem/ActionUnlock.h"
+#include "Game/Cache/GameCache.h"
 #include "ObjectID/ObjectIdMasterFactory.h"
 #include "Schematyc/CoreEnv.h"
 #include "ECS/ECS.h"
@@ -31,6 +36,10 @@
 
 namespace Chrysalis
 {
+/** The game cache, for as long as the plugin which owns it is alive. */
+static CGameCache* pLiveGameCache {nullptr};
+
+
 CChrysalisCorePlugin::~CChrysalisCorePlugin()
 {
 	// Remove any registered listeners before 'this' becomes invalid
@@ -45,6 +54,12 @@ CChrysalisCorePlugin::~CChrysalisCorePlugin()
 
 	// Unregister all the cvars.
 	g_cvars.UnregisterVariables();
+
+	pLiveGameCache = nullptr;
+	SAFE_DELETE(m_pGameCache);
+
+	// The ray-cast queue inside needs to go while physics is still around.
+	SAFE_DELETE(m_pAwarenessSpatialIndex);
 }
 
 
@@ -60,6 +75,12 @@ bool CChrysalisCorePlugin::Initialize(SSystemGlobalEnvironment& env, const SSyst
 	// #TODO: Get the InstanceId from the command line or cvars.
 	m_pObjectIdMasterFactory = new CObjectIdMasterFactory(0);
 
+	m_pGameCache = new CGameCache();
+	m_pGameCache->Init();
+	pLiveGameCache = m_pGameCache;
+
+	m_pAwarenessSpatialIndex = new CAwarenessSpatialIndex();
+
 	return true;
 }
 
@@ -131,6 +152,7 @@ void CChrysalisCorePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UI
 			if (gEnv->pDynamicResponseSystem)
 			{
 				// Register the custom DRS actions and conditions.
+				REGISTER_DRS_CUSTOM_CONDITION(CConditionActorNamed);
 				REGISTER_DRS_CUSTOM_CONDITION(CConditionDistanceToEntity);
 				REGISTER_DRS_CUSTOM_ACTION(CActionClose);
 				REGISTER_DRS_CUSTOM_ACTION(CActionLock);
@@ -160,6 +182,19 @@ void CChrysalisCorePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UI
 					pPlayer->NetworkClientConnect();
 			}
 			break;
+
+		case ESYSTEM_EVENT_LEVEL_PRECACHE_START:
+			// Get the characters and animation the level will need resident before anything asks for them.
+			m_pGameCache->WarmUpLevel();
+			break;
+
+		case ESYSTEM_EVENT_LEVEL_POST_UNLOAD:
+			// Nothing cached for the last level should keep it's resources alive.
+			m_pGameCache->Reset();
+
+			// The entities in the index went with the level.
+			m_pAwarenessSpatialIndex->Clear();
+			break;
 	}
 }
 
@@ -247,6 +282,20 @@ void CChrysalisCorePlugin::OnClientDisconnected(int channelId, EDisconnectionCau
 void CChrysalisCorePlugin::OnPostUpdate(float deltaTime)
 {
 	ECS::ecsSimulation.Update(deltaTime);
+
+	// Step the movement of every actor in one pass, rather than each of them handling their own update event. The entity
+	// system doesn't update entities while editing or paused, so neither do we.
+	const bool isEditing = gEnv->IsEditor() && !gEnv->IsEditorGameMode();
+	if (!isEditing && !gEnv->pGameFramework->IsGamePaused())
+		CActorControllerManager::Get().Update(deltaTime);
+
+	// The entities have all updated. The awareness components due this frame can now submit their queries and rays, which
+	// are then answered in one batch.
+	CAwarenessScheduler::Get().Update();
+	CAwarenessSpatialIndex::Get().Update(deltaTime);
+
+	// Issue more of any preloads, and report those which have finished.
+	m_pGameCache->Update();
 }
 
 
@@ -262,5 +311,11 @@ CChrysalisCorePlugin* CChrysalisCorePlugin::Get()
 	return plugIn;
 }
 
+
+CGameCache* CChrysalisCorePlugin::GetLiveGameCache()
+{
+	return pLiveGameCache;
+}
+
 CRYREGISTER_SINGLETON_CLASS(CChrysalisCorePlugin)
 }
\ No newline at end of file
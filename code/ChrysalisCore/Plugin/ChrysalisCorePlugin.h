@@ -10,6 +10,8 @@
 namespace Chrysalis
 {
 class CObjectIdMasterFactory;
+class CGameCache;
+class CAwarenessSpatialIndex;
 
 
 /**
@@ -79,6 +81,17 @@ public:
 
 	CObjectIdMasterFactory* GetObjectId() { return m_pObjectIdMasterFactory; }
 
+	CGameCache* GetGameCache() { return m_pGameCache; }
+
+
+	/**
+	Gets the game cache without going through Get, which isn't safe once the plugin has been destroyed. Anything which
+	can be destroyed during shutdown, such as components, should use this to hand back what it took from the cache.
+
+	\return The game cache, or null if the plugin hasn't been initialised or has already been destroyed.
+	**/
+	static CGameCache* GetLiveGameCache();
+
 protected:
 	// Map containing player components, key is the channel id received in OnClientConnectionReceived
 	std::unordered_map<int, EntityId> m_players;
@@ -87,5 +100,11 @@ protected:
 private:
 	/** The object identifier master factory. */
 	CObjectIdMasterFactory* m_pObjectIdMasterFactory {nullptr};
+
+	/** Keeps frequently used assets loaded, and preloads assets in the background. */
+	CGameCache* m_pGameCache {nullptr};
+
+	/** Where the awareness components look for entities and queue their ray-casts. */
+	CAwarenessSpatialIndex* m_pAwarenessSpatialIndex {nullptr};
 };
 }
\ No newline at end of file
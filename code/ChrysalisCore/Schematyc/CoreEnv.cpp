@@ -15,6 +15,7 @@ void RegisterCoreEnvPackage(IEnvRegistrar& registrar)
 	{
 		CEnvRegistrationScope scope = registrar.Scope(g_chrysalisModuleGUID);
 		scope.Register(SCHEMATYC_MAKE_ENV_MODULE(g_generalModuleGUID, "General"));
+		scope.Register(SCHEMATYC_MAKE_ENV_MODULE(g_simulationModuleGUID, "Simulation"));
 	}
 }
 }
@@ -0,0 +1,55 @@
+#include "StdAfx.h"
+
+#include <CryCore/StaticInstanceList.h>
+#include <CrySchematyc/CoreAPI.h>
+#include <CrySchematyc/Utils/SharedString.h>
+#include <Schematyc/CoreEnv.h>
+#include "ECS/ECS.h"
+
+
+namespace Chrysalis
+{
+namespace Simulation
+{
+using namespace ::Schematyc;
+
+bool HasActorNamed(const CSharedString& name)
+{
+	return ECS::ecsSimulation.GetActorByName(entt::hashed_string {name.c_str()}) != entt::null;
+}
+
+
+bool HasSpellNamed(const CSharedString& name)
+{
+	return ECS::ecsSimulation.GetSpellByName(entt::hashed_string {name.c_str()}) != entt::null;
+}
+
+
+static void RegisterFunctions(IEnvRegistrar& registrar)
+{
+	CEnvRegistrationScope scope = registrar.Scope(g_simulationModuleGUID);
+	{
+		auto pFunction = SCHEMATYC_MAKE_ENV_FUNCTION(&HasActorNamed, "{ED24C205-DB12-456A-A39E-B161159B27DF}"_cry_guid, "HasActorNamed");
+		pFunction->SetDescription("Is there an actor in the simulation with this name");
+		pFunction->BindOutput(0, 'fnd', "Found");
+		pFunction->BindInput(1, 'name', "Name");
+		scope.Register(pFunction);
+	}
+	{
+		auto pFunction = SCHEMATYC_MAKE_ENV_FUNCTION(&HasSpellNamed, "{A3103C6E-AD52-4A4B-9C19-748F264DFC8E}"_cry_guid, "HasSpellNamed");
+		pFunction->SetDescription("Is there a spell in the simulation with this name");
+		pFunction->BindOutput(0, 'fnd', "Found");
+		pFunction->BindInput(1, 'name', "Name");
+		scope.Register(pFunction);
+	}
+}
+} // Simulation
+
+
+static void RegisterSimulationFunctions(::Schematyc::IEnvRegistrar& registrar)
+{
+	Simulation::RegisterFunctions(registrar);
+}
+} // Chrysalis
+
+CRY_STATIC_AUTO_REGISTER_FUNCTION(&Chrysalis::RegisterSimulationFunctions)
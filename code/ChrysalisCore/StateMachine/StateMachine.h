@@ -1,6 +1,7 @@
 #pragma once
 
-#include <queue>
+#include <atomic>
+#include <new>
 #include <CryCore/CryFlags.h>
 #include <CryCore/Containers/CryFixedArray.h>
 #include <CryRenderer/IRenderAuxGeom.h>
@@ -94,17 +95,9 @@ public:
 	}
 #endif
 
-	SStateEvent(const SStateEvent& rhs)
-		: m_eventType(rhs.m_eventType)
-#ifdef STATE_DEBUG
-		, m_debugContextAt(rhs.m_debugContextAt)
-#endif
-	{
-		for (unsigned int i = 0; i < rhs.GetDataSize(); ++i)
-		{
-			AddData(rhs.GetData(i));
-		}
-	}
+	// The default copy takes the data array in one go, rather than pushing each entry back in turn.
+	SStateEvent(const SStateEvent& rhs) = default;
+	SStateEvent& operator=(const SStateEvent& rhs) = default;
 
 	void AddData(const SStateEventData& data) { m_data.push_back(data); }
 	const SStateEventData& GetData(uint8 index) const { return m_data[index]; }
@@ -153,65 +146,132 @@ struct SStateEventSerialize : public SStateEvent
 	}
 };
 
-#ifdef STATE_DEBUG
+//////////////////////////////////////////////////////////////////////////
+// StateTrace
 
-#include <CryRenderer/IRenderer.h>
-static const float state_white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
-static const float state_red[4] = {1.0f, 0.0f, 0.0f, 1.0f};
-static const float state_green[4] = {0.0f, 1.0f, 0.0f, 1.0f};
-static const float state_blue[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+/**
+One step taken by a state machine: an event arriving at the machine, or a sub state being initialised, entered,
+exited or released. Only ids are stored. They are turned into names when the trace is displayed or dumped.
+**/
+struct SStateTraceRecord
+{
+	/** Frame start time, in CTimeValue ticks. */
+	int64 frameTime;
 
-struct SHistory
+	/** Counts up for each record the machine makes, so records from the same frame can be told apart. */
+	uint32 sequence;
+
+	uint32 ownerId;
+	int16 hierarchyID;
+	uint8 subStateIndex;
+	uint8 reserved;
+	int32 eventID;
+};
+
+
+/**
+The most recent steps taken by a state machine, in a fixed ring of binary records. Only the thread running the machine
+writes to it, so recording is a few stores and a release of the write count with no locks or formatting. Readers can
+copy the records out from any thread; records overwritten while they were being copied are dropped.
+
+Records are only kept in builds with STATE_DEBUG. In other builds recording does nothing.
+**/
+class CStateTrace
 {
-	typedef string TDebugType;
-	typedef CryFixedArray<TDebugType, 40> TStateHistory;
+public:
+	enum { CAPACITY = 256 };
 
-	SHistory()
+	CStateTrace()
+#ifdef STATE_DEBUG
+		: m_writeCount(0)
+		, m_ownerId(0)
+#endif
 	{
-		Reset();
 	}
 
-	void Reset()
+
+	/** The id written into each record, usually the entity running the machine. */
+	void SetOwnerId(uint32 ownerId)
 	{
-		m_states.clear();
+#ifdef STATE_DEBUG
+		m_ownerId = ownerId;
+#endif
+	}
 
-		while (m_states.size() < m_states.max_size())
-		{
-			m_states.push_back(string("null"));
-		}
 
-		m_front = 0;
-		m_historyID = 0;
+	ILINE void Record(int hierarchyID, uint subStateIndex, int eventID)
+	{
+#ifdef STATE_DEBUG
+		const uint32 sequence = m_writeCount.load(std::memory_order_relaxed);
+
+		SStateTraceRecord& record = m_records[sequence & (CAPACITY - 1)];
+		record.frameTime = gEnv->pTimer->GetFrameStartTime().GetValue();
+		record.sequence = sequence;
+		record.ownerId = m_ownerId;
+		record.hierarchyID = static_cast<int16>(hierarchyID);
+		record.subStateIndex = static_cast<uint8>(subStateIndex);
+		record.reserved = 0;
+		record.eventID = eventID;
+
+		m_writeCount.store(sequence + 1, std::memory_order_release);
+#endif
 	}
 
-	void AddToHistory(const char* subState, ...)
+
+	/**
+	Copies out the most recent records, oldest first.
+
+	\param [out] pRecords Room for at least maxCount records.
+	\param	maxCount The most records to copy.
+
+	\return The number of records copied.
+	**/
+	uint CopyRecords(SStateTraceRecord* pRecords, uint maxCount) const
 	{
-		CRY_ASSERT((UINT_PTR)subState != 0xcdcdcdcd);
+#ifdef STATE_DEBUG
+		const uint32 writeCount = m_writeCount.load(std::memory_order_acquire);
+		const uint32 count = std::min(std::min(writeCount, uint32(CAPACITY)), uint32(maxCount));
+		const uint32 first = writeCount - count;
 
-		char tmp[128];
-		va_list args;
-		va_start(args, subState);
-		cry_vsprintf(tmp, subState, args);
-		va_end(args);
+		for (uint32 i = 0; i < count; ++i)
+		{
+			pRecords[i] = m_records[(first + i) & (CAPACITY - 1)];
+		}
 
-		CryFixedStringT<256> finalStr;
-		finalStr.Format("%x %s", m_historyID++, tmp);
+		// Anything the writer has lapped while we were copying can't be trusted. The writer may also be part way through
+		// the record after laterWriteCount, so the slot it's filling counts as overwritten too. The fence keeps our copies
+		// from being read after the count.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint32 laterWriteCount = m_writeCount.load(std::memory_order_relaxed);
+		const uint32 writtenOrWriting = laterWriteCount + 1;
+		const uint32 overwritten = (writtenOrWriting - first > CAPACITY) ? std::min(writtenOrWriting - first - CAPACITY, count) : 0;
+		if (overwritten > 0)
+		{
+			std::copy(pRecords + overwritten, pRecords + count, pRecords);
+		}
 
-		m_states[m_front] = finalStr.c_str();
-		m_front = (m_front < (int)(m_states.max_size() - 1)) ? m_front + 1 : 0;
+		return count - overwritten;
+#else
+		return 0;
+#endif
 	}
 
-	ILINE int GetFront() const { return m_front - 1; }
-	ILINE int GetBack() const { return (int)(m_states.size() - 1); }
-	ILINE const TDebugType& GetStateAt(int index) const { return m_states[index]; }
-
+#ifdef STATE_DEBUG
 private:
-
-	TStateHistory		m_states;
-	int		m_front;
-	int   m_historyID;
+	SStateTraceRecord m_records[CAPACITY];
+	std::atomic<uint32> m_writeCount;
+	uint32 m_ownerId;
+#endif
 };
 
+#ifdef STATE_DEBUG
+
+#include <CryRenderer/IRenderer.h>
+static const float state_white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+static const float state_red[4] = {1.0f, 0.0f, 0.0f, 1.0f};
+static const float state_green[4] = {0.0f, 1.0f, 0.0f, 1.0f};
+static const float state_blue[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+
 struct SStateDebugContext
 {
 	SStateDebugContext(IRenderer* renderer, IRenderAuxGeom* renderAuxGeom)
@@ -229,7 +289,7 @@ struct SStateDebugContext
 	mutable float  m_currentVertical;
 
 	template<typename HOST>
-	static const SStateEvent StateDebugAndLog(CStateHierarchy<HOST>* pState, const char* stateName, SStateEvent stateEvent);
+	static const SStateEvent StateDebugAndLog(CStateHierarchy<HOST>* pState, uint subStateIndex, SStateEvent stateEvent);
 };
 
 #define DebugInit( pDebugName ) { m_pDebugName = pDebugName; }
@@ -249,24 +309,19 @@ struct SStateDebugContext
 			const SStateDebugContext& stateDebugCtx = *static_cast<const SStateDebugContext*>(debugEvent.GetData(debugEvent.m_debugContextAt).GetPtr()); \
 			IRenderAuxText::Draw2dLabel(stateDebugCtx.m_baseHorizontal, stateDebugCtx.m_currentVertical, 1.5f, colour, false, n, __VA_ARGS__ ); \
 			stateDebugCtx.m_currentVertical += 15.f; \
-			if( logit )	state->m_historyDebug.AddToHistory( n, __VA_ARGS__ ); \
-		}\
-
-#define STATE_DEBUG_EVENT_LOG_TO_HISTORY( state, colour, n, ... ) \
-		{\
-			state->m_historyDebug.AddToHistory( n, __VA_ARGS__ ); \
+			if( logit && state->m_pTrace ) state->m_pTrace->Record( state->m_stateID, state->m_currentState.m_subStateIndex, debugEvent.GetEventId() ); \
 		}\
 
 template<typename HOST>
-const SStateEvent STATE_DEBUG_RAW_EVENT_LOG(CStateHierarchy<HOST>* pState, const char* stateName, SStateEvent stateEvent)
+const SStateEvent STATE_DEBUG_RAW_EVENT_LOG(CStateHierarchy<HOST>* pState, uint subStateIndex, SStateEvent stateEvent)
 {
-	return SStateDebugContext::StateDebugAndLog(pState, stateName, stateEvent);
+	return SStateDebugContext::StateDebugAndLog(pState, subStateIndex, stateEvent);
 }
 
 template<typename HOST>
 const SStateEvent STATE_DEBUG_RAW_EVENT_LOG(CStateHierarchy<HOST>* pState, SStateEvent stateEvent)
 {
-	return SStateDebugContext::StateDebugAndLog(pState, pState->m_currentState.m_pDebugName, stateEvent);
+	return SStateDebugContext::StateDebugAndLog(pState, pState->m_currentState.m_subStateIndex, stateEvent);
 }
 
 #define STATE_DEBUG_RAW_EVENT( state )\
@@ -281,7 +336,6 @@ const SStateEvent STATE_DEBUG_RAW_EVENT_LOG(CStateHierarchy<HOST>* pState, SStat
 #define DebugInit( n )
 #define STATE_DEBUG_LOG( n,m, ... )
 #define STATE_DEBUG_EVENT_LOG( state, debugEvent, logit, colour, n, ... )
-#define STATE_DEBUG_EVENT_LOG_TO_HISTORY( state, colour, n, ... )
 #define STATE_DEBUG_APPEND_EVENT( e ) e
 #define STATE_DEBUG_EVENTONLY( name, e ) e
 
@@ -323,6 +377,9 @@ class CStateHierarchy;
 template<typename HOST>
 class CStateMachineRegistration;
 
+template<typename HOST>
+class CStateDispatchTable;
+
 #define CALL_SUBSTATE_FN(object, subStateIndex) ((*object).*(subStateIndex.m_func))
 #define CALL_SUBSTATE_PARENT_FN(object, subStateIndex)  ((*object).*(subStateIndex.m_parent->m_func))
 
@@ -338,6 +395,23 @@ public:
 	typedef void(*DeleteStatePtr)(CStateHierarchy<HOST>*&);
 };
 
+/** Counts how state hierarchies have been made and where their memory came from. */
+struct SStatePoolStatistics
+{
+	/** Blocks taken from the heap. Once the pools have warmed up this should stop rising. */
+	uint32 heapAllocationCount {0};
+
+	/** Hierarchies constructed into a block which was already in a pool. */
+	uint32 reuseCount {0};
+
+	/** Hierarchies which are currently constructed. */
+	uint32 liveCount {0};
+
+	/** Blocks sitting in the pools waiting to be reused. */
+	uint32 pooledCount {0};
+};
+
+
 template< typename HOST >
 class CStateMachineRegistration
 {
@@ -348,7 +422,7 @@ class CStateMachineRegistration
 		typename CStateProxy<HOST>::CreateStatePtr m_createPtr;
 		typename CStateProxy<HOST>::DeleteStatePtr m_deletePtr;
 
-		SStateFactory() {}
+		SStateFactory() : m_createPtr(nullptr), m_deletePtr(nullptr) {}
 		SStateFactory(typename CStateProxy<HOST>::CreateStatePtr createPtr, typename CStateProxy<HOST>::DeleteStatePtr deletePtr) :
 			m_createPtr(createPtr), m_deletePtr(deletePtr) {}
 	};
@@ -356,8 +430,46 @@ class CStateMachineRegistration
 	typedef std::vector<SStateFactory> TStateFactory;
 	TStateFactory m_factories;
 
+	/** A released block. The link is written over the memory the hierarchy used to live in. */
+	struct SFreeBlock
+	{
+		SFreeBlock* m_pNext;
+	};
+
+	/**
+	Every hierarchy of a given state ID is the same class, so each state ID keeps it's own list of blocks of exactly
+	the right size. The pools are shared by every host using this registration and are only touched from the main
+	thread.
+	**/
+	struct SStatePool
+	{
+		SStatePool() : m_pFreeBlocks(nullptr), m_blockSize(0) {}
+
+		SFreeBlock* m_pFreeBlocks;
+		size_t m_blockSize;
+	};
+
+	typedef std::vector<SStatePool> TStatePools;
+	TStatePools m_pools;
+
+	// Filled in as each hierarchy class is first constructed.
+	typedef std::vector<const CStateDispatchTable<HOST>*> TDispatchTables;
+	TDispatchTables m_dispatchTables;
+
+	SStatePoolStatistics m_poolStatistics;
+
 public:
 
+	CStateMachineRegistration() {}
+
+
+	~CStateMachineRegistration()
+	{
+		CRY_ASSERT_MESSAGE(m_poolStatistics.liveCount == 0, "HSM: State hierarchies are still alive as their registration is destroyed.");
+		FreePooledBlocks();
+	}
+
+
 	void RegisterState(typename CStateProxy<HOST>::CreateStatePtr createPtr, typename CStateProxy<HOST>::DeleteStatePtr deletePtr, const uint stateID)
 	{
 		const uint trueStateID = stateID - STATE_FIRST;
@@ -367,6 +479,26 @@ public:
 			m_factories.resize(trueStateID + 1);
 		}
 		m_factories[trueStateID] = SStateFactory(createPtr, deletePtr);
+
+		if ((trueStateID + 1) > m_pools.size())
+		{
+			m_pools.resize(trueStateID + 1);
+			m_dispatchTables.resize(trueStateID + 1, nullptr);
+		}
+	}
+
+
+	void SetDispatchTable(const uint stateID, const CStateDispatchTable<HOST>* pDispatchTable)
+	{
+		m_dispatchTables[stateID - STATE_FIRST] = pDispatchTable;
+	}
+
+
+	/** The dispatch table for a hierarchy, or null if the hierarchy has never been constructed. */
+	const CStateDispatchTable<HOST>* GetDispatchTable(const int stateID) const
+	{
+		const uint trueStateID = stateID - STATE_FIRST;
+		return (trueStateID < m_dispatchTables.size()) ? m_dispatchTables[trueStateID] : nullptr;
 	}
 
 	void UnRegisterState(const uint stateID)
@@ -389,9 +521,122 @@ public:
 		const uint trueStateID = pState->GetStateID() - STATE_FIRST;
 		if (trueStateID < m_factories.size())
 		{
+			// The delete function only destructs, so the block has to be found before it runs.
+			void* pBlock = dynamic_cast<void*>(pState);
 			CALL_STATE_DELETE_FN(trueStateID)(pState);
+			ReleaseStateMemory(trueStateID + STATE_FIRST, pBlock);
 		}
 	}
+
+
+	/**
+	Provides the memory for a state hierarchy to be constructed into. A block released by an earlier hierarchy of the
+	same state ID is reused when there is one, so once the pools have warmed up a transition never touches the heap.
+
+	\param	stateID The state ID of the hierarchy.
+	\param	size    The size of the hierarchy class.
+
+	\return The memory for the hierarchy.
+	**/
+	void* AllocateStateMemory(const uint stateID, const size_t size)
+	{
+		SStatePool& pool = m_pools[stateID - STATE_FIRST];
+		CRY_ASSERT_MESSAGE((pool.m_blockSize == 0) || (pool.m_blockSize == size), "HSM: A state ID is being used by state classes of different sizes.");
+		pool.m_blockSize = size;
+
+		++m_poolStatistics.liveCount;
+
+		if (SFreeBlock* pBlock = pool.m_pFreeBlocks)
+		{
+			pool.m_pFreeBlocks = pBlock->m_pNext;
+			--m_poolStatistics.pooledCount;
+			++m_poolStatistics.reuseCount;
+
+			return pBlock;
+		}
+
+		++m_poolStatistics.heapAllocationCount;
+
+		return CryModuleMalloc(std::max(size, sizeof(SFreeBlock)));
+	}
+
+
+	/** Returns the memory of a destructed state hierarchy to the pool for it's state ID. */
+	void ReleaseStateMemory(const uint stateID, void* pMemory)
+	{
+		SStatePool& pool = m_pools[stateID - STATE_FIRST];
+		SFreeBlock* pBlock = static_cast<SFreeBlock*>(pMemory);
+		pBlock->m_pNext = pool.m_pFreeBlocks;
+		pool.m_pFreeBlocks = pBlock;
+
+		--m_poolStatistics.liveCount;
+		++m_poolStatistics.pooledCount;
+	}
+
+
+	/**
+	Fills the pool for a state ID so the first transitions into it don't need to allocate either. Useful before a
+	crowd of actors is spawned.
+
+	\param	stateID The state ID of the hierarchy.
+	\param	count   The number of blocks the pool should hold.
+	**/
+	void ReservePool(const uint stateID, const uint count)
+	{
+		const uint trueStateID = stateID - STATE_FIRST;
+		if ((trueStateID < m_factories.size()) && m_factories[trueStateID].m_createPtr)
+		{
+			SStatePool& pool = m_pools[trueStateID];
+			if (pool.m_blockSize == 0)
+			{
+				// Make one to learn the block size.
+				CStateHierarchy<HOST>* pState = CreateState(stateID);
+				DeleteState(pState);
+			}
+
+			uint pooledCount = 0;
+			for (SFreeBlock* pBlock = pool.m_pFreeBlocks; pBlock; pBlock = pBlock->m_pNext)
+				++pooledCount;
+
+			for (; pooledCount < count; ++pooledCount)
+			{
+				ReleaseStateMemory(stateID, CryModuleMalloc(std::max(pool.m_blockSize, sizeof(SFreeBlock))));
+				++m_poolStatistics.heapAllocationCount;
+				++m_poolStatistics.liveCount;
+			}
+		}
+	}
+
+
+	/** Frees every block sitting in the pools. Blocks of live hierarchies are not affected. */
+	void FreePooledBlocks()
+	{
+		for (SStatePool& pool : m_pools)
+		{
+			while (SFreeBlock* pBlock = pool.m_pFreeBlocks)
+			{
+				pool.m_pFreeBlocks = pBlock->m_pNext;
+				CryModuleFree(pBlock);
+			}
+		}
+
+		m_poolStatistics.pooledCount = 0;
+	}
+
+
+	const SStatePoolStatistics& GetPoolStatistics() const { return m_poolStatistics; }
+
+
+	/** Outputs the pool statistics to the log. */
+	void LogPoolStatistics(const char* szName) const
+	{
+		CryLogAlways("HSM %s: %u heap allocations, %u reused, %u live, %u pooled.", szName,
+			m_poolStatistics.heapAllocationCount, m_poolStatistics.reuseCount, m_poolStatistics.liveCount, m_poolStatistics.pooledCount);
+	}
+
+private: // DO_NOT_IMPLEMENT!
+	CStateMachineRegistration(const CStateMachineRegistration&);
+	void operator=(const CStateMachineRegistration&);
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -408,6 +653,7 @@ struct SStateIndex
 		, m_parent(nullptr)
 		, m_stateID(UNDEFINED)
 		, m_hierarchy(UNDEFINED)
+		, m_subStateIndex(0)
 	{
 		DebugInit("UNDEFINED_NEED_TO_ADD_STATE_TO_HIERARCHY_BEFORE_TRANSITIONING_TO_IT");
 	}
@@ -418,6 +664,7 @@ struct SStateIndex
 		, m_parent(nullptr)
 		, m_stateID(0)
 		, m_hierarchy(0)
+		, m_subStateIndex(0)
 	{
 		DebugInit("UnknownHash");
 	}
@@ -428,6 +675,7 @@ struct SStateIndex
 		, m_parent(nullptr)
 		, m_stateID(0)
 		, m_hierarchy(0)
+		, m_subStateIndex(0)
 	{
 		DebugInit(pName);
 	}
@@ -438,6 +686,7 @@ struct SStateIndex
 		, m_parent(parent)
 		, m_stateID((1ULL << static_cast<uint64>(stateID)))
 		, m_hierarchy(0)
+		, m_subStateIndex(static_cast<uint8>(stateID))
 	{
 		DebugInit(pName);
 		RecursiveGenerateHierarchy(*this, m_hierarchy);
@@ -449,6 +698,7 @@ struct SStateIndex
 		, m_parent(rhs.m_parent)
 		, m_stateID(rhs.m_stateID)
 		, m_hierarchy(rhs.m_hierarchy)
+		, m_subStateIndex(rhs.m_subStateIndex)
 #ifdef STATE_DEBUG
 		, m_pDebugName(rhs.m_pDebugName)
 #endif
@@ -458,7 +708,7 @@ struct SStateIndex
 	bool operator!=(const SStateIndex& rhs) const { return(m_name != rhs.m_name); }
 	SStateIndex& operator=(const SStateIndex& rhs)
 	{
-		m_name = rhs.m_name; m_func = rhs.m_func; m_parent = rhs.m_parent;  m_stateID = rhs.m_stateID; m_hierarchy = rhs.m_hierarchy;
+		m_name = rhs.m_name; m_func = rhs.m_func; m_parent = rhs.m_parent;  m_stateID = rhs.m_stateID; m_hierarchy = rhs.m_hierarchy; m_subStateIndex = rhs.m_subStateIndex;
 #ifdef STATE_DEBUG
 		m_pDebugName = rhs.m_pDebugName;
 #endif
@@ -471,6 +721,9 @@ struct SStateIndex
 	uint64 m_hierarchy;
 	uint m_stateID;
 
+	/** Position of the sub state in it's hierarchy, and it's row in the dispatch table. Zero for the special states. */
+	uint8 m_subStateIndex;
+
 #ifdef STATE_DEBUG
 	const char* m_pDebugName;
 #endif
@@ -491,6 +744,163 @@ private:
 	}
 };
 
+//////////////////////////////////////////////////////////////////////////
+// StateDispatchTable
+
+/**
+Every instance of a state hierarchy class has the same shape, so the shape is flattened into one table per class the
+first time the class is constructed. Each sub state gets a row holding it's handler, it's ancestors from itself up to
+Root, and the common parent it shares with every other sub state. Walking an event up the hierarchy, entering and
+exiting sub states, and finding common parents are then loops over small arrays rather than recursion through the
+parent pointers.
+
+Row zero is left empty for the special states such as State_Done, which aren't part of any hierarchy.
+**/
+template<typename HOST>
+class CStateDispatchTable
+{
+public:
+	struct SSubState
+	{
+		SSubState()
+			: m_func(nullptr)
+			, m_stateID(0)
+			, m_chainStart(0)
+			, m_chainLength(0)
+			, m_parent(0)
+#ifdef STATE_DEBUG
+			, m_pDebugName(nullptr)
+#endif
+		{
+		}
+
+		typename CStateProxy<HOST>::StatePtr m_func;
+		uint64 m_stateID;
+		uint16 m_chainStart;
+		uint8 m_chainLength;
+		uint8 m_parent;
+#ifdef STATE_DEBUG
+		const char* m_pDebugName;
+#endif
+	};
+
+
+	CStateDispatchTable()
+		: m_count(0)
+		, m_isBuilt(false)
+#ifdef STATE_DEBUG
+		, m_pHierarchyName(nullptr)
+#endif
+	{
+	}
+
+
+	/**
+	Fills in the table from the sub states of a hierarchy. Only the first call does any work.
+
+	\param	stateIndices	 The sub states, as added by the DEFINE_STATE_CLASS_ADD macros.
+	\param	szHierarchyName Name of the hierarchy class, for decoding traces.
+
+	\return The table.
+	**/
+	template<typename TStateIndexContainer>
+	const CStateDispatchTable& Build(const TStateIndexContainer& stateIndices, const char* szHierarchyName)
+	{
+		if (m_isBuilt)
+			return *this;
+
+#ifdef STATE_DEBUG
+		m_pHierarchyName = szHierarchyName;
+#endif
+
+		m_count = 1;
+		for (uint i = 0; i < stateIndices.size(); ++i)
+			m_count = std::max(m_count, uint(stateIndices[i]->m_subStateIndex) + 1);
+
+		m_subStates.resize(m_count);
+		for (uint i = 0; i < stateIndices.size(); ++i)
+		{
+			const SStateIndex<HOST>& stateIndex = *stateIndices[i];
+			SSubState& subState = m_subStates[stateIndex.m_subStateIndex];
+			subState.m_func = stateIndex.m_func;
+			subState.m_stateID = stateIndex.m_stateID;
+			subState.m_parent = stateIndex.m_parent ? stateIndex.m_parent->m_subStateIndex : 0;
+#ifdef STATE_DEBUG
+			subState.m_pDebugName = stateIndex.m_pDebugName;
+#endif
+		}
+
+		// Ancestor chains, from the sub state itself up to Root.
+		for (uint i = 1; i < m_count; ++i)
+		{
+			m_subStates[i].m_chainStart = static_cast<uint16>(m_chains.size());
+			for (uint ancestor = i; ancestor != 0; ancestor = m_subStates[ancestor].m_parent)
+				m_chains.push_back(static_cast<uint8>(ancestor));
+			m_subStates[i].m_chainLength = static_cast<uint8>(m_chains.size() - m_subStates[i].m_chainStart);
+		}
+
+		// The common parent of two sub states is the first ancestor of one which is also an ancestor of the other.
+		m_commonParents.resize(m_count * m_count, 0);
+		for (uint first = 1; first < m_count; ++first)
+		{
+			for (uint second = 1; second < m_count; ++second)
+			{
+				const uint8* pFirstChain = GetChain(first);
+				const uint8* pSecondChain = GetChain(second);
+				const uint8* pSecondChainEnd = pSecondChain + m_subStates[second].m_chainLength;
+
+				for (uint i = 0; i < m_subStates[first].m_chainLength; ++i)
+				{
+					if (std::find(pSecondChain, pSecondChainEnd, pFirstChain[i]) != pSecondChainEnd)
+					{
+						m_commonParents[first * m_count + second] = pFirstChain[i];
+						break;
+					}
+				}
+			}
+		}
+
+		m_isBuilt = true;
+
+		return *this;
+	}
+
+
+	ILINE const SSubState& GetSubState(uint subStateIndex) const { return m_subStates[subStateIndex]; }
+
+
+	/** The ancestors of a sub state, starting with the sub state itself and ending with Root. */
+	ILINE const uint8* GetChain(uint subStateIndex) const { return m_chains.data() + m_subStates[subStateIndex].m_chainStart; }
+
+
+	/** The deepest sub state which is an ancestor of both, or zero if either is a special state. */
+	ILINE uint GetCommonParent(uint first, uint second) const { return m_commonParents[first * m_count + second]; }
+
+
+	/** Number of rows, including the empty row zero. */
+	uint GetCount() const { return m_count; }
+
+#ifdef STATE_DEBUG
+	const char* GetHierarchyName() const { return m_pHierarchyName; }
+
+
+	const char* GetSubStateName(uint subStateIndex) const
+	{
+		return ((subStateIndex > 0) && (subStateIndex < m_count) && m_subStates[subStateIndex].m_pDebugName) ? m_subStates[subStateIndex].m_pDebugName : "None";
+	}
+#endif
+
+private:
+	std::vector<SSubState> m_subStates;
+	std::vector<uint8> m_chains;
+	std::vector<uint8> m_commonParents;
+	uint m_count;
+	bool m_isBuilt;
+#ifdef STATE_DEBUG
+	const char* m_pHierarchyName;
+#endif
+};
+
 //////////////////////////////////////////////////////////////////////////
 // State
 
@@ -552,61 +962,56 @@ public:
 		}
 	}
 
-	static uint64 GenerateCommonParent(SStateIndex<HOST> stateCurrent, SStateIndex<HOST> stateCommon)
+	static uint64 GenerateCommonParent(const CStateDispatchTable<HOST>& table, const SStateIndex<HOST>& stateCurrent, const SStateIndex<HOST>& stateCommon)
 	{
-#ifdef STATE_DEBUG
-		SStateIndex<HOST> stateCurrentOriginal = stateCurrent;
-#endif
-
-		uint64 stateResult = stateCurrent.m_hierarchy & stateCommon.m_hierarchy;
-		if (stateResult != 0)
-		{
-			do
-			{
-				if ((stateResult & stateCurrent.m_stateID) == stateCurrent.m_stateID)
-				{
-					STATE_DEBUG_LOG(nullptr, "GenerateCommonParent: For: <%s> And: <%s> Is: <%s>", stateCurrentOriginal.m_pDebugName, stateCommon.m_pDebugName, stateCurrent.m_pDebugName);
+		const typename CStateDispatchTable<HOST>::SSubState& commonParent = table.GetSubState(table.GetCommonParent(stateCurrent.m_subStateIndex, stateCommon.m_subStateIndex));
 
-					return stateCurrent.m_stateID;
-				}
+		STATE_DEBUG_LOG(nullptr, "GenerateCommonParent: For: <%s> And: <%s> Is: <%s>", stateCurrent.m_pDebugName, stateCommon.m_pDebugName, commonParent.m_pDebugName);
 
-				if (stateCurrent.m_parent)
-				{
-					stateCurrent = *stateCurrent.m_parent;
-				}
-			} while (stateCurrent.m_parent != nullptr);
-		}
-		return stateCurrent.m_stateID;
+		return commonParent.m_stateID;
 	}
 
-	static void RecursiveToCommonReverse(HOST& host, SStateIndex<HOST> stateCurrent, const uint64 stateCommonID, STATE* pState, const SStateEvent& event)
+	/** Calls each sub state from just below the common parent down to the current sub state, parents first. */
+	static void RecursiveToCommonReverse(HOST& host, const SStateIndex<HOST>& stateCurrent, const uint64 stateCommonID, STATE* pState, const SStateEvent& event)
 	{
-		if (stateCurrent.m_stateID != stateCommonID)
+		const CStateDispatchTable<HOST>& table = *pState->m_pDispatchTable;
+		const uint8* pChain = table.GetChain(stateCurrent.m_subStateIndex);
+
+		uint chainEnd = 0;
+		const uint chainLength = table.GetSubState(stateCurrent.m_subStateIndex).m_chainLength;
+		while ((chainEnd < chainLength) && (table.GetSubState(pChain[chainEnd]).m_stateID != stateCommonID))
 		{
+			++chainEnd;
+		}
 
-			if (stateCurrent.m_parent)
-			{
-				RecursiveToCommonReverse(host, *stateCurrent.m_parent, stateCommonID, pState, event);
-			}
+		while (chainEnd > 0)
+		{
+			const typename CStateDispatchTable<HOST>::SSubState& subState = table.GetSubState(pChain[--chainEnd]);
 
-			STATE_DEBUG_LOG(pState, "RecursiveToCommonReverse: Name: <%s>", stateCurrent.m_pDebugName);
+			STATE_DEBUG_LOG(pState, "RecursiveToCommonReverse: Name: <%s>", subState.m_pDebugName);
 
-			CALL_SUBSTATE_FN(pState, stateCurrent)(host, STATE_DEBUG_RAW_EVENT_LOG(pState, STATE_DEBUG_EVENTONLY(stateCurrent.m_pDebugName, event)));
+			(pState->*subState.m_func)(host, STATE_DEBUG_RAW_EVENT_LOG(pState, STATE_DEBUG_EVENTONLY(pChain[chainEnd], event)));
 		}
 	}
 
-	static void RecursiveToCommon(HOST& host, SStateIndex<HOST> stateCurrent, const uint64 stateCommonID, STATE* pState, const SStateEvent& event)
+	/** Calls each sub state from the current sub state up to just below the common parent, stopping early if one returns State_Done. */
+	static void RecursiveToCommon(HOST& host, const SStateIndex<HOST>& stateCurrent, const uint64 stateCommonID, STATE* pState, const SStateEvent& event)
 	{
-		if (stateCurrent.m_stateID != stateCommonID)
+		const CStateDispatchTable<HOST>& table = *pState->m_pDispatchTable;
+		const uint8* pChain = table.GetChain(stateCurrent.m_subStateIndex);
+		const uint chainLength = table.GetSubState(stateCurrent.m_subStateIndex).m_chainLength;
+
+		for (uint i = 0; i < chainLength; ++i)
 		{
-			STATE_DEBUG_LOG(pState, "RecursiveToCommon: Name: <%s>", stateCurrent.m_pDebugName);
+			const typename CStateDispatchTable<HOST>::SSubState& subState = table.GetSubState(pChain[i]);
+			if (subState.m_stateID == stateCommonID)
+				break;
 
-			const SStateIndex<HOST> stateReturn = CALL_SUBSTATE_FN(pState, stateCurrent)(host, STATE_DEBUG_RAW_EVENT_LOG(pState, STATE_DEBUG_EVENTONLY(stateCurrent.m_pDebugName, event)));
+			STATE_DEBUG_LOG(pState, "RecursiveToCommon: Name: <%s>", subState.m_pDebugName);
 
-			if (stateCurrent.m_parent && stateReturn != pState->State_Done)
-			{
-				RecursiveToCommon(host, *stateCurrent.m_parent, stateCommonID, pState, event);
-			}
+			const SStateIndex<HOST> stateReturn = (pState->*subState.m_func)(host, STATE_DEBUG_RAW_EVENT_LOG(pState, STATE_DEBUG_EVENTONLY(pChain[i], event)));
+			if (stateReturn == pState->State_Done)
+				break;
 		}
 	}
 
@@ -614,11 +1019,13 @@ public:
 	{
 		STATE_DEBUG_LOG(pState, "HandleEvent: Name: <%s> Event: <%d>", pState->m_currentState.m_pDebugName, event.GetEventId());
 
-		typename STATE::TStateIndex currentState = pState->m_currentState;
+		// The table is static to the hierarchy class, so it stays valid even if a nested transition replaces pState.
+		const CStateDispatchTable<HOST>& table = *pState->m_pDispatchTable;
+		uint currentIndex = pState->m_currentState.m_subStateIndex;
 		typename STATE::TStateIndex stateResult = STATE_DONE;
-		if (commonID != currentState.m_stateID)
+		if (commonID != table.GetSubState(currentIndex).m_stateID)
 		{
-			stateResult = CALL_SUBSTATE_FN(pState, currentState)(host, event);
+			stateResult = (pState->*table.GetSubState(currentIndex).m_func)(host, event);
 		}
 
 		do
@@ -630,33 +1037,37 @@ public:
 				case STATE_DONE:
 					break;
 				case STATE_CONTINUE:
-					if (currentState.m_parent != nullptr && currentState.m_parent->m_stateID != commonID)
+				{
+					const uint parentIndex = table.GetSubState(currentIndex).m_parent;
+					if (parentIndex != 0 && table.GetSubState(parentIndex).m_stateID != commonID)
 					{
-						stateResult = CALL_SUBSTATE_PARENT_FN(pState, currentState)(host, event);
+						stateResult = (pState->*table.GetSubState(parentIndex).m_func)(host, event);
 
-						currentState = *currentState.m_parent;
+						currentIndex = parentIndex;
 					}
 					else
 					{
 						stateResult = STATE_DONE;
 					}
-					break;
+				}
+				break;
 				default:
 					if (pState->m_currentState != stateResult)
 					{
 						// transition to new sub state.
 						pState->TransitionFromCurrentToSubState(host, stateMachineReg, stateResult);
 
-						typename STATE::TStateIndex oldState = currentState;
+						const uint oldIndex = currentIndex;
 
 						// set the current state to the transitioned state
-						currentState = stateResult = pState->m_currentState;
+						stateResult = pState->m_currentState;
+						currentIndex = stateResult.m_subStateIndex;
 
 						// then call the new state with the event which caused the transition,
 						// unless it was a system event (e.g. STATE_ENTER)
 						if (event.GetEventId() >= STATE_EVENT_CUSTOM)
 						{
-							const uint64 commonParent = CStateHelper<HOST, CStateHierarchy<HOST> >::GenerateCommonParent(oldState, pState->m_currentState);
+							const uint64 commonParent = table.GetSubState(table.GetCommonParent(oldIndex, currentIndex)).m_stateID;
 
 							StateMachineHandleEventForState(host, stateMachineReg, pState, event, commonParent);
 						}
@@ -667,7 +1078,7 @@ public:
 					}
 					break;
 			}
-		} while (stateResult.m_name != STATE_DONE && (currentState.m_parent != nullptr || stateResult.m_func != nullptr));
+		} while (stateResult.m_name != STATE_DONE && (table.GetSubState(currentIndex).m_parent != 0 || stateResult.m_func != nullptr));
 
 		if (pState->m_pTransitionStateHierarchy)
 		{
@@ -676,15 +1087,12 @@ public:
 		}
 	}
 
-	static STATE* StateNew(HOST& host, CStateMachineRegistration<HOST>& stateMachineReg, int stateIndex)
+	static STATE* StateNew(HOST& host, CStateMachineRegistration<HOST>& stateMachineReg, int stateIndex, CStateTrace* pTrace)
 	{
 		STATE* pState = stateMachineReg.CreateState(stateIndex);
 
 		pState->m_currentState = pState->m_defaultState;
-
-#ifdef STATE_DEBUG
-		pState->m_historyDebug.Reset();
-#endif
+		pState->m_pTrace = pTrace;
 
 		return pState;
 	}
@@ -693,6 +1101,56 @@ public:
 	{
 		stateMachineReg.DeleteState(pState);
 	}
+
+	/**
+	Benchmark baseline. Walks an event up from the current sub state through the parent pointers, copying each
+	SStateIndex on the way, which is how events were dispatched before the dispatch tables. Stops at the first result
+	which isn't State_Continue.
+	**/
+	static void BenchmarkParentWalk(HOST& host, STATE* pState, const SStateEvent& event)
+	{
+		typename STATE::TStateIndex currentState = pState->m_currentState;
+		typename STATE::TStateIndex stateResult = CALL_SUBSTATE_FN(pState, currentState)(host, event);
+		while ((stateResult.m_name == STATE_CONTINUE) && (currentState.m_parent != nullptr))
+		{
+			stateResult = CALL_SUBSTATE_PARENT_FN(pState, currentState)(host, event);
+			currentState = *currentState.m_parent;
+		}
+	}
+
+	/** The same walk as BenchmarkParentWalk, through the dispatch table. */
+	static void BenchmarkTableWalk(HOST& host, STATE* pState, const SStateEvent& event)
+	{
+		const CStateDispatchTable<HOST>& table = *pState->m_pDispatchTable;
+		uint currentIndex = pState->m_currentState.m_subStateIndex;
+		typename STATE::TStateIndex stateResult = (pState->*table.GetSubState(currentIndex).m_func)(host, event);
+		while ((stateResult.m_name == STATE_CONTINUE) && ((currentIndex = table.GetSubState(currentIndex).m_parent) != 0))
+		{
+			stateResult = (pState->*table.GetSubState(currentIndex).m_func)(host, event);
+		}
+	}
+
+	/** Benchmark baseline. Finds a common parent by walking the parent pointers, as GenerateCommonParent used to. */
+	static uint64 BenchmarkCommonParentWalk(SStateIndex<HOST> stateCurrent, const SStateIndex<HOST>& stateCommon)
+	{
+		const uint64 stateResult = stateCurrent.m_hierarchy & stateCommon.m_hierarchy;
+		if (stateResult != 0)
+		{
+			do
+			{
+				if ((stateResult & stateCurrent.m_stateID) == stateCurrent.m_stateID)
+				{
+					return stateCurrent.m_stateID;
+				}
+
+				if (stateCurrent.m_parent)
+				{
+					stateCurrent = *stateCurrent.m_parent;
+				}
+			} while (stateCurrent.m_parent != nullptr);
+		}
+		return stateCurrent.m_stateID;
+	}
 };
 
 template<typename HOST>
@@ -715,7 +1173,7 @@ protected:
 	{
 		CRY_ASSERT(!m_pTransitionStateHierarchy);
 
-		m_pTransitionStateHierarchy = CStateHelper<HOST, CStateHierarchy<HOST> >::StateNew(host, m_stateMachineReg, stateTransition.m_name);
+		m_pTransitionStateHierarchy = CStateHelper<HOST, CStateHierarchy<HOST> >::StateNew(host, m_stateMachineReg, stateTransition.m_name, m_pTrace);
 		m_pendingTransitionStateEvent = event;
 	}
 
@@ -749,12 +1207,16 @@ protected:
 	const TStateIndex& m_defaultState;
 	CStateMachineRegistration<HOST>& m_stateMachineReg;
 
-	typedef std::vector<SStateIndex<HOST>*> TStateIndexContainer;
+	// Sub states are identified by a bit in a 64 bit hierarchy mask, so a fixed array always has room and constructing a
+	// hierarchy doesn't need to allocate.
+	typedef CryFixedArray<SStateIndex<HOST>*, 64> TStateIndexContainer;
 	TStateIndexContainer m_stateIndexContainer;
 
-#ifdef STATE_DEBUG
-	SHistory m_historyDebug;
-#endif
+	// Shared by every instance of the hierarchy class. Set once the sub states have been added.
+	const CStateDispatchTable<HOST>* m_pDispatchTable;
+
+	// Owned by the state machine, and handed on to each hierarchy it transitions to.
+	CStateTrace* m_pTrace;
 
 	CStateHierarchy(int stateID, const SStateIndex<HOST>& defaultState, CStateMachineRegistration<HOST>& stateMachineReg)
 		: State_Done(CryHash(STATE_DONE))
@@ -764,6 +1226,8 @@ protected:
 		, m_currentState(State_Done)
 		, m_defaultState(defaultState)
 		, m_stateMachineReg(stateMachineReg)
+		, m_pDispatchTable(nullptr)
+		, m_pTrace(nullptr)
 	{
 	}
 
@@ -772,10 +1236,6 @@ private:
 	void InitState(HOST& host)
 	{
 		STATE_DEBUG_LOG(this, "InitState: Name: <%s>", m_currentState.m_pDebugName);
-
-#ifdef STATE_DEBUG
-		m_historyDebug.Reset();
-#endif
 	}
 
 	void ReleaseState(HOST& host, CStateMachineRegistration<HOST>& stateMachineReg)
@@ -792,24 +1252,23 @@ private:
 	{
 		if ((m_currentState.m_stateID != stateID) || (m_currentState.m_hierarchy != stateHierarchy) || (m_currentState.m_name != stateName))
 		{
-			typename TStateIndexContainer::iterator it = m_stateIndexContainer.begin();
-			const typename TStateIndexContainer::const_iterator iEnd = m_stateIndexContainer.end();
-			for (; it != iEnd; ++it)
+			for (uint i = 0; i < m_stateIndexContainer.size(); ++i)
 			{
-				if ((*it)->m_stateID == stateID)
+				const TStateIndex* pStateIndex = m_stateIndexContainer[i];
+				if (pStateIndex->m_stateID == stateID)
 				{
-					if ((*it)->m_hierarchy != stateHierarchy)
+					if (pStateIndex->m_hierarchy != stateHierarchy)
 					{
 						CryLog("StateMachine: Failed to Serialize state as the hierarchy has changed!");
 						return false;
 					}
-					if ((*it)->m_name != stateName)
+					if (pStateIndex->m_name != stateName)
 					{
 						CryLog("StateMachine: Failed to Serialize state as the name has changed!");
 						return false;
 					}
 
-					TransitionFromCurrentToSubState(host, stateMachineReg, *(*it));
+					TransitionFromCurrentToSubState(host, stateMachineReg, *pStateIndex);
 					return true;
 				}
 			}
@@ -821,7 +1280,7 @@ private:
 	{
 		STATE_DEBUG_LOG(this, "TransitionFromCurrentToSubState: From: <%s> To: <%s>", m_currentState.m_pDebugName, toSubState.m_pDebugName);
 
-		const uint64 commonParent = CStateHelper<HOST, CStateHierarchy<HOST> >::GenerateCommonParent(m_currentState, toSubState);
+		const uint64 commonParent = CStateHelper<HOST, CStateHierarchy<HOST> >::GenerateCommonParent(*m_pDispatchTable, m_currentState, toSubState);
 
 		CStateHierarchy* pState = this;
 
@@ -831,7 +1290,7 @@ private:
 		m_currentState = toSubState;
 
 		CStateHelper<HOST, CStateHierarchy<HOST> >::RecursiveToCommonReverse(host, m_currentState, commonParent, pState, STATE_EVENT_INIT);
-		CStateHelper<HOST, CStateHierarchy<HOST> >::StateMachineHandleEventForState(host, stateMachineReg, pState, STATE_EVENT_ENTER, commonParent);
+		CStateHelper<HOST, CStateHierarchy<HOST> >::StateMachineHandleEventForState(host, stateMachineReg, pState, STATE_DEBUG_RAW_EVENT_LOG(pState, STATE_EVENT_ENTER), commonParent);
 	}
 
 	SStateEvent m_pendingTransitionStateEvent;
@@ -841,6 +1300,107 @@ private: // DO_NOT_IMPLEMENT!
 	void operator=(const CStateHierarchy&);
 };
 
+//////////////////////////////////////////////////////////////////////////
+// StateEventQueue
+
+/**
+Holds the events which arrive while a state machine is already handling one. The first MAX_NUM_PENDING_EVENTS events
+go in a fixed ring, so the usual case of an event or two being raised from inside a handler never touches the heap.
+Filling the ring is treated as a bug, but the events aren't lost: they spill into a vector which keeps it's capacity
+once it has grown, and are handed out after the ring, in the order they arrived.
+**/
+class CStateEventQueue
+{
+public:
+	CStateEventQueue()
+		: m_front(0)
+		, m_count(0)
+		, m_spillFront(0)
+	{
+	}
+
+
+	bool IsEmpty() const { return (m_count == 0) && (m_spillFront == m_spill.size()); }
+
+
+	void Push(const SStateEvent& event)
+	{
+		// Once anything has spilled, later events must spill too or they would overtake it.
+		if ((m_count < MAX_NUM_PENDING_EVENTS) && (m_spillFront == m_spill.size()))
+		{
+			m_events[(m_front + m_count) % MAX_NUM_PENDING_EVENTS] = event;
+			++m_count;
+		}
+		else
+		{
+			CRY_ASSERT_MESSAGE(false, "HSM: More than MAX_NUM_PENDING_EVENTS events were raised while handling an event. The extra events have spilled to the heap.");
+			m_spill.push_back(event);
+		}
+	}
+
+
+	/**
+	Takes the oldest event off the queue.
+
+	\param [out] event The event.
+
+	\return False if the queue was empty.
+	**/
+	bool Pop(SStateEvent& event)
+	{
+		if (m_count > 0)
+		{
+			event = m_events[m_front];
+			m_front = (m_front + 1) % MAX_NUM_PENDING_EVENTS;
+			--m_count;
+
+			return true;
+		}
+
+		if (m_spillFront < m_spill.size())
+		{
+			event = m_spill[m_spillFront++];
+
+			if (m_spillFront == m_spill.size())
+			{
+				// Keep the capacity for next time.
+				m_spill.clear();
+				m_spillFront = 0;
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+
+	/** Drops any queued events. Spill capacity is kept. */
+	void Clear()
+	{
+		m_front = 0;
+		m_count = 0;
+		m_spill.clear();
+		m_spillFront = 0;
+	}
+
+
+	/** Drops any queued events and frees the spill. */
+	void Free()
+	{
+		Clear();
+		stl::free_container(m_spill);
+	}
+
+private:
+	SStateEvent m_events[MAX_NUM_PENDING_EVENTS];
+	uint m_front;
+	uint m_count;
+
+	std::vector<SStateEvent> m_spill;
+	size_t m_spillFront;
+};
+
 //////////////////////////////////////////////////////////////////////////
 // StateMachine
 
@@ -858,7 +1418,7 @@ public:
 	void StateMachineInit(HOST& host, CStateMachineRegistration<HOST>& stateMachineReg)
 	{
 		CRY_ASSERT(!m_pCurrentStateHierarchy);
-		m_pCurrentStateHierarchy = STATE_HELPER::StateNew(host, stateMachineReg, STATE_FIRST);
+		m_pCurrentStateHierarchy = STATE_HELPER::StateNew(host, stateMachineReg, STATE_FIRST, &m_trace);
 
 		STATE_HELPER::StateInit(host, stateMachineReg, m_pCurrentStateHierarchy);
 	}
@@ -875,7 +1435,7 @@ public:
 			STATE_HELPER::StateRelease(host, stateMachineReg, m_pCurrentStateHierarchy);
 			STATE_HELPER::StateDelete(host, stateMachineReg, m_pCurrentStateHierarchy);
 		}
-		stl::free_container(m_pendingEvents);
+		m_pendingEvents.Free();
 	}
 
 	void StateMachineHandleEvent(HOST& host, CStateMachineRegistration<HOST>& stateMachineReg, const SStateEvent& event)
@@ -883,21 +1443,23 @@ public:
 		if (!m_processingEvent)
 		{
 			m_processingEvent = true;
+			m_trace.Record(m_pCurrentStateHierarchy->m_stateID, m_pCurrentStateHierarchy->m_currentState.m_subStateIndex, event.GetEventId());
 			STATE_HELPER::StateMachineHandleEventForState(host, stateMachineReg, m_pCurrentStateHierarchy, STATE_DEBUG_APPEND_EVENT(event), 0);
-			m_processingEvent = false;
 
-			while (!m_pendingEvents.empty())
+			// Events raised while handling these are queued behind them, so draining in a loop keeps them in order.
+			SStateEvent pendingEvent;
+			while (m_pendingEvents.Pop(pendingEvent))
 			{
-				const SStateEvent pendingEvent = m_pendingEvents.front();
-				m_pendingEvents.pop();
-				StateMachineHandleEvent(host, stateMachineReg, pendingEvent);
+				m_trace.Record(m_pCurrentStateHierarchy->m_stateID, m_pCurrentStateHierarchy->m_currentState.m_subStateIndex, pendingEvent.GetEventId());
+				STATE_HELPER::StateMachineHandleEventForState(host, stateMachineReg, m_pCurrentStateHierarchy, STATE_DEBUG_APPEND_EVENT(pendingEvent), 0);
 			}
+			m_processingEvent = false;
 		}
 		else
 		{
 			CRY_ASSERT(sizeof(event) == sizeof(SStateEvent));
 
-			m_pendingEvents.push(event);
+			m_pendingEvents.Push(event);
 		}
 	}
 
@@ -919,18 +1481,14 @@ public:
 
 			debugCtx.m_baseHorizontal += 10.0f;
 
-			for (int i = m_pCurrentStateHierarchy->m_historyDebug.GetFront(); i >= 0; --i)
+			// Newest first.
+			SStateTraceRecord records[40];
+			const uint recordCount = m_trace.CopyRecords(records, CRY_ARRAY_COUNT(records));
+			for (uint i = recordCount; i > 0; --i)
 			{
 				debugCtx.m_currentVertical += 15.0f;
 
-				IRenderAuxText::Draw2dLabel(debugCtx.m_baseHorizontal, debugCtx.m_currentVertical, 1.4f, white, false, "%s", m_pCurrentStateHierarchy->m_historyDebug.GetStateAt(i).c_str());
-			}
-
-			for (int i = m_pCurrentStateHierarchy->m_historyDebug.GetBack(); i > m_pCurrentStateHierarchy->m_historyDebug.GetFront(); --i)
-			{
-				debugCtx.m_currentVertical += 15.0f;
-
-				IRenderAuxText::Draw2dLabel(debugCtx.m_baseHorizontal, debugCtx.m_currentVertical, 1.4f, white, false, "%s", m_pCurrentStateHierarchy->m_historyDebug.GetStateAt(i).c_str());
+				IRenderAuxText::Draw2dLabel(debugCtx.m_baseHorizontal, debugCtx.m_currentVertical, 1.4f, white, false, "%s", FormatTraceRecord(stateMachineReg, records[i - 1]).c_str());
 			}
 
 			SStateEvent debugEvent(STATE_EVENT_DEBUG);
@@ -973,7 +1531,7 @@ public:
 						{
 							STATE_HELPER::StateDelete(host, stateMachineReg, m_pCurrentStateHierarchy->m_pTransitionStateHierarchy);
 						}
-						m_pCurrentStateHierarchy->m_pTransitionStateHierarchy = STATE_HELPER::StateNew(host, stateMachineReg, hierarchyID);
+						m_pCurrentStateHierarchy->m_pTransitionStateHierarchy = STATE_HELPER::StateNew(host, stateMachineReg, hierarchyID, &m_trace);
 						STATE_HELPER::StateTransition(host, stateMachineReg, m_pCurrentStateHierarchy);
 					}
 
@@ -1008,17 +1566,186 @@ public:
 			STATE_HELPER::StateDelete(host, stateMachineReg, m_pCurrentStateHierarchy->m_pTransitionStateHierarchy);
 		}
 
-		stl::free_container(m_pendingEvents);
+		m_pendingEvents.Clear();
 
 		// clear flags!
 		m_pCurrentStateHierarchy->m_flags.ClearAllFlags();
 
 		// We must correctly follow the transition rules to reset the state machine.
-		m_pCurrentStateHierarchy->m_pTransitionStateHierarchy = STATE_HELPER::StateNew(host, stateMachineReg, STATE_FIRST);
+		m_pCurrentStateHierarchy->m_pTransitionStateHierarchy = STATE_HELPER::StateNew(host, stateMachineReg, STATE_FIRST, &m_trace);
 
 		STATE_HELPER::StateTransition(host, stateMachineReg, m_pCurrentStateHierarchy);
 	}
 
+	/**
+	Times dispatching an event up from the current sub state, through the parent pointers and through the dispatch
+	table, and times finding the common parent of every pair of sub states both ways. The results are written to the
+	log. Events raised by the handlers are dropped and sub state transitions aren't taken, so each iteration dispatches
+	to the same sub states.
+
+	\param	event	   The event to dispatch.
+	\param	iterations Number of times to dispatch the event.
+	\param	szName	   Name of the state machine, for the log.
+	**/
+	void StateMachineBenchmarkDispatch(HOST& host, CStateMachineRegistration<HOST>& stateMachineReg, const SStateEvent& event, const uint iterations, const char* szName)
+	{
+		CRY_ASSERT(m_pCurrentStateHierarchy);
+
+		if (m_processingEvent)
+			return;
+
+		m_processingEvent = true;
+
+		auto timeDispatch = [this, &host, &stateMachineReg, &event, iterations](void(*walk)(HOST&, CStateHierarchy<HOST>*, const SStateEvent&))
+		{
+			const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+			for (uint i = 0; i < iterations; ++i)
+			{
+				walk(host, m_pCurrentStateHierarchy, event);
+				m_pendingEvents.Clear();
+
+				if (m_pCurrentStateHierarchy->m_pTransitionStateHierarchy)
+				{
+					STATE_HELPER::StateDelete(host, stateMachineReg, m_pCurrentStateHierarchy->m_pTransitionStateHierarchy);
+				}
+			}
+
+			return (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+		};
+
+		const float parentWalkTime = timeDispatch(&STATE_HELPER::BenchmarkParentWalk);
+		const float tableWalkTime = timeDispatch(&STATE_HELPER::BenchmarkTableWalk);
+
+		m_processingEvent = false;
+
+		const typename CStateHierarchy<HOST>::TStateIndexContainer& stateIndices = m_pCurrentStateHierarchy->m_stateIndexContainer;
+		const CStateDispatchTable<HOST>& table = *m_pCurrentStateHierarchy->m_pDispatchTable;
+		uint64 checksum[2] = {0, 0};
+
+		CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+		for (uint i = 0; i < iterations; ++i)
+		{
+			for (uint first = 0; first < stateIndices.size(); ++first)
+			{
+				for (uint second = 0; second < stateIndices.size(); ++second)
+				{
+					checksum[0] += STATE_HELPER::BenchmarkCommonParentWalk(*stateIndices[first], *stateIndices[second]);
+				}
+			}
+		}
+		const float parentCommonTime = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		startTime = gEnv->pTimer->GetAsyncTime();
+		for (uint i = 0; i < iterations; ++i)
+		{
+			for (uint first = 0; first < stateIndices.size(); ++first)
+			{
+				for (uint second = 0; second < stateIndices.size(); ++second)
+				{
+					checksum[1] += STATE_HELPER::GenerateCommonParent(table, *stateIndices[first], *stateIndices[second]);
+				}
+			}
+		}
+		const float tableCommonTime = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+
+		CryLogAlways("HSM %s dispatch benchmark, %u iterations: parent pointers %.3fms, dispatch table %.3fms", szName, iterations, parentWalkTime, tableWalkTime);
+		CryLogAlways("HSM %s common parent benchmark, %u iterations of %u pairs: parent pointers %.3fms, dispatch table %.3fms, %s", szName, iterations,
+			uint(stateIndices.size() * stateIndices.size()), parentCommonTime, tableCommonTime, checksum[0] == checksum[1] ? "results match" : "RESULTS DIFFER");
+	}
+
+	/** The id written into each trace record, usually the entity running the machine. */
+	void SetTraceOwnerId(uint32 ownerId) { m_trace.SetOwnerId(ownerId); }
+
+
+	const CStateTrace& GetTrace() const { return m_trace; }
+
+
+	/** Decodes the trace and writes it to the log, oldest first. */
+	void StateMachineLogTrace(CStateMachineRegistration<HOST>& stateMachineReg, const char* szName) const
+	{
+#ifdef STATE_DEBUG
+		std::vector<SStateTraceRecord> records(CStateTrace::CAPACITY);
+		records.resize(m_trace.CopyRecords(records.data(), CStateTrace::CAPACITY));
+
+		CryLogAlways("HSM %s trace, %u records:", szName, uint(records.size()));
+		for (const SStateTraceRecord& record : records)
+		{
+			CryLogAlways("  %s", FormatTraceRecord(stateMachineReg, record).c_str());
+		}
+#else
+		CryLogAlways("HSM %s: tracing is only available in builds with STATE_DEBUG.", szName);
+#endif
+	}
+
+
+	/**
+	Writes the trace to a binary file, for replaying or inspecting offline. The file holds a header, the raw records,
+	and the names of every hierarchy and sub state the records refer to:
+
+	"HSMT", uint32 version, uint32 record count, uint32 name count,
+	records,
+	names, each as int16 hierarchy ID, uint8 sub state index (zero for the hierarchy), uint8 length, characters.
+
+	\param	szFileName Name of the file to write.
+
+	\return True if the file was written.
+	**/
+	bool StateMachineExportTrace(CStateMachineRegistration<HOST>& stateMachineReg, const char* szFileName) const
+	{
+#ifdef STATE_DEBUG
+		std::vector<SStateTraceRecord> records(CStateTrace::CAPACITY);
+		records.resize(m_trace.CopyRecords(records.data(), CStateTrace::CAPACITY));
+
+		// Name every sub state of every hierarchy that appears in the trace.
+		std::vector<char> names;
+		std::vector<int> hierarchyIDs;
+		uint32 nameCount = 0;
+		for (const SStateTraceRecord& record : records)
+		{
+			if (std::find(hierarchyIDs.begin(), hierarchyIDs.end(), record.hierarchyID) != hierarchyIDs.end())
+				continue;
+
+			hierarchyIDs.push_back(record.hierarchyID);
+			if (const CStateDispatchTable<HOST>* pDispatchTable = stateMachineReg.GetDispatchTable(record.hierarchyID))
+			{
+				for (uint subStateIndex = 0; subStateIndex < pDispatchTable->GetCount(); ++subStateIndex)
+				{
+					const char* szSubStateName = (subStateIndex == 0) ? pDispatchTable->GetHierarchyName() : pDispatchTable->GetSubStateName(subStateIndex);
+					const uint8 length = static_cast<uint8>(std::min<size_t>(strlen(szSubStateName), 255));
+					const int16 hierarchyID = record.hierarchyID;
+
+					names.insert(names.end(), reinterpret_cast<const char*>(&hierarchyID), reinterpret_cast<const char*>(&hierarchyID) + sizeof(hierarchyID));
+					names.push_back(static_cast<char>(subStateIndex));
+					names.push_back(static_cast<char>(length));
+					names.insert(names.end(), szSubStateName, szSubStateName + length);
+					++nameCount;
+				}
+			}
+		}
+
+		FILE* pFile = gEnv->pCryPak->FOpen(szFileName, "wb");
+		if (!pFile)
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "HSM: Unable to open %s to export the trace.", szFileName);
+			return false;
+		}
+
+		const char magic[4] = {'H', 'S', 'M', 'T'};
+		const uint32 header[3] = {1, uint32(records.size()), nameCount};
+		gEnv->pCryPak->FWrite(magic, sizeof(magic), 1, pFile);
+		gEnv->pCryPak->FWrite(header, sizeof(header), 1, pFile);
+		if (!records.empty())
+			gEnv->pCryPak->FWrite(records.data(), sizeof(SStateTraceRecord), records.size(), pFile);
+		if (!names.empty())
+			gEnv->pCryPak->FWrite(names.data(), 1, names.size(), pFile);
+		gEnv->pCryPak->FClose(pFile);
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
 	bool StateMachineActiveFlag(int flag) const
 	{
 		CRY_ASSERT(m_pCurrentStateHierarchy);
@@ -1049,28 +1776,49 @@ public:
 
 private:
 
+#ifdef STATE_DEBUG
+	static CryFixedStringT<128> FormatTraceRecord(CStateMachineRegistration<HOST>& stateMachineReg, const SStateTraceRecord& record)
+	{
+		const CStateDispatchTable<HOST>* pDispatchTable = stateMachineReg.GetDispatchTable(record.hierarchyID);
+
+		CryFixedStringT<32> eventName;
+		if ((record.eventID > EVENT_NONE) && (record.eventID < STATE_EVENT_CUSTOM))
+		{
+			AUTOENUM_BUILDNAMEARRAY(events, eStateEvents);
+			eventName = events[record.eventID - 1];
+		}
+		else
+		{
+			eventName.Format("Custom %d", record.eventID);
+		}
+
+		CryFixedStringT<128> text;
+		text.Format("%x %.3f %u State: %s.%s; Event: %s", record.sequence, CTimeValue(record.frameTime).GetSeconds(), record.ownerId,
+			pDispatchTable ? pDispatchTable->GetHierarchyName() : "Unknown", pDispatchTable ? pDispatchTable->GetSubStateName(record.subStateIndex) : "Unknown",
+			eventName.c_str());
+
+		return text;
+	}
+#endif
+
 	CStateHierarchy<HOST>* m_pCurrentStateHierarchy;
 
-	typedef std::queue<SStateEvent> TEventQueue;
-	TEventQueue m_pendingEvents;
+	CStateEventQueue m_pendingEvents;
 	bool m_processingEvent;
+
+	CStateTrace m_trace;
 };
 
 #ifdef STATE_DEBUG
 template<typename HOST>
-const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pState, const char* stateName, SStateEvent stateEvent)
+const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pState, uint subStateIndex, SStateEvent stateEvent)
 {
 	SStateEvent event(stateEvent);
 	static SStateDebugContext debugContext(gEnv->pRenderer, gEnv->pAuxGeomRenderer);
 	event.AddDebugContext(debugContext);
-	if (stateEvent.GetEventId() < STATE_EVENT_CUSTOM)
-	{
-		AUTOENUM_BUILDNAMEARRAY(events, eStateEvents);
-		STATE_DEBUG_EVENT_LOG_TO_HISTORY(pState, state_white, "State: %s; Event: %s", stateName, events[stateEvent.GetEventId() - 1]);
-	}
-	else
+	if (pState->m_pTrace)
 	{
-		STATE_DEBUG_EVENT_LOG_TO_HISTORY(pState, state_white, "State: %s; Event: Custom", stateName);
+		pState->m_pTrace->Record(pState->m_stateID, subStateIndex, stateEvent.GetEventId());
 	}
 	return event;
 }
@@ -1083,6 +1831,9 @@ const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pS
 			static void RegisterState( CStateProxy<host>::CreateStatePtr createPtr, CStateProxy<host>::DeleteStatePtr deletePtr, uint stateID ); \
 			static void UnRegisterState( uint stateID ); \
 			void StateMachineHandleEvent##name( const SStateEvent& event ); \
+			void StateMachineBenchmarkDispatch##name( const SStateEvent& event, const uint iterations ); \
+			void StateMachineLogTrace##name(); \
+			bool StateMachineExportTrace##name( const char* szFileName ); \
 		private: \
 			CStateMachine<host> m_stateMachine##name; \
 			void StateMachineInit##name();\
@@ -1109,9 +1860,25 @@ const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pS
 			CRY_ASSERT( s_pStateMachineRegistration##name, ("HSM: Somehow the registration class is nullptr for the <%s> State Machine", #name) );\
 			m_stateMachine##name.StateMachineHandleEvent( *this, *s_pStateMachineRegistration##name, event ); \
 		}\
+		void host::StateMachineBenchmarkDispatch##name( const SStateEvent& event, const uint iterations ) \
+		{\
+			CRY_ASSERT( s_pStateMachineRegistration##name, ("HSM: Somehow the registration class is nullptr for the <%s> State Machine", #name) );\
+			m_stateMachine##name.StateMachineBenchmarkDispatch( *this, *s_pStateMachineRegistration##name, event, iterations, #name ); \
+		}\
+		void host::StateMachineLogTrace##name() \
+		{\
+			CRY_ASSERT( s_pStateMachineRegistration##name, ("HSM: Somehow the registration class is nullptr for the <%s> State Machine", #name) );\
+			m_stateMachine##name.StateMachineLogTrace( *s_pStateMachineRegistration##name, #name ); \
+		}\
+		bool host::StateMachineExportTrace##name( const char* szFileName ) \
+		{\
+			CRY_ASSERT( s_pStateMachineRegistration##name, ("HSM: Somehow the registration class is nullptr for the <%s> State Machine", #name) );\
+			return m_stateMachine##name.StateMachineExportTrace( *s_pStateMachineRegistration##name, szFileName ); \
+		}\
 		void host::StateMachineInit##name()\
 		{\
 			CRY_ASSERT( s_pStateMachineRegistration##name, ("HSM: Somehow the registration class is nullptr for the <%s> State Machine", #name) );\
+			m_stateMachine##name.SetTraceOwnerId( GetEntityId() );\
 			m_stateMachine##name.StateMachineInit( *this, *s_pStateMachineRegistration##name );\
 		}\
 		void host::StateMachineRelease##name()\
@@ -1139,6 +1906,7 @@ const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pS
 		private: \
 			friend class host; \
 			uint m_subStateIndex; \
+			static CStateDispatchTable<host> s_dispatchTable; \
 		public:\
 			stateClass( CStateMachineRegistration<host>& stateMachineReg ); \
 			static CStateHierarchy<host>* Create( CStateMachineRegistration<host>& stateMachineReg ); \
@@ -1158,8 +1926,9 @@ const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pS
 		DECLARE_STATE_CLASS_ADD( host, Root )
 
 #define DEFINE_STATE_CLASS_BEGIN( host, stateClass, stateId, defaultState )\
-		CStateHierarchy<host>* stateClass::Create( CStateMachineRegistration<host>& stateMachineReg ) { return new stateClass(stateMachineReg); } \
-		void					stateClass::Delete( CStateHierarchy<host>*& pState ) { SAFE_DELETE( pState ); } \
+		CStateDispatchTable<host> stateClass::s_dispatchTable; \
+		CStateHierarchy<host>* stateClass::Create( CStateMachineRegistration<host>& stateMachineReg ) { return new (stateMachineReg.AllocateStateMemory( stateId, sizeof(stateClass) )) stateClass(stateMachineReg); } \
+		void					stateClass::Delete( CStateHierarchy<host>*& pState ) { if( pState ) { pState->~CStateHierarchy<host>(); pState = nullptr; } } \
 		uint stateClass::Register() \
 		{ \
 			host::RegisterState( &stateClass::Create, &stateClass::Delete, stateId );\
@@ -1185,6 +1954,8 @@ const SStateEvent SStateDebugContext::StateDebugAndLog(CStateHierarchy<HOST>* pS
 			m_stateIndexContainer.push_back( &State_##stateDummy );
 
 #define DEFINE_STATE_CLASS_END( host, stateClass )\
+			m_pDispatchTable = &s_dispatchTable.Build( m_stateIndexContainer, #stateClass ); \
+			stateMachineReg.SetDispatchTable( m_stateID, m_pDispatchTable ); \
 		}\
 		uint id##host##stateClass = stateClass::Register();
 
@@ -0,0 +1,95 @@
+#include <StdAfx.h>
+
+#include "StateMachineBenchmark.h"
+
+
+namespace Chrysalis
+{
+DEFINE_STATE_MACHINE(CStateMachineBenchmark, Test);
+
+
+enum EStateBenchmarkStates
+{
+	STATE_BENCHMARK_ENTRY = STATE_FIRST,
+};
+
+
+enum EStateBenchmarkEvents
+{
+	STATE_BENCHMARK_EVENT_DISPATCH = STATE_EVENT_CUSTOM,
+};
+
+
+/** Shaped like the actor movement hierarchy, with a few branches so there are common parents to find. */
+class CStateBenchmarkEntry : private CStateHierarchy<CStateMachineBenchmark>
+{
+	DECLARE_STATE_CLASS_BEGIN(CStateMachineBenchmark, CStateBenchmarkEntry)
+	DECLARE_STATE_CLASS_ADD(CStateMachineBenchmark, Active);
+	DECLARE_STATE_CLASS_ADD(CStateMachineBenchmark, Moving);
+	DECLARE_STATE_CLASS_ADD(CStateMachineBenchmark, Ground);
+	DECLARE_STATE_CLASS_ADD(CStateMachineBenchmark, Walk);
+	DECLARE_STATE_CLASS_ADD(CStateMachineBenchmark, Fall);
+	DECLARE_STATE_CLASS_ADD(CStateMachineBenchmark, Idle);
+	DECLARE_STATE_CLASS_END(CStateMachineBenchmark);
+};
+
+
+DEFINE_STATE_CLASS_BEGIN(CStateMachineBenchmark, CStateBenchmarkEntry, STATE_BENCHMARK_ENTRY, Walk)
+DEFINE_STATE_CLASS_ADD(CStateMachineBenchmark, CStateBenchmarkEntry, Active, Root)
+DEFINE_STATE_CLASS_ADD(CStateMachineBenchmark, CStateBenchmarkEntry, Moving, Active)
+DEFINE_STATE_CLASS_ADD(CStateMachineBenchmark, CStateBenchmarkEntry, Ground, Moving)
+DEFINE_STATE_CLASS_ADD(CStateMachineBenchmark, CStateBenchmarkEntry, Walk, Ground)
+DEFINE_STATE_CLASS_ADD(CStateMachineBenchmark, CStateBenchmarkEntry, Fall, Moving)
+DEFINE_STATE_CLASS_ADD(CStateMachineBenchmark, CStateBenchmarkEntry, Idle, Active)
+DEFINE_STATE_CLASS_END(CStateMachineBenchmark, CStateBenchmarkEntry);
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Root(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Active(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Moving(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Ground(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Walk(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Fall(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+const CStateBenchmarkEntry::TStateIndex CStateBenchmarkEntry::Idle(CStateMachineBenchmark& stateMachineBenchmark, const SStateEvent& event)
+{
+	return State_Continue;
+}
+
+
+void CStateMachineBenchmark::Run(uint iterations)
+{
+	StateMachineInitTest();
+	StateMachineBenchmarkDispatchTest(SStateEvent(STATE_BENCHMARK_EVENT_DISPATCH), iterations);
+	StateMachineReleaseTest();
+}
+}
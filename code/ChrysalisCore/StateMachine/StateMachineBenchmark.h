@@ -0,0 +1,34 @@
+#pragma once
+
+#include <StateMachine/StateMachine.h>
+
+
+namespace Chrysalis
+{
+/**
+A host for a state machine which exists only to be benchmarked. It's hierarchy is about as deep as the actor movement
+hierarchy, but none of the handlers do anything besides passing events on to their parent, so it can be run over and
+over without touching the game.
+**/
+class CStateMachineBenchmark
+{
+	DECLARE_STATE_MACHINE(CStateMachineBenchmark, Test);
+
+public:
+	CStateMachineBenchmark() = default;
+	~CStateMachineBenchmark() = default;
+
+
+	/**
+	Starts the state machine, times dispatching an event through it against walking the parent pointers, and writes the
+	results to the log. The state machine is released again afterwards.
+
+	\param	iterations Number of times to dispatch the event.
+	**/
+	void Run(uint iterations);
+
+
+	/** The state machine isn't run by an entity, but it's trace wants one. */
+	EntityId GetEntityId() const { return INVALID_ENTITYID; }
+};
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+namespace Chrysalis
+{
+/**
+A hash map which keeps all of it's entries in one array and resolves collisions by linear probing, so a lookup is a
+hash, a multiply and usually a single cache line. Used for the caches keyed by path hashes, where the tree walk of a
+std::map was costing more than the work being saved.
+
+The hash is spread over the table with a Fibonacci multiply, so keys which are already hashes can use an identity
+hasher. Erasing shifts the following entries back rather than leaving tombstones, which keeps probe lengths short for
+tables that churn. This means erasing moves entries, so it invalidates iterators and pointers into the table.
+
+Keys and values must be default constructible, since empty slots hold default values.
+
+\tparam	Key		 The key type.
+\tparam	Value	 The value type.
+\tparam	Hash	 Hashes a key to a size_t.
+\tparam	KeyEqual Compares two keys for equality.
+**/
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class TFlatHashMap
+{
+public:
+	struct SEntry
+	{
+		Key key {};
+		Value value {};
+	};
+
+private:
+	struct SSlot
+	{
+		SEntry entry;
+		bool isOccupied {false};
+	};
+
+public:
+	/** Walks the occupied slots in table order. */
+	template<typename SlotType, typename EntryType>
+	class TIterator
+	{
+	public:
+		TIterator(SlotType* pSlot, SlotType* pEnd)
+			: m_pSlot(pSlot), m_pEnd(pEnd)
+		{
+			SkipEmpty();
+		}
+
+
+		EntryType& operator*() const { return m_pSlot->entry; }
+		EntryType* operator->() const { return &m_pSlot->entry; }
+
+
+		TIterator& operator++()
+		{
+			++m_pSlot;
+			SkipEmpty();
+
+			return *this;
+		}
+
+
+		bool operator==(const TIterator& rhs) const { return m_pSlot == rhs.m_pSlot; }
+		bool operator!=(const TIterator& rhs) const { return m_pSlot != rhs.m_pSlot; }
+
+	private:
+		void SkipEmpty()
+		{
+			while ((m_pSlot != m_pEnd) && !m_pSlot->isOccupied)
+				++m_pSlot;
+		}
+
+
+		SlotType* m_pSlot;
+		SlotType* m_pEnd;
+	};
+
+	typedef TIterator<SSlot, SEntry> iterator;
+	typedef TIterator<const SSlot, const SEntry> const_iterator;
+
+
+	iterator begin() { return iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+	iterator end() { return iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()); }
+	const_iterator begin() const { return const_iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+	const_iterator end() const { return const_iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()); }
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	/** Number of slots in the table. */
+	size_t capacity() const { return m_slots.size(); }
+
+
+	iterator find(const Key& key)
+	{
+		const size_t index = FindIndex(key);
+		return (index != npos) ? iterator(m_slots.data() + index, m_slots.data() + m_slots.size()) : end();
+	}
+
+
+	const_iterator find(const Key& key) const
+	{
+		const size_t index = FindIndex(key);
+		return (index != npos) ? const_iterator(m_slots.data() + index, m_slots.data() + m_slots.size()) : end();
+	}
+
+
+	/**
+	Finds the value for a key.
+
+	\param	key The key.
+
+	\return The value, or null if the key isn't in the map.
+	**/
+	Value* Find(const Key& key)
+	{
+		const size_t index = FindIndex(key);
+		return (index != npos) ? &m_slots [index].entry.value : nullptr;
+	}
+
+
+	const Value* Find(const Key& key) const
+	{
+		const size_t index = FindIndex(key);
+		return (index != npos) ? &m_slots [index].entry.value : nullptr;
+	}
+
+
+	/**
+	Adds a value for a key, unless the key is already in the map.
+
+	\param	key   The key.
+	\param	value The value.
+
+	\return The entry for the key, and whether it was added.
+	**/
+	std::pair<iterator, bool> insert(const Key& key, Value value)
+	{
+		bool isInserted;
+		const size_t index = FindOrInsertIndex(key, isInserted);
+		if (isInserted)
+			m_slots [index].entry.value = std::move(value);
+
+		return std::make_pair(iterator(m_slots.data() + index, m_slots.data() + m_slots.size()), isInserted);
+	}
+
+
+	/** The value for a key. A default value is added if the key isn't in the map. */
+	Value& operator[](const Key& key)
+	{
+		bool isInserted;
+		return m_slots [FindOrInsertIndex(key, isInserted)].entry.value;
+	}
+
+
+	/**
+	Removes a key and it's value.
+
+	\param	key The key.
+
+	\return The number of entries removed, zero or one.
+	**/
+	size_t erase(const Key& key)
+	{
+		size_t index = FindIndex(key);
+		if (index == npos)
+			return 0;
+
+		// Pull back any entries after this one in the probe run which would be found sooner here.
+		const size_t mask = m_slots.size() - 1;
+		for (size_t next = (index + 1) & mask; m_slots [next].isOccupied; next = (next + 1) & mask)
+		{
+			const size_t home = HomeIndex(m_slots [next].entry.key);
+			const bool isHomeBetween = (index <= next) ? ((index < home) && (home <= next)) : ((index < home) || (home <= next));
+			if (!isHomeBetween)
+			{
+				m_slots [index].entry = std::move(m_slots [next].entry);
+				index = next;
+			}
+		}
+
+		m_slots [index] = SSlot();
+		--m_size;
+
+		return 1;
+	}
+
+
+	/** Removes every entry. The slots are kept for reuse. */
+	void clear()
+	{
+		for (auto& slot : m_slots)
+			slot = SSlot();
+
+		m_size = 0;
+	}
+
+
+	/** Makes enough room for a number of entries without the table growing. */
+	void reserve(size_t count)
+	{
+		size_t capacity = minCapacity;
+		while (capacity * maxLoadDenominator < count * maxLoadNumerator)
+			capacity *= 2;
+
+		if (capacity > m_slots.size())
+			Rehash(capacity);
+	}
+
+
+	void GetMemoryUsage(ICrySizer* pSizer) const
+	{
+		pSizer->AddObject(m_slots.data(), m_slots.capacity() * sizeof(SSlot));
+	}
+
+private:
+	static const size_t npos {~size_t(0)};
+
+	/** The table starts at this many slots, and doubles from there. */
+	static const size_t minCapacity {16};
+
+	/** The table grows once it's more than this fraction full. */
+	static const size_t maxLoadNumerator {7};
+	static const size_t maxLoadDenominator {8};
+
+
+	size_t HomeIndex(const Key& key) const
+	{
+		return size_t((uint64(Hash()(key)) * 0x9E3779B97F4A7C15ull) >> m_shift);
+	}
+
+
+	size_t FindIndex(const Key& key) const
+	{
+		if (m_size == 0)
+			return npos;
+
+		const size_t mask = m_slots.size() - 1;
+		for (size_t index = HomeIndex(key); m_slots [index].isOccupied; index = (index + 1) & mask)
+		{
+			if (KeyEqual()(m_slots [index].entry.key, key))
+				return index;
+		}
+
+		return npos;
+	}
+
+
+	size_t FindOrInsertIndex(const Key& key, bool& isInserted)
+	{
+		isInserted = false;
+		const size_t index = FindIndex(key);
+		if (index != npos)
+			return index;
+
+		if ((m_size + 1) * maxLoadDenominator > m_slots.size() * maxLoadNumerator)
+			Rehash(m_slots.empty() ? minCapacity : m_slots.size() * 2);
+
+		const size_t mask = m_slots.size() - 1;
+		size_t freeIndex = HomeIndex(key);
+		while (m_slots [freeIndex].isOccupied)
+			freeIndex = (freeIndex + 1) & mask;
+
+		m_slots [freeIndex].entry.key = key;
+		m_slots [freeIndex].isOccupied = true;
+		++m_size;
+		isInserted = true;
+
+		return freeIndex;
+	}
+
+
+	void Rehash(size_t capacity)
+	{
+		std::vector<SSlot> oldSlots(capacity);
+		oldSlots.swap(m_slots);
+
+		m_shift = 64;
+		for (size_t slots = capacity; slots > 1; slots >>= 1)
+			--m_shift;
+
+		const size_t mask = capacity - 1;
+		for (auto& slot : oldSlots)
+		{
+			if (slot.isOccupied)
+			{
+				size_t index = HomeIndex(slot.entry.key);
+				while (m_slots [index].isOccupied)
+					index = (index + 1) & mask;
+
+				m_slots [index].entry = std::move(slot.entry);
+				m_slots [index].isOccupied = true;
+			}
+		}
+	}
+
+
+	/** The slots. The count is always zero or a power of two. */
+	std::vector<SSlot> m_slots;
+
+	/** Number of occupied slots. */
+	size_t m_size {0};
+
+	/** How far the multiplied hash is shifted down to give a slot index. */
+	uint32 m_shift {64};
+};
+}
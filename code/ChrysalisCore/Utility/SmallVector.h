@@ -0,0 +1,207 @@
+#pragma once
+
+namespace Chrysalis
+{
+/** The default allocation counter for a small vector, which doesn't count anything. */
+struct SNoAllocationCounter
+{
+	static void OnHeapAllocation() {}
+};
+
+
+/**
+A vector which keeps the first few elements inside itself, and only goes to the heap once it grows beyond that. Used
+for per-frame results which are nearly always small, so the steady state never touches the allocator.
+
+Clearing keeps the capacity, so a vector which has spilled onto the heap stays there and is reused.
+
+\tparam	Type			  The element type.
+\tparam	InlineCapacity	  Number of elements held inline.
+\tparam	AllocationCounter Told about each heap allocation through a static OnHeapAllocation(), so they can be counted.
+**/
+template<typename Type, size_t InlineCapacity, typename AllocationCounter = SNoAllocationCounter>
+class TSmallVector
+{
+public:
+	TSmallVector() = default;
+
+	~TSmallVector()
+	{
+		clear();
+		FreeHeap();
+	}
+
+
+	TSmallVector(const TSmallVector& rhs)
+	{
+		reserve(rhs.m_size);
+		for (size_t i = 0; i < rhs.m_size; ++i)
+			push_back(rhs[i]);
+	}
+
+
+	TSmallVector(TSmallVector&& rhs)
+	{
+		MoveFrom(rhs);
+	}
+
+
+	TSmallVector& operator=(const TSmallVector& rhs)
+	{
+		if (this != &rhs)
+		{
+			clear();
+			reserve(rhs.m_size);
+			for (size_t i = 0; i < rhs.m_size; ++i)
+				push_back(rhs[i]);
+		}
+
+		return *this;
+	}
+
+
+	TSmallVector& operator=(TSmallVector&& rhs)
+	{
+		if (this != &rhs)
+		{
+			clear();
+			FreeHeap();
+			MoveFrom(rhs);
+		}
+
+		return *this;
+	}
+
+
+	void push_back(const Type& value) { emplace_back(value); }
+	void push_back(Type&& value) { emplace_back(std::move(value)); }
+
+
+	template<typename... Args>
+	Type& emplace_back(Args&&... args)
+	{
+		if (m_size == m_capacity)
+			Grow(m_capacity * 2);
+
+		Type* pElement = new(m_pData + m_size) Type(std::forward<Args>(args)...);
+		++m_size;
+
+		return *pElement;
+	}
+
+
+	void pop_back()
+	{
+		CRY_ASSERT(m_size > 0);
+		m_pData[--m_size].~Type();
+	}
+
+
+	void clear()
+	{
+		for (size_t i = 0; i < m_size; ++i)
+			m_pData[i].~Type();
+
+		m_size = 0;
+	}
+
+
+	void reserve(size_t capacity)
+	{
+		if (capacity > m_capacity)
+			Grow(capacity);
+	}
+
+
+	Type* data() { return m_pData; }
+	const Type* data() const { return m_pData; }
+	size_t size() const { return m_size; }
+	size_t capacity() const { return m_capacity; }
+	bool empty() const { return m_size == 0; }
+
+	/** Are the elements still held inline? */
+	bool IsInline() const { return m_pData == InlineData(); }
+
+	Type* begin() { return m_pData; }
+	Type* end() { return m_pData + m_size; }
+	const Type* begin() const { return m_pData; }
+	const Type* end() const { return m_pData + m_size; }
+
+	Type& operator[](size_t index)
+	{
+		CRY_ASSERT(index < m_size);
+		return m_pData[index];
+	}
+
+	const Type& operator[](size_t index) const
+	{
+		CRY_ASSERT(index < m_size);
+		return m_pData[index];
+	}
+
+	Type& back() { return (*this)[m_size - 1]; }
+	const Type& back() const { return (*this)[m_size - 1]; }
+
+private:
+	Type* InlineData() { return reinterpret_cast<Type*>(m_inline); }
+	const Type* InlineData() const { return reinterpret_cast<const Type*>(m_inline); }
+
+
+	void Grow(size_t capacity)
+	{
+		capacity = std::max(capacity, InlineCapacity * 2);
+		Type* pData = static_cast<Type*>(CryModuleMalloc(sizeof(Type) * capacity));
+		AllocationCounter::OnHeapAllocation();
+
+		for (size_t i = 0; i < m_size; ++i)
+		{
+			new(pData + i) Type(std::move(m_pData[i]));
+			m_pData[i].~Type();
+		}
+
+		FreeHeap();
+		m_pData = pData;
+		m_capacity = capacity;
+	}
+
+
+	void FreeHeap()
+	{
+		if (!IsInline())
+			CryModuleFree(m_pData);
+
+		m_pData = InlineData();
+		m_capacity = InlineCapacity;
+	}
+
+
+	/** Takes the elements from another vector. We must be empty and inline. Heap storage is taken over without copying. */
+	void MoveFrom(TSmallVector& rhs)
+	{
+		if (rhs.IsInline())
+		{
+			for (size_t i = 0; i < rhs.m_size; ++i)
+				new(m_pData + i) Type(std::move(rhs.m_pData[i]));
+
+			m_size = rhs.m_size;
+			rhs.clear();
+		}
+		else
+		{
+			m_pData = rhs.m_pData;
+			m_size = rhs.m_size;
+			m_capacity = rhs.m_capacity;
+
+			rhs.m_pData = rhs.InlineData();
+			rhs.m_size = 0;
+			rhs.m_capacity = InlineCapacity;
+		}
+	}
+
+
+	alignas(Type) char m_inline[sizeof(Type) * InlineCapacity];
+	Type* m_pData {InlineData()};
+	size_t m_size {0};
+	size_t m_capacity {InlineCapacity};
+};
+}
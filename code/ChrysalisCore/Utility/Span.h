@@ -0,0 +1,51 @@
+#pragma once
+
+namespace Chrysalis
+{
+/**
+A non-owning view over a contiguous run of elements. It's only valid for as long as the storage it views is left
+alone, so hold onto it for no longer than the call that returned it.
+
+\tparam	Type The element type. Use a const type for a read only view.
+**/
+template<typename Type>
+class TSpan
+{
+public:
+	TSpan() = default;
+
+	TSpan(Type* pData, size_t size) :
+		m_pData(pData), m_size(size)
+	{
+	}
+
+
+	/** View any container which has contiguous storage e.g. a vector. */
+	template<typename Container>
+	TSpan(Container& container) :
+		m_pData(container.data()), m_size(container.size())
+	{
+	}
+
+
+	Type* data() const { return m_pData; }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	Type* begin() const { return m_pData; }
+	Type* end() const { return m_pData + m_size; }
+
+	Type& operator[](size_t index) const
+	{
+		CRY_ASSERT(index < m_size);
+		return m_pData[index];
+	}
+
+	Type& front() const { return (*this)[0]; }
+	Type& back() const { return (*this)[m_size - 1]; }
+
+private:
+	Type* m_pData {nullptr};
+	size_t m_size {0};
+};
+}